@@ -0,0 +1,58 @@
+#include "alloc.h"
+#include <string.h>
+
+/**
+  counts allocations by interposing malloc & friends. yrc is linked
+  statically into the benchmark, so every allocation the library makes
+  lands here. only glibc exposes the __libc_* entry points we forward to;
+  elsewhere the counters simply stay at zero.
+**/
+static bench_alloc_stats_t counters;
+
+#ifdef __GLIBC__
+extern void* __libc_malloc(size_t);
+extern void* __libc_calloc(size_t, size_t);
+extern void* __libc_realloc(void*, size_t);
+extern void __libc_free(void*);
+
+void* malloc(size_t size) {
+  ++counters.mallocs;
+  counters.bytes += size;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) {
+  ++counters.mallocs;
+  counters.bytes += num * size;
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  ++counters.reallocs;
+  counters.bytes += size;
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+  if (ptr) {
+    ++counters.frees;
+  }
+  __libc_free(ptr);
+}
+
+int bench_alloc_enabled(void) {
+  return 1;
+}
+#else
+int bench_alloc_enabled(void) {
+  return 0;
+}
+#endif
+
+void bench_alloc_reset(void) {
+  memset(&counters, 0, sizeof(counters));
+}
+
+void bench_alloc_snapshot(bench_alloc_stats_t* out) {
+  *out = counters;
+}
@@ -0,0 +1,17 @@
+#ifndef _YRC_BENCH_ALLOC_H
+#define _YRC_BENCH_ALLOC_H
+#include <stddef.h>
+
+typedef struct bench_alloc_stats_s {
+  size_t mallocs;
+  size_t reallocs;
+  size_t frees;
+  size_t bytes;
+} bench_alloc_stats_t;
+
+/* returns 0 if allocation counting isn't supported on this platform */
+int bench_alloc_enabled(void);
+void bench_alloc_reset(void);
+void bench_alloc_snapshot(bench_alloc_stats_t*);
+
+#endif
@@ -0,0 +1,102 @@
+#ifdef __linux__
+# define _GNU_SOURCE  /* syscall(), which no standard declares */
+#endif
+#include "counters.h"
+#include <string.h>
+
+/**
+  hardware counters around a measured stretch, through linux's
+  perf_event_open. only user-space work by this process is counted,
+  threads it starts along the way included, so tokenize-mt's workers
+  show up too. elsewhere -- or where the kernel won't hand the counters
+  out, as in most containers and VMs -- bench_counters_enabled is 0 and
+  the counts stay at zero.
+**/
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const uint64_t EVENTS[] = {
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+
+enum {
+  kEvents=sizeof(EVENTS) / sizeof(EVENTS[0])
+};
+
+static int fds[kEvents];
+static int opened;  /* 0 not yet tried, 1 open, -1 unavailable */
+
+static int open_counters(void) {
+  struct perf_event_attr attr;
+  size_t i;
+  for (i = 0; i < kEvents; ++i) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = EVENTS[i];
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fds[i] < 0) {
+      while (i--) {
+        close(fds[i]);
+      }
+      return -1;
+    }
+  }
+  return 1;
+}
+
+int bench_counters_enabled(void) {
+  if (opened == 0) {
+    opened = open_counters();
+  }
+  return opened > 0;
+}
+
+void bench_counters_start(void) {
+  size_t i;
+  if (!bench_counters_enabled()) {
+    return;
+  }
+  for (i = 0; i < kEvents; ++i) {
+    ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+void bench_counters_stop(bench_counters_t* out) {
+  uint64_t counts[kEvents];
+  size_t i;
+  memset(counts, 0, sizeof(counts));
+  if (bench_counters_enabled()) {
+    for (i = 0; i < kEvents; ++i) {
+      ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fds[i], &counts[i], sizeof(counts[i])) != sizeof(counts[i])) {
+        counts[i] = 0;
+      }
+    }
+  }
+  out->instructions = counts[0];
+  out->branches = counts[1];
+  out->branch_misses = counts[2];
+}
+#else
+int bench_counters_enabled(void) {
+  return 0;
+}
+
+void bench_counters_start(void) {
+}
+
+void bench_counters_stop(bench_counters_t* out) {
+  memset(out, 0, sizeof(*out));
+}
+#endif
@@ -0,0 +1,16 @@
+#ifndef _YRC_BENCH_COUNTERS_H
+#define _YRC_BENCH_COUNTERS_H
+#include <stdint.h>
+
+typedef struct bench_counters_s {
+  uint64_t instructions;
+  uint64_t branches;
+  uint64_t branch_misses;
+} bench_counters_t;
+
+/* returns 0 if hardware counters can't be read here */
+int bench_counters_enabled(void);
+void bench_counters_start(void);
+void bench_counters_stop(bench_counters_t*);
+
+#endif
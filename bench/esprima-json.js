@@ -0,0 +1,73 @@
+// the baseline for `yrc-bench --mode json`: JSON.stringify(esprima.parse())
+// with the positions yrc_ast_to_json writes. esprima.parse and
+// JSON.stringify are timed separately, to line up with yrc-bench's parse and
+// json modes; each is the median of --reps runs after --warmup, in MB/s of
+// source.
+//
+// usage: node bench/esprima-json.js [--reps N] [--warmup N] [file-or-dir ...]
+var esprima = require('esprima')
+var path = require('path')
+var fs = require('fs')
+
+var reps = 10
+var warmup = 2
+var inputs = []
+var argv = process.argv.slice(2)
+
+for (var i = 0; i < argv.length; ++i) {
+  if (argv[i] === '--reps') reps = +argv[++i]
+  else if (argv[i] === '--warmup') warmup = +argv[++i]
+  else inputs.push(argv[i])
+}
+if (!inputs.length) inputs.push(path.relative('.', path.join(__dirname, '..', 'corpus')))
+
+var files = []
+inputs.forEach(function (input) {
+  if (!fs.statSync(input).isDirectory()) return files.push(input)
+  fs.readdirSync(input).sort().forEach(function (name) {
+    if (/\.js$/.test(name)) files.push(path.join(input, name))
+  })
+})
+
+function seconds (start) {
+  var elapsed = process.hrtime(start)
+  return elapsed[0] + elapsed[1] / 1e9
+}
+
+function run (src, times) {
+  var start = process.hrtime()
+  var ast = esprima.parse(src, {range: true, loc: true})
+  times.parse.push(seconds(start))
+  start = process.hrtime()
+  JSON.stringify(ast)
+  times.json.push(seconds(start))
+}
+
+function median (times) {
+  times.sort(function (a, b) { return a - b })
+  return times[times.length >> 1]
+}
+
+console.log(pad('file', 28) + ' ' + pad('mode', 15) + ' ' + lpad('MB/s', 7))
+files.forEach(function (file) {
+  var src = fs.readFileSync(file, 'utf8')
+  var bytes = Buffer.byteLength(src)
+  var mb = bytes / (1024 * 1024)
+  var times = {parse: [], json: []}
+  for (var i = 0; i < warmup; ++i) run(src, {parse: [], json: []})
+  for (i = 0; i < reps; ++i) run(src, times)
+  ;['parse', 'json'].forEach(function (mode) {
+    console.log(pad(file, 28) + ' ' + pad('esprima-' + mode, 15) + ' ' +
+                lpad((mb / median(times[mode])).toFixed(2), 7))
+  })
+})
+
+function pad (str, len) {
+  while (str.length < len) str += ' '
+  return str
+}
+
+function lpad (str, len) {
+  while (str.length < len) str = ' ' + str
+  return str
+}
@@ -0,0 +1,116 @@
+#include "yrc.h"
+#include "alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+  allocation-counting benchmark for long comments & strings, which are
+  the inputs that stress yrc_str_t growth. every comment is longer than
+  the read chunk size so it has to be accumulated across reads.
+
+  usage: bench-long-comments [comment-bytes] [count]
+**/
+
+typedef struct membuf_s {
+  const char* data;
+  size_t size;
+  size_t pos;
+} membuf_t;
+
+static size_t readmem(char* data, size_t desired, void* ctx) {
+  membuf_t* buf = ctx;
+  size_t toread = buf->size - buf->pos;
+  if (toread > desired) {
+    toread = desired;
+  }
+  memcpy(data, buf->data + buf->pos, toread);
+  buf->pos += toread;
+  return toread;
+}
+
+static char* generate(size_t comment_bytes, size_t count, size_t* outsize) {
+  const char* stmt = "var s = \"";
+  size_t string_bytes = comment_bytes / 4;
+  size_t per = comment_bytes + string_bytes + 32;
+  char* out = malloc(per * count + 1);
+  char* ptr = out;
+  size_t i;
+  if (out == NULL) {
+    return NULL;
+  }
+  for (i = 0; i < count; ++i) {
+    memcpy(ptr, "/* ", 3);
+    ptr += 3;
+    memset(ptr, 'c', comment_bytes);
+    ptr += comment_bytes;
+    memcpy(ptr, " */\n", 4);
+    ptr += 4;
+    memcpy(ptr, stmt, strlen(stmt));
+    ptr += strlen(stmt);
+    memset(ptr, 's', string_bytes);
+    ptr += string_bytes;
+    memcpy(ptr, "\";\n", 3);
+    ptr += 3;
+  }
+  *ptr = '\0';
+  *outsize = ptr - out;
+  return out;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, const char** argv) {
+  size_t comment_bytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 1 << 20;
+  size_t count = argc > 2 ? strtoul(argv[2], NULL, 10) : 16;
+  bench_alloc_stats_t stats;
+  yrc_parse_response_t* resp;
+  yrc_parse_request_t req;
+  membuf_t buf;
+  double start, elapsed;
+  size_t allocs;
+
+  buf.data = generate(comment_bytes, count, &buf.size);
+  buf.pos = 0;
+  if (buf.data == NULL) {
+    fprintf(stderr, "could not allocate input\n");
+    return 1;
+  }
+
+  memset(&req, 0, sizeof(req));
+  req.read = readmem;
+  req.readsize = 16384;
+  req.readctx = &buf;
+
+  bench_alloc_reset();
+  start = now();
+  if (yrc_parse(&req, &resp)) {
+    fprintf(stderr, "parse failed\n");
+    yrc_parse_free(resp);
+    return 1;
+  }
+  elapsed = now() - start;
+  bench_alloc_snapshot(&stats);
+  yrc_parse_free(resp);
+
+  allocs = stats.mallocs + stats.reallocs;
+  printf("input:        %lu bytes (%lu comments of %lu bytes)\n",
+      (unsigned long)buf.size, (unsigned long)count, (unsigned long)comment_bytes);
+  printf("time:         %.3f ms (%.1f MB/s)\n",
+      elapsed * 1e3, buf.size / elapsed / (1024 * 1024));
+  if (!bench_alloc_enabled()) {
+    printf("allocations:  (not supported on this platform)\n");
+  } else {
+    printf("mallocs:      %lu\n", (unsigned long)stats.mallocs);
+    printf("reallocs:     %lu\n", (unsigned long)stats.reallocs);
+    printf("bytes:        %lu\n", (unsigned long)stats.bytes);
+    printf("allocs/KB:    %.3f\n", allocs / (buf.size / 1024.0));
+  }
+  free((void*)buf.data);
+  return 0;
+}
@@ -0,0 +1,853 @@
+#include "yrc.h"
+#include "tokenizer.h"
+#include "alloc.h"
+#include "counters.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/**
+  corpus benchmark. runs each input through the tokenizer alone, through
+  the parser, through parse + free, through loading + freeing its
+  serialized AST, through writing its tree out as ESTree JSON and through
+  printing it back out as minified javascript, without and with a source
+  map, through yrc_scan_dependencies and yrc_validate, through parse +
+  free again with the input pushed in by yrc_parser_feed, and through
+  yrc_tokenize_parallel, and reports throughput, allocation density and
+  peak RSS for each. load, json, codegen and sourcemap throughput are
+  measured against the source size, so they compare directly with
+  parse-free.
+
+  usage: yrc-bench [options] [file-or-dir ...]
+
+    --mode M      tokenize, parse, parse-free, load, json, codegen,
+                  sourcemap, deps, validate, feed, tokenize-mt or all
+                  (default: all)
+    --warmup N    untimed runs before measuring (default: 2)
+    --reps N      timed runs; the median is reported (default: 10)
+    --readsize N  bytes per read callback (default: 16384)
+    --threads N   for tokenize-mt, which always reads from memory
+                  (default: 0, one per cpu)
+    --prefetch    wrap the read callback with yrc_prefetch_read
+    --cold        re-read from disk each run, dropping the page cache
+                  for the file first (posix_fadvise, where available)
+    --json        one JSON object per line instead of a table
+    --stats       also print the parser's own counters for each file
+                  (needs a library built with -Dyrc_stats=1)
+    --counters    also report instructions and branch misses per byte
+                  over the timed runs (linux perf events, where the
+                  kernel allows them)
+
+  directories are searched (non-recursively) for *.js files. with no
+  inputs, ./corpus is used.
+**/
+
+typedef enum {
+  BENCH_TOKENIZE=1,
+  BENCH_PARSE=2,
+  BENCH_PARSE_FREE=4,
+  BENCH_LOAD=8,
+  BENCH_JSON=16,
+  BENCH_CODEGEN=32,
+  BENCH_SOURCEMAP=64,
+  BENCH_DEPS=128,
+  BENCH_VALIDATE=256,
+  BENCH_FEED=512,
+  BENCH_TOKENIZE_MT=1024,
+  BENCH_ALL=2047
+} bench_mode_t;
+
+typedef struct bench_opts_s {
+  int modes;
+  size_t warmup;
+  size_t reps;
+  size_t readsize;
+  size_t threads;
+  int prefetch;
+  int cold;
+  int json;
+  int stats;
+  int counters;
+} bench_opts_t;
+
+typedef struct bench_input_s {
+  const char* path;
+  char* data;
+  size_t size;
+  size_t pos;
+  FILE* fp;
+  void* blob;       /* yrc_ast_serialize output, for BENCH_LOAD */
+  size_t blob_size;
+  yrc_parse_response_t* tree;   /* kept for json, codegen and sourcemap */
+} bench_input_t;
+
+typedef struct bench_result_s {
+  const char* mode;
+  double median;
+  double best;
+  size_t tokens;
+  size_t nodes;
+  size_t allocs;
+  bench_counters_t counters;    /* summed over the timed runs */
+  long peak_rss_kb;
+} bench_result_t;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long peak_rss_kb(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    return -1;
+  }
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+static size_t readmem(char* data, size_t desired, void* ctx) {
+  bench_input_t* input = ctx;
+  size_t toread = input->size - input->pos;
+  if (toread > desired) {
+    toread = desired;
+  }
+  memcpy(data, input->data + input->pos, toread);
+  input->pos += toread;
+  return toread;
+}
+
+static size_t readfile(char* data, size_t desired, void* ctx) {
+  bench_input_t* input = ctx;
+  return fread(data, 1, desired, input->fp);
+}
+
+static int load(bench_input_t* input, const char* path) {
+  FILE* fp = fopen(path, "rb");
+  long size;
+  if (fp == NULL) {
+    return 1;
+  }
+  if (fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET)) {
+    fclose(fp);
+    return 1;
+  }
+  input->path = path;
+  input->size = size;
+  input->pos = 0;
+  input->fp = NULL;
+  input->blob = NULL;
+  input->blob_size = 0;
+  input->tree = NULL;
+  input->data = malloc(size ? size : 1);
+  if (input->data == NULL || fread(input->data, 1, size, fp) != (size_t)size) {
+    free(input->data);
+    fclose(fp);
+    return 1;
+  }
+  fclose(fp);
+  return 0;
+}
+
+/* position `input` at the start and pick the read callback to use */
+static int rewind_input(bench_input_t* input, bench_opts_t* opts, yrc_readcb* read) {
+  input->pos = 0;
+  *read = readmem;
+  if (!opts->cold) {
+    return 0;
+  }
+  if (input->fp) {
+    fclose(input->fp);
+  }
+  input->fp = fopen(input->path, "rb");
+  if (input->fp == NULL) {
+    return 1;
+  }
+#if defined(POSIX_FADV_DONTNEED)
+  posix_fadvise(fileno(input->fp), 0, 0, POSIX_FADV_DONTNEED);
+#endif
+  *read = readfile;
+  return 0;
+}
+
+/**
+  mirrors the parser's use of the tokenizer: whitespace and comments are
+  scanned but don't count as the previous token when deciding whether a
+  `/` starts a regexp.
+**/
+static int run_tokenize(bench_input_t* input, bench_opts_t* opts, size_t* tokens) {
+  yrc_tokenizer_t* tokenizer = NULL;
+  yrc_prefetch_t* prefetch = NULL;
+  yrc_token_t* prev = NULL;
+  yrc_token_t* token = NULL;
+  yrc_scan_allow_regexp mode;
+  yrc_readcb read;
+  void* ctx = input;
+  size_t count = 0;
+  int rc = 1;
+
+  if (rewind_input(input, opts, &read)) {
+    return 1;
+  }
+  if (opts->prefetch) {
+    if (yrc_prefetch_init(&prefetch, read, input, opts->readsize)) {
+      return 1;
+    }
+    read = yrc_prefetch_read;
+    ctx = prefetch;
+  }
+  if (yrc_tokenizer_init(&tokenizer, opts->readsize, ctx)) {
+    goto cleanup;
+  }
+  for (;;) {
+    if (yrc_tokenizer_scan(tokenizer, read, &token, YRC_ISNT_REGEXP)) {
+      goto cleanup;
+    }
+    if (token == NULL) {
+      break;
+    }
+    mode = yrc_tokenizer_regexp_mode(prev, token);
+    if (mode != YRC_ISNT_REGEXP &&
+        yrc_tokenizer_scan(tokenizer, read, &token, mode)) {
+      goto cleanup;
+    }
+    ++count;
+    if (token->type != YRC_TOKEN_WHITESPACE && token->type != YRC_TOKEN_COMMENT) {
+      prev = token;
+    }
+  }
+  *tokens = count;
+  rc = 0;
+
+cleanup:
+  if (tokenizer) {
+    yrc_tokenizer_free(tokenizer);
+  }
+  if (prefetch) {
+    yrc_prefetch_free(prefetch);
+  }
+  return rc;
+}
+
+static int count_dependency(yrc_dependency_kind kind, yrc_token_t* specifier, void* ctx) {
+  ++*(size_t*)ctx;
+  return 0;
+}
+
+static int count_token(yrc_token_t* token, void* ctx) {
+  ++*(size_t*)ctx;
+  return 0;
+}
+
+/* the whole buffer goes at once, so there's no reading to time */
+static int run_tokenize_mt(bench_input_t* input, bench_opts_t* opts) {
+  size_t count = 0;
+  return yrc_tokenize_parallel(input->data, input->size, opts->threads, count_token, &count);
+}
+
+/* the passes that build no tree: dependency scanning and validation */
+static int run_scan(bench_input_t* input, bench_opts_t* opts, bench_mode_t mode) {
+  yrc_prefetch_t* prefetch = NULL;
+  yrc_parse_request_t req;
+  yrc_error_t* error = NULL;
+  size_t count = 0;
+  int rc;
+
+  memset(&req, 0, sizeof(req));
+  if (rewind_input(input, opts, &req.read)) {
+    return 1;
+  }
+  req.readsize = opts->readsize;
+  req.readctx = input;
+  if (opts->prefetch) {
+    if (yrc_prefetch_init(&prefetch, req.read, input, opts->readsize)) {
+      return 1;
+    }
+    req.read = yrc_prefetch_read;
+    req.readctx = prefetch;
+  }
+  if (mode == BENCH_VALIDATE) {
+    rc = yrc_validate(&req, &error);
+    free(error);
+  } else {
+    rc = yrc_scan_dependencies(&req, count_dependency, &count);
+  }
+  if (prefetch) {
+    yrc_prefetch_free(prefetch);
+  }
+  return rc;
+}
+
+typedef struct count_visitor_s {
+  yrc_visitor_t visitor;
+  size_t count;
+} count_visitor_t;
+
+static yrc_visitor_mode count_node(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  ++((count_visitor_t*)ctx)->count;
+  return kYrcTraverseContinue;
+}
+
+/* `nodes` is optional: when set, the tree is counted (untimed) before freeing */
+static int run_parse(bench_input_t* input, bench_opts_t* opts, int do_free, yrc_parse_response_t** out, size_t* nodes) {
+  yrc_prefetch_t* prefetch = NULL;
+  yrc_parse_request_t req;
+  yrc_parse_response_t* resp = NULL;
+  count_visitor_t counter;
+  int rc;
+
+  memset(&req, 0, sizeof(req));
+  if (rewind_input(input, opts, &req.read)) {
+    return 1;
+  }
+  req.readsize = opts->readsize;
+  req.readctx = input;
+  if (opts->prefetch) {
+    if (yrc_prefetch_init(&prefetch, req.read, input, opts->readsize)) {
+      return 1;
+    }
+    req.read = yrc_prefetch_read;
+    req.readctx = prefetch;
+  }
+
+  rc = yrc_parse(&req, &resp);
+  if (rc == 0 && nodes) {
+    memset(&counter, 0, sizeof(counter));
+    counter.visitor.enter = count_node;
+    rc = yrc_traverse(resp->root, &counter.visitor);
+    *nodes = counter.count;
+  }
+  if (rc) {
+    yrc_parse_free(resp);
+    resp = NULL;
+  } else if (do_free) {
+    rc = yrc_parse_free(resp);
+    resp = NULL;
+  }
+  *out = resp;
+  if (prefetch) {
+    yrc_prefetch_free(prefetch);
+  }
+  return rc;
+}
+
+/* parse + free again, pushing each chunk read in with yrc_parser_feed */
+static int run_feed(bench_input_t* input, bench_opts_t* opts) {
+  yrc_parser_t* parser;
+  yrc_parse_request_t req;
+  yrc_parse_response_t* resp;
+  yrc_readcb read;
+  char* chunk;
+  size_t size;
+  int status;
+
+  memset(&req, 0, sizeof(req));
+  if (rewind_input(input, opts, &read)) {
+    return 1;
+  }
+  req.readsize = opts->readsize;
+  chunk = malloc(opts->readsize);
+  if (chunk == NULL || yrc_parser_init(&parser, &req, 0)) {
+    free(chunk);
+    return 1;
+  }
+  do {
+    size = read(chunk, opts->readsize, input);
+    status = yrc_parser_feed(parser, chunk, size);
+  } while (status == YRC_FEED_NEED_MORE);
+  if (status == YRC_FEED_DONE && yrc_parser_response(parser, &resp) == 0) {
+    yrc_parse_free(resp);
+  }
+  yrc_parser_free(parser);
+  free(chunk);
+  return status != YRC_FEED_DONE;
+}
+
+/* json, code and map output goes nowhere; only its size is kept */
+static int sink(const char* data, size_t size, void* ctx) {
+  (void)data;
+  *(size_t*)ctx += size;
+  return 0;
+}
+
+static int run_json(bench_input_t* input) {
+  static char buffer[65536];
+  yrc_output_t out;
+  size_t written = 0;
+  out.write = sink;
+  out.writectx = &written;
+  out.buffer = buffer;
+  out.buffersize = sizeof(buffer);
+  return yrc_ast_to_json(input->tree->root, &out, YRC_JSON_COMPACT);
+}
+
+static int run_codegen(bench_input_t* input, int sourcemap) {
+  static char buffer[65536];
+  static char map_buffer[65536];
+  yrc_output_t out;
+  yrc_output_t map;
+  size_t written = 0;
+  out.write = map.write = sink;
+  out.writectx = map.writectx = &written;
+  out.buffer = buffer;
+  out.buffersize = sizeof(buffer);
+  map.buffer = map_buffer;
+  map.buffersize = sizeof(map_buffer);
+  return yrc_codegen_map(input->tree->root, &out, sourcemap ? &map : NULL,
+                         input->path, YRC_CODEGEN_MINIFY);
+}
+
+static int run_once(bench_input_t* input, bench_opts_t* opts, bench_mode_t mode, double* elapsed) {
+  yrc_parse_response_t* resp = NULL;
+  size_t tokens;
+  double start = now();
+  int rc;
+
+  switch (mode) {
+    case BENCH_TOKENIZE:
+      rc = run_tokenize(input, opts, &tokens);
+      *elapsed = now() - start;
+      return rc;
+    case BENCH_PARSE:
+      rc = run_parse(input, opts, 0, &resp, NULL);
+      *elapsed = now() - start;
+      if (resp) {
+        yrc_parse_free(resp);
+      }
+      return rc;
+    case BENCH_LOAD:
+      rc = yrc_ast_deserialize(input->blob, input->blob_size, &resp);
+      if (rc == 0) {
+        rc = yrc_parse_free(resp);
+      }
+      *elapsed = now() - start;
+      return rc;
+    case BENCH_JSON:
+      rc = run_json(input);
+      *elapsed = now() - start;
+      return rc;
+    case BENCH_FEED:
+      rc = run_feed(input, opts);
+      *elapsed = now() - start;
+      return rc;
+    case BENCH_TOKENIZE_MT:
+      rc = run_tokenize_mt(input, opts);
+      *elapsed = now() - start;
+      return rc;
+    case BENCH_DEPS:
+    case BENCH_VALIDATE:
+      rc = run_scan(input, opts, mode);
+      *elapsed = now() - start;
+      return rc;
+    case BENCH_CODEGEN:
+    case BENCH_SOURCEMAP:
+      rc = run_codegen(input, mode == BENCH_SOURCEMAP);
+      *elapsed = now() - start;
+      return rc;
+    default:
+      rc = run_parse(input, opts, 1, &resp, NULL);
+      *elapsed = now() - start;
+      return rc;
+  }
+}
+
+static int compare_double(const void* lhs, const void* rhs) {
+  double a = *(const double*)lhs;
+  double b = *(const double*)rhs;
+  return a < b ? -1 : a > b;
+}
+
+static int measure(bench_input_t* input, bench_opts_t* opts, bench_mode_t mode, bench_result_t* result) {
+  bench_alloc_stats_t stats;
+  double* times;
+  double ignored;
+  size_t i;
+
+  for (i = 0; i < opts->warmup; ++i) {
+    if (run_once(input, opts, mode, &ignored)) {
+      return 1;
+    }
+  }
+
+  /* allocations are counted over a single extra run */
+  bench_alloc_reset();
+  if (run_once(input, opts, mode, &ignored)) {
+    return 1;
+  }
+  bench_alloc_snapshot(&stats);
+  result->allocs = stats.mallocs + stats.reallocs;
+
+  times = malloc(sizeof(*times) * opts->reps);
+  if (times == NULL) {
+    return 1;
+  }
+  if (opts->counters) {
+    bench_counters_start();
+  }
+  for (i = 0; i < opts->reps; ++i) {
+    if (run_once(input, opts, mode, &times[i])) {
+      free(times);
+      return 1;
+    }
+  }
+  if (opts->counters) {
+    bench_counters_stop(&result->counters);
+  }
+  qsort(times, opts->reps, sizeof(*times), compare_double);
+  result->best = times[0];
+  result->median = times[opts->reps / 2];
+  result->peak_rss_kb = peak_rss_kb();
+  free(times);
+  return 0;
+}
+
+static void report(bench_input_t* input, bench_opts_t* opts, bench_result_t* result) {
+  double mb = input->size / (1024.0 * 1024.0);
+  double kb = input->size / 1024.0;
+  double bytes = (double)input->size * opts->reps;
+  int counted = opts->counters && bench_counters_enabled() && bytes > 0;
+  if (opts->json) {
+    printf("{\"file\":\"%s\",\"mode\":\"%s\",\"bytes\":%lu,\"reps\":%lu,"
+           "\"median_s\":%.9f,\"best_s\":%.9f,\"mb_per_s\":%.3f,"
+           "\"tokens\":%lu,\"tokens_per_s\":%.1f,\"nodes\":%lu,\"nodes_per_s\":%.1f,"
+           "\"allocs\":%lu,\"allocs_per_kb\":%.4f,\"peak_rss_kb\":%ld,"
+           "\"prefetch\":%s,\"cold\":%s",
+        input->path, result->mode, (unsigned long)input->size, (unsigned long)opts->reps,
+        result->median, result->best, mb / result->median,
+        (unsigned long)result->tokens, result->tokens / result->median,
+        (unsigned long)result->nodes, result->nodes / result->median,
+        (unsigned long)result->allocs,
+        bench_alloc_enabled() && kb > 0 ? result->allocs / kb : -1.0,
+        result->peak_rss_kb,
+        opts->prefetch ? "true" : "false",
+        opts->cold ? "true" : "false");
+    if (opts->counters) {
+      printf(",\"instructions_per_byte\":%.4f,\"branch_misses_per_byte\":%.6f",
+          counted ? result->counters.instructions / bytes : -1.0,
+          counted ? result->counters.branch_misses / bytes : -1.0);
+    }
+    printf("}\n");
+    return;
+  }
+  printf("%-28s %-11s %9.2f %13.0f %13.0f ",
+      input->path, result->mode, mb / result->median,
+      result->tokens / result->median, result->nodes / result->median);
+  if (bench_alloc_enabled() && kb > 0) {
+    printf("%10.3f ", result->allocs / kb);
+  } else {
+    printf("%10s ", "n/a");
+  }
+  printf("%10ld", result->peak_rss_kb);
+  if (opts->counters && counted) {
+    printf(" %8.2f %10.3f", result->counters.instructions / bytes,
+        result->counters.branch_misses / (bytes / 1024.0));
+  } else if (opts->counters) {
+    printf(" %8s %10s", "n/a", "n/a");
+  }
+  printf("\n");
+}
+
+static const char* TOKEN_TYPE_NAMES[] = {
+#define XX(a, b) #b,
+  YRC_TOKEN_TYPES(XX)
+#undef XX
+};
+
+static const char* NODE_KIND_NAMES[] = {
+  "NULL",
+#define XX(a) #a,
+  YRC_AST_TYPE_MAP(XX)
+#undef XX
+};
+
+static void report_stats(bench_input_t* input, yrc_parse_stats_t* stats) {
+  size_t i;
+  int first = 1;
+  printf("{\"file\":\"%s\",\"stats\":{\"tokens\":{", input->path);
+  for (i = 0; i < YRC_TOKEN_EOF; ++i) {
+    printf("%s\"%s\":%lu", i ? "," : "", TOKEN_TYPE_NAMES[i], (unsigned long)stats->tokens[i]);
+  }
+  printf("},\"nodes\":{");
+  for (i = 0; i < YRC_AST_LAST; ++i) {
+    if (stats->nodes[i] == 0) {
+      continue;
+    }
+    printf("%s\"%s\":%lu", first ? "" : ",", NODE_KIND_NAMES[i], (unsigned long)stats->nodes[i]);
+    first = 0;
+  }
+  printf("},\"read_calls\":%lu,\"read_bytes\":%lu,\"token_arenas\":%lu,"
+         "\"node_arenas\":%lu,\"node_bytes\":%lu,\"externalized\":%lu,\"max_depth\":%lu,"
+         "\"scan_ns\":%lu,\"parse_ns\":%lu}}\n",
+      (unsigned long)stats->read_calls, (unsigned long)stats->read_bytes,
+      (unsigned long)stats->token_arenas, (unsigned long)stats->node_arenas,
+      (unsigned long)stats->node_bytes,
+      (unsigned long)stats->externalized, (unsigned long)stats->max_depth,
+      (unsigned long)stats->scan_ns, (unsigned long)stats->parse_ns);
+}
+
+static int bench_file(const char* path, bench_opts_t* opts) {
+  static const struct {
+    bench_mode_t mode;
+    const char* name;
+  } modes[] = {
+    {BENCH_TOKENIZE, "tokenize"},
+    {BENCH_PARSE, "parse"},
+    {BENCH_PARSE_FREE, "parse-free"},
+    {BENCH_LOAD, "load"},
+    {BENCH_JSON, "json"},
+    {BENCH_CODEGEN, "codegen"},
+    {BENCH_SOURCEMAP, "sourcemap"},
+    {BENCH_DEPS, "deps"},
+    {BENCH_VALIDATE, "validate"},
+    {BENCH_FEED, "feed"},
+    {BENCH_TOKENIZE_MT, "tokenize-mt"}
+  };
+  yrc_parse_response_t* resp = NULL;
+  bench_input_t input;
+  bench_result_t result;
+  bench_opts_t warm = *opts;
+  size_t tokens = 0;
+  size_t nodes = 0;
+  size_t i;
+  int rc = 0;
+
+  if (load(&input, path)) {
+    fprintf(stderr, "could not read %s\n", path);
+    return 1;
+  }
+
+  /* token and node counts (and the blob) come from one untimed, uncached pass */
+  warm.cold = 0;
+  if (run_tokenize(&input, &warm, &tokens) ||
+      run_parse(&input, &warm, 0, &resp, &nodes) ||
+      yrc_ast_serialize(resp->root, &input.blob, &input.blob_size)) {
+    fprintf(stderr, "could not parse %s\n", path);
+    if (resp) {
+      yrc_parse_free(resp);
+    }
+    free(input.data);
+    return 1;
+  }
+  if (opts->stats) {
+    if (resp->stats) {
+      report_stats(&input, resp->stats);
+    } else {
+      fprintf(stderr, "--stats: yrc was built without YRC_STATS\n");
+    }
+  }
+  if (opts->modes & (BENCH_JSON | BENCH_CODEGEN | BENCH_SOURCEMAP)) {
+    input.tree = resp;
+  } else {
+    yrc_parse_free(resp);
+  }
+
+  for (i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+    if (!(opts->modes & modes[i].mode)) {
+      continue;
+    }
+    memset(&result, 0, sizeof(result));
+    result.mode = modes[i].name;
+    result.tokens = tokens;
+    result.nodes = nodes;
+    if (measure(&input, opts, modes[i].mode, &result)) {
+      fprintf(stderr, "%s failed on %s\n", modes[i].name, path);
+      rc = 1;
+      break;
+    }
+    report(&input, opts, &result);
+  }
+  if (input.fp) {
+    fclose(input.fp);
+  }
+  if (input.tree) {
+    yrc_parse_free(input.tree);
+  }
+  free(input.blob);
+  free(input.data);
+  return rc;
+}
+
+static int has_suffix(const char* str, const char* suffix) {
+  size_t len = strlen(str);
+  size_t slen = strlen(suffix);
+  return len >= slen && strcmp(str + len - slen, suffix) == 0;
+}
+
+static int compare_str(const void* lhs, const void* rhs) {
+  return strcmp(*(char* const*)lhs, *(char* const*)rhs);
+}
+
+/* bench every *.js file in `dir`, in name order so runs are comparable */
+static int bench_dir(const char* dir, bench_opts_t* opts) {
+  DIR* dp = opendir(dir);
+  struct dirent* ent;
+  char** paths = NULL;
+  char** grown;
+  size_t count = 0;
+  size_t cap = 0;
+  size_t i;
+  int rc = 0;
+
+  if (dp == NULL) {
+    fprintf(stderr, "could not open %s\n", dir);
+    return 1;
+  }
+  while ((ent = readdir(dp)) != NULL) {
+    if (!has_suffix(ent->d_name, ".js")) {
+      continue;
+    }
+    if (count == cap) {
+      cap = cap ? cap * 2 : 16;
+      grown = realloc(paths, sizeof(*paths) * cap);
+      if (grown == NULL) {
+        rc = 1;
+        break;
+      }
+      paths = grown;
+    }
+    paths[count] = malloc(strlen(dir) + strlen(ent->d_name) + 2);
+    if (paths[count] == NULL) {
+      rc = 1;
+      break;
+    }
+    sprintf(paths[count], "%s/%s", dir, ent->d_name);
+    ++count;
+  }
+  closedir(dp);
+
+  if (paths) {
+    qsort(paths, count, sizeof(*paths), compare_str);
+  }
+  for (i = 0; i < count; ++i) {
+    rc = rc || bench_file(paths[i], opts);
+    free(paths[i]);
+  }
+  free(paths);
+  return rc;
+}
+
+static int bench_path(const char* path, bench_opts_t* opts) {
+  struct stat st;
+  if (stat(path, &st)) {
+    fprintf(stderr, "could not stat %s\n", path);
+    return 1;
+  }
+  return S_ISDIR(st.st_mode) ? bench_dir(path, opts) : bench_file(path, opts);
+}
+
+static int usage(const char* name) {
+  fprintf(stderr,
+      "usage: %s [--mode tokenize|parse|parse-free|load|json|codegen|sourcemap|deps|validate|feed|tokenize-mt|all]\n"
+      "       [--warmup N] [--reps N] [--readsize N] [--threads N] [--prefetch] [--cold]\n"
+      "       [--json] [--stats] [--counters]\n"
+      "       [file-or-dir ...]\n", name);
+  return 1;
+}
+
+int main(int argc, const char** argv) {
+  bench_opts_t opts;
+  int inputs = 0;
+  int rc = 0;
+  int i;
+
+  opts.modes = BENCH_ALL;
+  opts.warmup = 2;
+  opts.reps = 10;
+  opts.readsize = 16384;
+  opts.threads = 0;
+  opts.prefetch = 0;
+  opts.cold = 0;
+  opts.json = 0;
+  opts.stats = 0;
+  opts.counters = 0;
+
+  for (i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--json") == 0) {
+      opts.json = 1;
+    } else if (strcmp(argv[i], "--prefetch") == 0) {
+      opts.prefetch = 1;
+    } else if (strcmp(argv[i], "--cold") == 0) {
+      opts.cold = 1;
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      opts.stats = 1;
+    } else if (strcmp(argv[i], "--counters") == 0) {
+      opts.counters = 1;
+    } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+      opts.warmup = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+      opts.reps = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--readsize") == 0 && i + 1 < argc) {
+      opts.readsize = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      opts.threads = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+      ++i;
+      if (strcmp(argv[i], "tokenize") == 0) {
+        opts.modes = BENCH_TOKENIZE;
+      } else if (strcmp(argv[i], "parse") == 0) {
+        opts.modes = BENCH_PARSE;
+      } else if (strcmp(argv[i], "parse-free") == 0) {
+        opts.modes = BENCH_PARSE_FREE;
+      } else if (strcmp(argv[i], "load") == 0) {
+        opts.modes = BENCH_LOAD;
+      } else if (strcmp(argv[i], "json") == 0) {
+        opts.modes = BENCH_JSON;
+      } else if (strcmp(argv[i], "codegen") == 0) {
+        opts.modes = BENCH_CODEGEN;
+      } else if (strcmp(argv[i], "sourcemap") == 0) {
+        opts.modes = BENCH_SOURCEMAP;
+      } else if (strcmp(argv[i], "deps") == 0) {
+        opts.modes = BENCH_DEPS;
+      } else if (strcmp(argv[i], "validate") == 0) {
+        opts.modes = BENCH_VALIDATE;
+      } else if (strcmp(argv[i], "feed") == 0) {
+        opts.modes = BENCH_FEED;
+      } else if (strcmp(argv[i], "tokenize-mt") == 0) {
+        opts.modes = BENCH_TOKENIZE_MT;
+      } else if (strcmp(argv[i], "all") == 0) {
+        opts.modes = BENCH_ALL;
+      } else {
+        return usage(argv[0]);
+      }
+    } else if (strncmp(argv[i], "--", 2) == 0) {
+      return usage(argv[0]);
+    }
+  }
+  if (opts.reps == 0 || opts.readsize == 0) {
+    return usage(argv[0]);
+  }
+
+  if (!opts.json) {
+    printf("%-28s %-11s %9s %13s %13s %10s %10s",
+        "file", "mode", "MB/s", "tokens/s", "nodes/s", "allocs/KB", "rss KB");
+    if (opts.counters) {
+      printf(" %8s %10s", "insns/B", "brmiss/KB");
+    }
+    printf("\n");
+  }
+  for (i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--", 2) == 0) {
+      if (strcmp(argv[i], "--mode") == 0 || strcmp(argv[i], "--warmup") == 0 ||
+          strcmp(argv[i], "--reps") == 0 || strcmp(argv[i], "--readsize") == 0 ||
+          strcmp(argv[i], "--threads") == 0) {
+        ++i;
+      }
+      continue;
+    }
+    ++inputs;
+    rc = bench_path(argv[i], &opts) || rc;
+  }
+  if (inputs == 0) {
+    rc = bench_dir("corpus", &opts);
+  }
+  return rc;
+}
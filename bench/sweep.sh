@@ -0,0 +1,23 @@
+#!/bin/sh
+# sweep generated inputs of growing size through yrc-bench, one process per
+# input so peak RSS is per-input. prints yrc-bench's JSON lines to stdout.
+#
+# usage: bench/sweep.sh [build-dir] [sizes...]
+#   build-dir defaults to out/Release; sizes default to 256k..64m
+set -e
+OUT=${1:-out/Release}
+[ $# -gt 0 ] && shift
+SIZES=${*:-256k 1m 4m 16m 64m}
+SHAPES=${SHAPES:-nesting comma array strings functions minified}
+REPS=${REPS:-3}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+for shape in $SHAPES; do
+  for size in $SIZES; do
+    file="$TMP/$shape-$size.js"
+    "$OUT/gen-corpus" --shape "$shape" --size "$size" -o "$file"
+    "$OUT/yrc-bench" --json --warmup 1 --reps "$REPS" "$file" ||
+      echo "{\"file\":\"$file\",\"error\":true}"
+  done
+done
@@ -32,21 +32,266 @@ extern "C" {
 #include "yrc_tokens.h"
 #include "yrc_ast.h"
 #include "yrc_str.h"
+#include "yrc_traverse.h"
 
 typedef size_t (*yrc_readcb)(char*, size_t, void*);
+typedef int (*yrc_stmtcb)(yrc_ast_node_t*, void*);
+
+/**
+  if `statement` is set, the parse is streamed: each top-level statement
+  is handed to it as soon as it completes, after which its nodes and
+  tokens are recycled. the response root is then a PROGRAM with an empty
+  body. return non-zero from the callback to abort the parse.
+
+  set `incremental` to keep the extent of every statement, which
+  yrc_reparse needs. it has no effect on a streamed parse.
+
+  `budget` and `deadline` bound the work a parse may do. a parse fails
+  with YRC_EBUDGET once it has scanned `budget` tokens (comments and
+  whitespace count) or, checked every `budget` or so tokens, once
+  yrc_now() passes `deadline`. 0 means no limit. fed parses (see
+  yrc_parser_feed) yield at each spent budget instead of failing.
+
+  input is UTF-8, and fails to scan where it isn't. identifiers may use
+  any ID_Start/ID_Continue character.
+**/
 typedef struct yrc_parse_request_s {
   yrc_readcb      read;
   size_t          readsize;
   void*           readctx;
+  yrc_stmtcb      statement;
+  void*           statementctx;
+  int             incremental;
+  size_t          budget;
+  uint64_t        deadline;
 } yrc_parse_request_t;
 
+/* nanoseconds on a monotonic clock, for `deadline` */
+YRC_EXTERN uint64_t yrc_now(void);
+
+/**
+  filled in when yrc is built with YRC_STATS defined (`-Dyrc_stats=1`);
+  otherwise the response's `stats` is always NULL. timers are in
+  nanoseconds; `parse_ns` excludes the time spent in the tokenizer.
+**/
+typedef struct yrc_parse_stats_s {
+  size_t    tokens[YRC_TOKEN_EOF];  /* by yrc_token_type */
+  size_t    nodes[YRC_AST_LAST];    /* by yrc_ast_node_type */
+  size_t    read_calls;
+  size_t    read_bytes;
+  size_t    token_arenas;
+  size_t    node_arenas;
+  size_t    node_bytes;             /* held by the node arenas */
+  size_t    externalized;           /* strings too long to intern */
+  size_t    max_depth;              /* expression() recursion */
+  uint64_t  scan_ns;
+  uint64_t  parse_ns;
+} yrc_parse_stats_t;
+
 typedef struct yrc_parse_response_s {
-  yrc_ast_node_t* root;
-  yrc_error_t*    error;
+  yrc_ast_node_t*     root;
+  yrc_error_t*        error;
+  yrc_parse_stats_t*  stats;
 } yrc_parse_response_t;
 
+/**
+  optional read-ahead wrapper for any yrc_readcb: pass yrc_prefetch_read
+  as the request's `read` and the yrc_prefetch_t as its `readctx`. the
+  wrapped callback is then driven from a background thread.
+**/
+typedef struct yrc_prefetch_s yrc_prefetch_t;
+YRC_EXTERN int yrc_prefetch_init(yrc_prefetch_t**, yrc_readcb, void*, size_t);
+YRC_EXTERN size_t yrc_prefetch_read(char*, size_t, void*);
+YRC_EXTERN int yrc_prefetch_free(yrc_prefetch_t*);
+
+/**
+  0 on success. a parse that fails on a syntax error or a spent budget
+  still sets `*out`, to a response with a NULL root and an `error` saying
+  what went wrong; otherwise (out of memory, or stopped by the statement
+  callback) `*out` is NULL. yrc_parse_free takes either.
+**/
 YRC_EXTERN int yrc_parse(yrc_parse_request_t*, yrc_parse_response_t**);
 YRC_EXTERN int yrc_parse_free(yrc_parse_response_t*);
+
+/**
+  check a file's syntax without building a tree: 0 if it parses, 1 if
+  not. the same grammar as yrc_parse, but no nodes are made and tokens
+  are let go of as soon as the parser is past them, so memory stays flat
+  however long the input. on a syntax error `error` gets where it happened (malloc'd;
+  free() it); it's left NULL if the failure was running out of memory.
+  the request's `statement` and `incremental` are ignored.
+**/
+YRC_EXTERN int yrc_validate(yrc_parse_request_t*, yrc_error_t**);
+
+/**
+  push-mode parsing, for callers that get their input in pieces and can't
+  block waiting for the rest. yrc_parser_init takes a request like
+  yrc_parse's (its `read` and `readctx` are ignored) and the size of the
+  stack the parse runs on, or 0 for 8MB (only what's touched is paged
+  in); as with yrc_parse, nesting deeper than the stack allows crashes.
+  each yrc_parser_feed hands over the next bytes and returns once they've
+  been read: YRC_FEED_NEED_MORE until an empty feed marks the end of the
+  input, then YRC_FEED_DONE -- take the response with
+  yrc_parser_response -- or YRC_FEED_ERROR. after an error,
+  yrc_parser_response returns 1 but still hands over what yrc_parse
+  would have: a response with a NULL root and an `error` saying where
+  the input went wrong, or NULL. statement callbacks run during the feed
+  that completes each statement.
+
+  with a `budget` on the request, a feed also returns YRC_FEED_YIELD each
+  time that many tokens have been scanned. the parse waits, keeping any
+  bytes it hasn't read yet, until yrc_parser_resume carries on with a
+  fresh budget; feeding it meanwhile does nothing.
+**/
+typedef enum {
+  YRC_FEED_NEED_MORE,
+  YRC_FEED_DONE,
+  YRC_FEED_ERROR,
+  YRC_FEED_YIELD
+} yrc_feed_status;
+
+typedef struct yrc_parser_s yrc_parser_t;
+YRC_EXTERN int yrc_parser_init(yrc_parser_t**, yrc_parse_request_t*, size_t);
+YRC_EXTERN int yrc_parser_feed(yrc_parser_t*, const char*, size_t);
+YRC_EXTERN int yrc_parser_resume(yrc_parser_t*);
+YRC_EXTERN int yrc_parser_response(yrc_parser_t*, yrc_parse_response_t**);
+YRC_EXTERN int yrc_parser_free(yrc_parser_t*);
+
+/**
+  a text edit, in byte offsets: [start, old_end) of the old text became
+  [start, new_end) of the new one.
+**/
+typedef struct yrc_edit_s {
+  size_t  start;
+  size_t  old_end;
+  size_t  new_end;
+} yrc_edit_t;
+
+/**
+  bring an incremental response up to date with an edit, given the whole
+  new text. only the statements around the edit are parsed again, in the
+  innermost block that contains it; everything else (nodes and tokens) is
+  kept, with positions after the edit moved to match. on failure --
+  usually a syntax error in the new text -- the response is unchanged.
+**/
+YRC_EXTERN int yrc_reparse(yrc_parse_response_t*, const yrc_edit_t*, const char*, size_t);
+
+/**
+  write a tree to a relocatable binary blob (malloc'd; free() it), and
+  load one back as a response to be released with yrc_parse_free. the
+  blob must be 8-byte aligned and must outlive the loaded response, which
+  refers to its longer strings in place -- an mmap'd file works as is.
+**/
+YRC_EXTERN int yrc_ast_serialize(yrc_ast_node_t*, void**, size_t*);
+YRC_EXTERN int yrc_ast_deserialize(const void*, size_t, yrc_parse_response_t**);
+
+/**
+  text output. `write` gets the output in order, a buffer at a time;
+  return non-zero from it to stop. `buffer` is where output collects
+  between writes -- pass the same one to every call to keep them from
+  touching the heap -- or NULL for a small one on the stack.
+**/
+typedef int (*yrc_writecb)(const char*, size_t, void*);
+typedef struct yrc_output_s {
+  yrc_writecb   write;
+  void*         writectx;
+  char*         buffer;
+  size_t        buffersize;
+} yrc_output_t;
+
+typedef enum {
+  YRC_JSON_COMPACT=1,       /* no whitespace between tokens */
+  YRC_JSON_NO_POSITIONS=2   /* leave out `range` and `loc` */
+} yrc_json_flags;
+
+/**
+  write a tree as ESTree JSON. positions follow esprima's `range` and
+  `loc` (0-based columns): a node spans its first through last token,
+  leaving out parens around it. ranges are byte offsets.
+**/
+YRC_EXTERN int yrc_ast_to_json(yrc_ast_node_t*, yrc_output_t*, int);
+
+typedef enum {
+  YRC_CODEGEN_MINIFY=1      /* no optional whitespace */
+} yrc_codegen_flags;
+
+/**
+  write a tree back out as javascript that parses to the same tree. parens
+  are placed by precedence, not copied from the source. by default each
+  statement gets a line of its own, indented by two spaces. fails on
+  nodes the parser never produces, like arrows.
+**/
+YRC_EXTERN int yrc_codegen(yrc_ast_node_t*, yrc_output_t*, int);
+
+/**
+  yrc_codegen, also writing a Source Map v3 for the code to `map` as it
+  goes. `source` is the original file's name, for the map's "sources".
+  the start of each printed node and name maps back to its first token;
+  source columns count bytes, like every yrc position, while generated
+  ones count UTF-16 units, as browsers expect.
+**/
+YRC_EXTERN int yrc_codegen_map(yrc_ast_node_t*, yrc_output_t*, yrc_output_t*, const char*, int);
+
+typedef enum {
+  YRC_DEPENDENCY_REQUIRE,   /* require("x") */
+  YRC_DEPENDENCY_IMPORT,    /* import "x", import ... from "x" */
+  YRC_DEPENDENCY_EXPORT,    /* export ... from "x" */
+  YRC_DEPENDENCY_DYNAMIC    /* import("x") */
+} yrc_dependency_kind;
+
+typedef int (*yrc_dependencycb)(yrc_dependency_kind, yrc_token_t*, void*);
+
+/**
+  list what a file loads without parsing it. each static specifier goes
+  to the callback as its string token, which lasts until the callback
+  returns; return non-zero from it to stop. only the request's read
+  callback, its size and its context are used.
+**/
+YRC_EXTERN int yrc_scan_dependencies(yrc_parse_request_t*, yrc_dependencycb, void*);
+
+/**
+  a string token's value, with its escapes decoded, as UTF-8 (a lone
+  surrogate is written as the three bytes it would take were it a
+  character). as much as fits goes to `buf`, and `len` gets the whole
+  length, which is never more than yrc_str_len of the token's `str`.
+  a string without escapes is just its `str`. fails on other tokens.
+**/
+YRC_EXTERN int yrc_token_string_value(yrc_token_t*, char*, size_t, size_t*);
+
+typedef int (*yrc_tokencb)(yrc_token_t*, void*);
+
+/**
+  tokenize a whole buffer on `nthreads` threads (0 for one per cpu). the
+  callback gets every token, whitespace and comments included, in order
+  and positioned exactly as a single tokenizer reading the buffer would
+  give them, a `/` being taken for a regexp as in yrc-bench's tokenize
+  mode (yrc_tokenizer_regexp_mode). tokens last until the callback
+  returns; return non-zero from it to stop. the buffer is split into
+  chunks of at least 16KB, so small ones stay on a single thread.
+**/
+YRC_EXTERN int yrc_tokenize_parallel(const char*, size_t, size_t, yrc_tokencb, void*);
+
+/**
+  on-disk parse cache keyed by a hash of the input bytes. yrc_cache_parse
+  takes the same request as yrc_parse and returns a response to release
+  with yrc_parse_free, loaded from `dir` when the same bytes were parsed
+  before. entries past `max_bytes` in total (0 for no limit) are evicted
+  least recently used first. any number of processes may share a `dir`.
+**/
+typedef struct yrc_cache_s yrc_cache_t;
+YRC_EXTERN int yrc_cache_init(yrc_cache_t**, const char*, size_t);
+YRC_EXTERN int yrc_cache_parse(yrc_cache_t*, yrc_parse_request_t*, yrc_parse_response_t**);
+YRC_EXTERN void yrc_cache_counts(yrc_cache_t*, size_t*, size_t*);
+YRC_EXTERN int yrc_cache_free(yrc_cache_t*);
+
+/**
+  reading an error. yrc_error writes a message like "3:14: unexpected `)`"
+  (columns counted from 1) to `buf`, truncating to fit. yrc_error_token
+  gives the spelling of an operator or keyword that wasn't expected, or
+  names any other token ("identifier", "end of input", ...). positions
+  are a 1-based line, a 0-based byte column, as in yrc_ast_to_json's
+  `loc`, and a byte offset.
+**/
 YRC_EXTERN int yrc_error(yrc_error_t*, char*, size_t);
 YRC_EXTERN int yrc_error_token(yrc_error_t*, const char**);
 YRC_EXTERN int yrc_error_position(yrc_error_t*, size_t*, size_t*, size_t*);
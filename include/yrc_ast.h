@@ -52,7 +52,8 @@ typedef enum {
   YRC_EUNEXPECTED,
   YRC_ENOTALLOWED,
   YRC_EBADTOKEN,
-  YRC_EMEM
+  YRC_EMEM,
+  YRC_EBUDGET
 } yrc_parse_error_type;
 typedef struct yrc_error_s yrc_error_t;
 
@@ -98,6 +99,7 @@ typedef enum {
 
 typedef struct yrc_ast_node_s yrc_ast_node_t;
 typedef struct yrc_parser_state_s yrc_parser_state_t;
+typedef struct yrc_span_list_s yrc_span_list_t;
 
 typedef enum {
   YRC_PROP_SPC=1,
@@ -183,6 +185,7 @@ typedef struct yrc_ast_node_exprstmt_s {
 
 typedef struct yrc_ast_node_block_s {
   yrc_llist_t* body;
+  yrc_span_list_t* spans;   /* statement extents, for yrc_reparse (or NULL) */
 } yrc_ast_node_block_t;
 typedef yrc_ast_node_block_t yrc_ast_node_program_t;
 
@@ -250,6 +253,7 @@ typedef struct yrc_ast_node_for_in_s {
 typedef struct yrc_ast_node_case_s {
   yrc_ast_node_t* test;
   yrc_llist_t* consequent;
+  yrc_span_list_t* spans;
 } yrc_ast_node_case_t;
 
 
@@ -263,6 +267,8 @@ typedef yrc_ast_node_for_in_t yrc_ast_node_for_of_t;
 struct yrc_ast_node_s {
   yrc_ast_node_type kind;
   uint_fast8_t has_parens;
+  yrc_token_t* first;   /* the node's first and last tokens, excluding */
+  yrc_token_t* last;    /* its own parens; NULL for the program */
   union {
     yrc_ast_node_array_t        as_array;
     yrc_ast_node_assign_t       as_assign;
@@ -16,6 +16,7 @@ int yrc_llist_all(yrc_llist_t*, int*, yrc_llist_filter_cb_t, void*);
 typedef struct { void* ptr; } yrc_llist_iter_t;
 
 int yrc_llist_init(yrc_llist_t**);
+int yrc_llist_init_local(yrc_llist_t**);
 int yrc_llist_free(yrc_llist_t*);
 int yrc_llist_push(yrc_llist_t*, void*);
 void* yrc_llist_pop(yrc_llist_t*);
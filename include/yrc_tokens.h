@@ -176,8 +176,10 @@ typedef struct yrc_token_regexp_s {
   yrc_regexp_flags flags;
 } yrc_token_regexp_t;
 
+/* `str` is the text between the quotes as written; see yrc_token_string_value */
 typedef struct yrc_token_string_s {
   yrc_token_string_delim delim;  /* " ' ''' """ */
+  int has_escapes;
   yrc_str_t str;
 } yrc_token_string_t;
 
@@ -0,0 +1,65 @@
+#ifndef YRC_TRAVERSE_H
+#define YRC_TRAVERSE_H
+#include "yrc_ast.h"
+
+typedef enum {
+  kYrcTraverseContinue,
+  kYrcTraverseStop,
+  kYrcTraverseSkip   /* from enter: don't descend, but still call exit */
+} yrc_visitor_mode;
+
+typedef yrc_visitor_mode (*yrc_nodecb)(yrc_ast_node_t*, yrc_rel, yrc_ast_node_t*, void*);
+
+/**
+  `mask` selects which node kinds fire enter/exit, built from
+  YRC_TRAVERSE_KIND(EXPR_CALL) | ...; a mask of 0 fires for every kind.
+  callbacks receive the visitor itself as their context pointer.
+**/
+#define YRC_TRAVERSE_KIND(K) ((uint64_t)1 << YRC_AST_##K)
+#define YRC_TRAVERSE_ALL ((uint64_t)0)
+
+typedef struct yrc_visitor_s {
+  yrc_nodecb enter;
+  yrc_nodecb exit;
+  uint64_t   mask;
+} yrc_visitor_t;
+
+typedef struct yrc_traverse_frame_s {
+  yrc_ast_node_t* node;
+  yrc_ast_node_t* parent;
+  uint_fast8_t    rel;
+  uint_fast8_t    exiting;
+} yrc_traverse_frame_t;
+
+typedef int (*yrc_visitor_create_cb)(yrc_visitor_t**, void*);
+typedef int (*yrc_visitor_destroy_cb)(yrc_visitor_t*, void*);
+
+/**
+  parallel traversal: every worker thread gets its own visitor from
+  `create`, and once all work is done each worker visitor is folded into
+  the result with `reduce` (called as reduce(last, visitor, &out, idx, ctx),
+  the same shape as yrc_llist_reduce), then handed to `destroy`.
+
+  the program body is split into one task per statement. function bodies
+  with at least `split_threshold` statements are split further, with their
+  statements handed out as tasks of their own (0 disables this). the
+  order in which nodes are visited across workers is unspecified, and
+  the block of a split function body sees its exit before its children.
+  a stop ends the walk of the worker that saw it; the others finish the
+  statement they're on, and nothing further is handed out.
+**/
+typedef struct yrc_parallel_visitor_s {
+  yrc_visitor_create_cb   create;
+  yrc_visitor_destroy_cb  destroy;
+  yrc_llist_reduce_cb_t   reduce;
+  void*                   ctx;
+  size_t                  nthreads;         /* 0 = one per online cpu */
+  size_t                  split_threshold;
+} yrc_parallel_visitor_t;
+
+/* 0 on completion or stop, 1 if the stack ran out (or couldn't grow) */
+YRC_EXTERN int yrc_traverse(yrc_ast_node_t*, yrc_visitor_t*);
+YRC_EXTERN int yrc_traverse_stack(yrc_ast_node_t*, yrc_visitor_t*, yrc_traverse_frame_t*, size_t);
+YRC_EXTERN int yrc_traverse_parallel(yrc_ast_node_t*, yrc_parallel_visitor_t*, void*, void**);
+
+#endif
@@ -0,0 +1,446 @@
+#include "yrc-common.h"
+#include "parser.h"
+#include "hash.h"
+#include <string.h> /* memcpy, strlen */
+#include <stdio.h>  /* snprintf, rename */
+
+#ifndef _WIN32
+# include <dirent.h>
+# include <errno.h>
+# include <fcntl.h>
+# include <sys/file.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <time.h>
+# include <unistd.h>
+#endif
+
+/**
+  content-addressed parse cache. the input is read (and hashed) in full
+  before anything else happens; its XXH64 names the entry,
+  `<dir>/<hash>.yrca`, which holds an entry_header_t and then the
+  yrc_ast_serialize output. a hit maps the entry and loads it; a miss
+  parses the buffered input and stores the result. the header has the
+  input's length and a second XXH64, under another seed, and a hit needs
+  both to match: a name collision is a miss, not someone else's tree.
+
+  concurrency comes from the filesystem rather than from locks: entries
+  are written to a temp file of their own (mkstemp) and renamed into
+  place, so readers see a whole entry or none. a reader's mapping survives the
+  entry being replaced or evicted underneath it. anything that fails to
+  load -- truncated, from another version, garbage -- is a miss and
+  gets overwritten.
+
+  eviction is LRU by mtime (hits touch their entry). each cache keeps a
+  running estimate of the directory size; once that passes `max_bytes`
+  the directory is rescanned and the oldest entries removed until it's
+  under kLowWater of the limit, so a scan pays for many stores. a
+  non-blocking flock on `<dir>/.lock` keeps processes from evicting at
+  the same time.
+
+  streaming requests (`statement` set) aren't cached. on windows every
+  request passes straight through to yrc_parse.
+**/
+
+#define kSuffix ".yrca"
+#define kTemp ".tmp."     /* follows kSuffix in temp file names */
+#define kCheckSeed 0x9e3779b1UL
+#define kLowWater 0.9
+#define kStaleTemp 3600   /* seconds before an orphaned temp file goes */
+
+struct yrc_cache_s {
+  char*   dir;
+  size_t  max_bytes;
+  size_t  bytes;          /* estimate; includes other processes' entries as of the last scan */
+  size_t  hits;
+  size_t  misses;
+};
+
+typedef struct source_s {
+  char*     data;
+  size_t    size;
+  size_t    pos;
+  uint64_t  check;  /* XXH64 under kCheckSeed */
+} source_t;
+
+/* keeps the tree that follows 8-byte aligned */
+typedef struct entry_header_s {
+  uint64_t  size;
+  uint64_t  check;
+} entry_header_t;
+
+static size_t readsource(char* data, size_t desired, void* ctx) {
+  source_t* src = ctx;
+  size_t avail = src->size - src->pos;
+  if (desired > avail) {
+    desired = avail;
+  }
+  memcpy(data, src->data + src->pos, desired);
+  src->pos += desired;
+  return desired;
+}
+
+/* drains the request's read callback, hashing as it goes */
+static int slurp(yrc_parse_request_t* req, source_t* src, uint64_t* key) {
+  yrc_hash_t hash;
+  yrc_hash_t check;
+  size_t chunk = req->readsize > 0 ? req->readsize : 4096;
+  size_t capacity = chunk;
+  size_t got;
+  char* grown;
+
+  src->data = malloc(capacity);
+  src->size = 0;
+  src->pos = 0;
+  if (src->data == NULL) {
+    return 1;
+  }
+  yrc_hash_init(&hash, 0);
+  yrc_hash_init(&check, kCheckSeed);
+  while (1) {
+    if (capacity - src->size < chunk) {
+      grown = realloc(src->data, capacity * 2);
+      if (grown == NULL) {
+        free(src->data);
+        return 1;
+      }
+      src->data = grown;
+      capacity *= 2;
+    }
+    got = req->read(src->data + src->size, capacity - src->size, req->readctx);
+    if (got == 0) {
+      break;
+    }
+    yrc_hash_update(&hash, src->data + src->size, got);
+    yrc_hash_update(&check, src->data + src->size, got);
+    src->size += got;
+  }
+  *key = yrc_hash_digest(&hash);
+  src->check = yrc_hash_digest(&check);
+  return 0;
+}
+
+#ifndef _WIN32
+static char* entry_path(yrc_cache_t* cache, const char* name) {
+  size_t len = strlen(cache->dir) + strlen(name) + 2;
+  char* path = malloc(len);
+  if (path) {
+    snprintf(path, len, "%s/%s", cache->dir, name);
+  }
+  return path;
+}
+
+static void unmap_blob(void* blob, size_t size) {
+  munmap(blob, size);
+}
+
+static int lookup(yrc_cache_t* cache, const char* path, const source_t* src, yrc_parse_response_t** out) {
+  yrc_parse_response_priv_t* resp;
+  const entry_header_t* header;
+  struct stat st;
+  void* blob;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return 1;
+  }
+  if (fstat(fd, &st) || st.st_size <= (off_t)sizeof(*header)) {
+    close(fd);
+    return 1;
+  }
+  blob = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (blob == MAP_FAILED) {
+    close(fd);
+    return 1;
+  }
+  header = blob;
+  if (header->size != src->size || header->check != src->check ||
+      yrc_ast_deserialize(header + 1, st.st_size - sizeof(*header), out)) {
+    munmap(blob, st.st_size);
+    close(fd);
+    return 1;
+  }
+  /* bump the mtime: that's what eviction orders by */
+  futimens(fd, NULL);
+  close(fd);
+  resp = (yrc_parse_response_priv_t*)*out;
+  resp->release_blob = unmap_blob;
+  resp->blob = blob;
+  resp->blob_size = st.st_size;
+  return 0;
+}
+
+static int write_all(int fd, const void* data, size_t size) {
+  size_t written;
+  ssize_t rc;
+  for (written = 0; written < size; written += rc) {
+    rc = write(fd, (const char*)data + written, size - written);
+    if (rc < 0 && errno == EINTR) {
+      rc = 0;
+    } else if (rc <= 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int store(yrc_cache_t* cache, const char* path, const source_t* src,
+                 yrc_ast_node_t* root, size_t* stored) {
+  size_t len = strlen(path) + sizeof(kTemp "XXXXXX");
+  entry_header_t header;
+  char* tmp;
+  void* blob;
+  size_t size;
+  int failed;
+  int fd;
+
+  if (yrc_ast_serialize(root, &blob, &size)) {
+    return 1;
+  }
+  tmp = malloc(len);
+  if (tmp == NULL) {
+    free(blob);
+    return 1;
+  }
+  snprintf(tmp, len, "%s" kTemp "XXXXXX", path);
+  fd = mkstemp(tmp);
+  if (fd < 0) {
+    free(tmp);
+    free(blob);
+    return 1;
+  }
+  header.size = src->size;
+  header.check = src->check;
+  /* mkstemp makes files only their owner can read */
+  failed = fchmod(fd, 0644) ||
+           write_all(fd, &header, sizeof(header)) ||
+           write_all(fd, blob, size);
+  free(blob);
+  if (close(fd) || failed || rename(tmp, path)) {
+    unlink(tmp);
+    free(tmp);
+    return 1;
+  }
+  free(tmp);
+  *stored = sizeof(header) + size;
+  return 0;
+}
+
+typedef struct entry_s {
+  char*   name;
+  size_t  size;
+  time_t  mtime;
+} entry_t;
+
+static int compare_entry(const void* lhs, const void* rhs) {
+  const entry_t* a = lhs;
+  const entry_t* b = rhs;
+  return a->mtime < b->mtime ? -1 : a->mtime > b->mtime;
+}
+
+static int has_suffix(const char* str, const char* suffix) {
+  size_t len = strlen(str);
+  size_t slen = strlen(suffix);
+  return len > slen && strcmp(str + len - slen, suffix) == 0;
+}
+
+/**
+  sums the directory's entries into `total`. when `entries` is set they
+  are collected too, and orphaned temp files are removed on the way.
+**/
+static int scan(yrc_cache_t* cache, entry_t** entries, size_t* count, size_t* total) {
+  struct dirent* dent;
+  struct stat st;
+  size_t capacity = 0;
+  entry_t* grown;
+  char* path;
+  DIR* dir;
+  time_t now = time(NULL);
+
+  *total = 0;
+  if (entries) {
+    *entries = NULL;
+    *count = 0;
+  }
+  dir = opendir(cache->dir);
+  if (dir == NULL) {
+    return 1;
+  }
+  while ((dent = readdir(dir)) != NULL) {
+    int entry = has_suffix(dent->d_name, kSuffix);
+    if (!entry && !(entries && strstr(dent->d_name, kSuffix kTemp))) {
+      continue;
+    }
+    path = entry_path(cache, dent->d_name);
+    if (path == NULL || stat(path, &st)) {
+      free(path);
+      continue;
+    }
+    if (!entry) {
+      if (now - st.st_mtime > kStaleTemp) {
+        unlink(path);
+      }
+      free(path);
+      continue;
+    }
+    *total += st.st_size;
+    if (entries == NULL) {
+      free(path);
+      continue;
+    }
+    if (*count == capacity) {
+      capacity = capacity ? capacity * 2 : 64;
+      grown = realloc(*entries, capacity * sizeof(**entries));
+      if (grown == NULL) {
+        free(path);
+        break;
+      }
+      *entries = grown;
+    }
+    (*entries)[*count].name = path;
+    (*entries)[*count].size = st.st_size;
+    (*entries)[*count].mtime = st.st_mtime;
+    ++*count;
+  }
+  closedir(dir);
+  return 0;
+}
+
+static void evict(yrc_cache_t* cache) {
+  entry_t* entries;
+  size_t count;
+  size_t total;
+  size_t target = (size_t)(cache->max_bytes * kLowWater);
+  size_t i;
+  char* lockpath;
+  int fd;
+
+  lockpath = entry_path(cache, ".lock");
+  if (lockpath == NULL) {
+    return;
+  }
+  fd = open(lockpath, O_RDWR | O_CREAT, 0666);
+  free(lockpath);
+  if (fd < 0) {
+    return;
+  }
+  /* someone else is already evicting; their scan will cover ours */
+  if (flock(fd, LOCK_EX | LOCK_NB)) {
+    close(fd);
+    return;
+  }
+  if (scan(cache, &entries, &count, &total) == 0) {
+    qsort(entries, count, sizeof(*entries), compare_entry);
+    for (i = 0; i < count; ++i) {
+      if (total > target && unlink(entries[i].name) == 0) {
+        total -= entries[i].size;
+      }
+      free(entries[i].name);
+    }
+    free(entries);
+    cache->bytes = total;
+  }
+  flock(fd, LOCK_UN);
+  close(fd);
+}
+#endif
+
+YRC_EXTERN int yrc_cache_init(yrc_cache_t** out, const char* dir, size_t max_bytes) {
+  yrc_cache_t* cache = malloc(sizeof(*cache));
+  size_t len = strlen(dir);
+  if (cache == NULL) {
+    return 1;
+  }
+  cache->dir = malloc(len + 1);
+  if (cache->dir == NULL) {
+    free(cache);
+    return 1;
+  }
+  memcpy(cache->dir, dir, len + 1);
+  cache->max_bytes = max_bytes;
+  cache->bytes = 0;
+  cache->hits = 0;
+  cache->misses = 0;
+#ifndef _WIN32
+  if (mkdir(dir, 0777) && errno != EEXIST) {
+    free(cache->dir);
+    free(cache);
+    return 1;
+  }
+  if (max_bytes) {
+    scan(cache, NULL, NULL, &cache->bytes);
+  }
+#endif
+  *out = cache;
+  return 0;
+}
+
+YRC_EXTERN int yrc_cache_parse(yrc_cache_t* cache, yrc_parse_request_t* req, yrc_parse_response_t** out) {
+  yrc_parse_request_t inner;
+  source_t src;
+  uint64_t key;
+  int rc;
+#ifndef _WIN32
+  char name[32];
+  char* path;
+  size_t stored;
+#endif
+
+  *out = NULL;
+  if (req->statement) {
+    return yrc_parse(req, out);
+  }
+#ifdef _WIN32
+  (void)src;
+  (void)key;
+  (void)inner;
+  ++cache->misses;
+  return yrc_parse(req, out);
+#else
+  if (slurp(req, &src, &key)) {
+    return 1;
+  }
+  snprintf(name, sizeof(name), "%08lx%08lx" kSuffix,
+      (unsigned long)(key >> 32), (unsigned long)(key & 0xFFFFFFFFUL));
+  path = entry_path(cache, name);
+  if (path == NULL) {
+    free(src.data);
+    return 1;
+  }
+
+  if (lookup(cache, path, &src, out) == 0) {
+    ++cache->hits;
+    free(path);
+    free(src.data);
+    return 0;
+  }
+
+  ++cache->misses;
+  inner = *req;
+  inner.read = readsource;
+  inner.readctx = &src;
+  rc = yrc_parse(&inner, out);
+  free(src.data);
+  /* the cache is best-effort: a failed store still returns the parse */
+  if (rc == 0 && store(cache, path, &src, (*out)->root, &stored) == 0) {
+    cache->bytes += stored;
+    if (cache->max_bytes && cache->bytes > cache->max_bytes) {
+      evict(cache);
+    }
+  }
+  free(path);
+  return rc;
+#endif
+}
+
+YRC_EXTERN void yrc_cache_counts(yrc_cache_t* cache, size_t* hits, size_t* misses) {
+  *hits = cache->hits;
+  *misses = cache->misses;
+}
+
+YRC_EXTERN int yrc_cache_free(yrc_cache_t* cache) {
+  free(cache->dir);
+  free(cache);
+  return 0;
+}
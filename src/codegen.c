@@ -0,0 +1,1077 @@
+#include "yrc-common.h"
+#include "parser.h"
+#include "tokenizer.h"
+#include "output.h"
+#include <stdio.h>  /* snprintf */
+
+/**
+  javascript from a tree, in one recursive pass. parentheses come from
+  precedence rather than from the source: every expression is printed
+  with the binding power its position needs and parenthesized when its
+  own is lower. the numbers are the parser's (yrc_parser_binding_powers),
+  so what's printed parses back to the same tree.
+
+  minified output leaves out every optional space and newline, and the
+  `;` before a `}`. pretty output puts each statement on its own line,
+  indented by two spaces. either way, whether two tokens need a space
+  between them is decided from the last byte written and the next one:
+  words would run together, and `+ +`, `- -` or `/ /` would turn into
+  other tokens.
+
+  two shapes need more than precedence:
+
+  - `new` is a unary node whose argument swallowed the call after it
+    (see json.c). printing the argument as is gets the same chain back,
+    except where the source parenthesized part of it; that part is
+    parenthesized again so `new` still applies to the same call.
+  - an expression statement can't start with `function` or `{`, so one
+    that would is wrapped in parens.
+
+  with a source map requested, each node and name marks its first token
+  on the way down, and the next token written maps back to it: segments
+  go out as the code does, one generated line per `;` of "mappings".
+**/
+
+enum {
+  kFallbackBuffer=4096,
+  kIndentWidth=2,
+  kPrimary=255
+};
+
+typedef struct codegen_s {
+  yrc_writer_t      w;
+  uint8_t           lbp[YRC_KW_LAST];
+  uint_fast8_t      minify;
+  uint_fast8_t      no_in;      /* in a for-init, where a bare `in` ends it */
+  uint_fast8_t      semicolon;  /* a `;` is owed, unless `}` comes next */
+  unsigned char     last;       /* last byte written; 0 at the start */
+  size_t            depth;
+  yrc_ast_node_t*   paren;      /* parenthesize this one regardless */
+
+  /* source map state; `mark` is only ever set when `mapping` is */
+  yrc_writer_t      map;
+  uint_fast8_t      mapping;
+  uint_fast8_t      segments;   /* any on this generated line yet? */
+  yrc_token_t*      mark;       /* where the next token written came from */
+  size_t            line_start; /* w.total at the start of this line */
+  size_t            skew;       /* bytes past UTF-16 units on this line */
+  size_t            column;     /* the previous segment's, for deltas */
+  size_t            source_line;
+  size_t            source_column;
+} codegen_t;
+
+static const char kSpaces[] = "                                ";
+
+static void expr(codegen_t*, yrc_ast_node_t*, unsigned);
+static void stmt(codegen_t*, yrc_ast_node_t*);
+
+static int is_word(unsigned char ch) {
+  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+         (ch >= '0' && ch <= '9') || ch == '_' || ch == '$' || ch == '\\' || ch >= 0x80;
+}
+
+/* would `last` and `next` read differently without a space between them? */
+static int needs_space(unsigned char last, unsigned char next) {
+  if (is_word(last)) {
+    return is_word(next);
+  }
+  switch (last) {
+    case '+': return next == '+';
+    case '-': return next == '-' || next == '>';  /* `-->` opens a comment */
+    case '/': return next == '/' || next == '*';
+    case '<': return next == '!';                 /* and so does `<!--` */
+    default: return 0;
+  }
+}
+
+static const char kBase64[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* a signed delta as a base64 VLQ, sign in the lowest bit */
+static void vlq(yrc_writer_t* w, size_t from, size_t to) {
+  size_t value = to >= from ? (to - from) << 1 : ((from - to) << 1) | 1;
+  char digits[16];
+  size_t len = 0;
+  do {
+    digits[len] = kBase64[(value & 31) | (value > 31 ? 32 : 0)];
+    value >>= 5;
+    ++len;
+  } while (value);
+  yrc_writer_putv(w, digits, len);
+}
+
+/**
+  generated columns count UTF-16 units, as browsers do: one per
+  character, two past U+FFFF. this is how many bytes `data` has beyond
+  that.
+**/
+static size_t skew(const char* data, size_t size) {
+  const unsigned char* bytes = (const unsigned char*)data;
+  size_t extra = 0;
+  size_t i;
+  for (i = 0; i < size; ++i) {
+    if (bytes[i] >= 0x80) {
+      extra += (bytes[i] & 0xc0) == 0x80 ? 1 : 0;
+      extra -= bytes[i] >= 0xf0 ? 1 : 0;
+    }
+  }
+  return extra;
+}
+
+static void mark(codegen_t* cg, yrc_token_t* from) {
+  if (cg->mapping && from) {
+    cg->mark = from;
+  }
+}
+
+/* map the token about to be written back to the marked one */
+static void segment(codegen_t* cg) {
+  yrc_position_t* pos = &cg->mark->start;
+  size_t column = cg->w.total - cg->line_start - cg->skew;
+  /* source columns count from 1 after the first newline; see json.c */
+  size_t source_column = pos->line > 1 && pos->col ? pos->col - 1 : pos->col;
+  size_t source_line = pos->line - 1;
+
+  cg->mark = NULL;
+  if (cg->segments) {
+    yrc_writer_putc(&cg->map, ',');
+  }
+  cg->segments = 1;
+  vlq(&cg->map, cg->column, column);
+  yrc_writer_putc(&cg->map, 'A');   /* always the one source */
+  vlq(&cg->map, cg->source_line, source_line);
+  vlq(&cg->map, cg->source_column, source_column);
+  cg->column = column;
+  cg->source_line = source_line;
+  cg->source_column = source_column;
+}
+
+/* write the start of a token, settling any owed `;` and spacing first */
+static void token(codegen_t* cg, const char* data, size_t size) {
+  unsigned char next = (unsigned char)data[0];
+  if (cg->semicolon) {
+    cg->semicolon = 0;
+    if (next != '}') {
+      yrc_writer_putc(&cg->w, ';');
+      cg->last = ';';
+    }
+  }
+  if (needs_space(cg->last, next)) {
+    yrc_writer_putc(&cg->w, ' ');
+  }
+  if (cg->mapping) {
+    if (cg->mark) {
+      segment(cg);
+    }
+    cg->skew += skew(data, size);
+  }
+  yrc_writer_putv(&cg->w, data, size);
+  cg->last = (unsigned char)data[size - 1];
+}
+
+#define TOKEN(CG, LITERAL) token(CG, LITERAL, sizeof(LITERAL) - 1)
+
+/* the rest of a token started with token() */
+static void more(codegen_t* cg, const char* data, size_t size) {
+  if (size) {
+    if (cg->mapping) {
+      cg->skew += skew(data, size);
+    }
+    yrc_writer_putv(&cg->w, data, size);
+    cg->last = (unsigned char)data[size - 1];
+  }
+}
+
+static void space(codegen_t* cg) {
+  if (!cg->minify) {
+    yrc_writer_putc(&cg->w, ' ');
+    cg->last = ' ';
+  }
+}
+
+static void newline(codegen_t* cg) {
+  size_t indent;
+  size_t chunk;
+  if (cg->minify) {
+    return;
+  }
+  yrc_writer_putc(&cg->w, '\n');
+  if (cg->mapping) {
+    yrc_writer_putc(&cg->map, ';');
+    cg->line_start = cg->w.total;
+    cg->skew = 0;
+    cg->segments = 0;
+    cg->column = 0;
+  }
+  for (indent = cg->depth * kIndentWidth; indent; indent -= chunk) {
+    chunk = indent < sizeof(kSpaces) - 1 ? indent : sizeof(kSpaces) - 1;
+    yrc_writer_putv(&cg->w, kSpaces, chunk);
+  }
+  cg->last = '\n';
+}
+
+/* how many items `items` holds, starting `iter` on them if there are any */
+static size_t each(yrc_llist_t* items, yrc_llist_iter_t* iter) {
+  size_t count = items ? yrc_llist_len(items) : 0;
+  if (count) {
+    *iter = yrc_llist_iter_start(items);
+  }
+  return count;
+}
+
+static void end_statement(codegen_t* cg) {
+  if (cg->minify) {
+    cg->semicolon = 1;
+  } else {
+    TOKEN(cg, ";");
+  }
+}
+
+static void comma(codegen_t* cg) {
+  TOKEN(cg, ",");
+  space(cg);
+}
+
+static void op(codegen_t* cg, yrc_operator_t value) {
+  const char* str = TOKEN_OPERATOR_MAP[value];
+  token(cg, str, strlen(str));
+}
+
+/* a binary operator, spaced out when pretty */
+static void infix(codegen_t* cg, yrc_operator_t value) {
+  space(cg);
+  op(cg, value);
+  space(cg);
+}
+
+static void number(codegen_t* cg, yrc_token_number_t* value) {
+  char digits[32];
+  char out[400];
+  double v;
+  int precision;
+  int exponent;
+  int count;
+  int point;
+  int len = 0;
+  int i;
+
+  if (!(value->repr & REPR_IS_FLOAT)) {
+    uint64_t whole = value->data.as_int;
+    len = sizeof(digits);
+    do {
+      digits[--len] = '0' + (char)(whole % 10);
+      whole /= 10;
+    } while (whole);
+    token(cg, digits + len, sizeof(digits) - len);
+    return;
+  }
+  v = value->data.as_double;
+  if (v - v != 0.0) {
+    /* only overflow gets here; literals are never NaN */
+    TOKEN(cg, "1e999");
+    return;
+  }
+  /**
+    the shortest digits that read back exactly, laid out without a signed
+    exponent, which the tokenizer doesn't take: `1e-7` is `0.0000001`.
+  **/
+  for (precision = 15; precision <= 17; ++precision) {
+    snprintf(digits, sizeof(digits), "%.*e", precision - 1, v);
+    if (strtod(digits, NULL) == v) {
+      break;
+    }
+  }
+  exponent = atoi(strchr(digits, 'e') + 1);
+  for (i = 0, count = 0; digits[i] != 'e'; ++i) {
+    if (digits[i] >= '0' && digits[i] <= '9') {
+      digits[count++] = digits[i];
+    }
+  }
+  while (count > 1 && digits[count - 1] == '0') {
+    --count;
+  }
+  point = exponent + 1;
+  if (v < 0) {
+    out[len++] = '-';
+  }
+  if (point <= 0) {
+    if (count - point > (int)sizeof(out) - 8) {
+      TOKEN(cg, "0");
+      return;
+    }
+    out[len++] = '0';
+    out[len++] = '.';
+    for (i = point; i < 0; ++i) {
+      out[len++] = '0';
+    }
+    memcpy(out + len, digits, count);
+    len += count;
+  } else if (count <= point) {
+    /* a whole number; past 15 digits an integer literal would overflow */
+    memcpy(out + len, digits, count);
+    len += count;
+    if (point > 15) {
+      len += snprintf(out + len, sizeof(out) - len, "e%d", point - count);
+    } else {
+      for (i = count; i < point; ++i) {
+        out[len++] = '0';
+      }
+    }
+  } else {
+    memcpy(out + len, digits, point);
+    len += point;
+    out[len++] = '.';
+    memcpy(out + len, digits + point, count - point);
+    len += count - point;
+  }
+  token(cg, out, len);
+}
+
+/* a string's value, escaped for `delim` */
+static void string(codegen_t* cg, const char* value, size_t size, char delim) {
+  const unsigned char* data = (const unsigned char*)value;
+  size_t run = 0;
+  size_t i;
+  const char* esc;
+  char surrogate[7];
+
+  token(cg, &delim, 1);
+  for (i = 0; i < size; ++i) {
+    switch (data[i]) {
+      case '\\': esc = "\\\\"; break;
+      case '\n': esc = "\\n"; break;
+      case '\r': esc = "\\r"; break;
+      case '\0':
+        /* `\0` followed by a digit would be an octal escape */
+        esc = i + 1 < size && data[i + 1] >= '0' && data[i + 1] <= '9' ? NULL : "\\0";
+      break;
+      case 0xe2:
+        /* U+2028 and U+2029 end lines in ES5 strings */
+        esc = i + 2 < size && data[i + 1] == 0x80 && (data[i + 2] & 0xfe) == 0xa8 ?
+          (data[i + 2] == 0xa8 ? "\\u2028" : "\\u2029") : NULL;
+      break;
+      case 0xed:
+        /* a lone surrogate, from an escape: only an escape can spell it */
+        esc = NULL;
+        if (i + 2 < size && data[i + 1] >= 0xa0) {
+          sprintf(surrogate, "\\u%04x", 0xd000 | (data[i + 1] & 0x3f) << 6 | (data[i + 2] & 0x3f));
+          esc = surrogate;
+        }
+      break;
+      default:
+        esc = data[i] == (unsigned char)delim ? (delim == '"' ? "\\\"" : "\\'") : NULL;
+      break;
+    }
+    if (esc == NULL) {
+      continue;
+    }
+    more(cg, (const char*)data + run, i - run);
+    more(cg, esc, strlen(esc));
+    if (data[i] == 0xe2 || data[i] == 0xed) {
+      i += 2;
+    }
+    run = i + 1;
+  }
+  more(cg, (const char*)data + run, size - run);
+  more(cg, &delim, 1);
+}
+
+enum {
+  kValueStack=256   /* decoded string values up to this size stay off the heap */
+};
+
+/* a string token, decoded if it has escapes and written back out */
+static void string_literal(codegen_t* cg, yrc_token_t* value) {
+  yrc_str_t* str = &value->info.as_string.str;
+  size_t size = yrc_str_len(str);
+  char delim = value->info.as_string.delim == YRC_STRING_DELIM_SINGLE ? '\'' : '"';
+  char stack[kValueStack];
+  char* buf = stack;
+  size_t len;
+  if (!value->info.as_string.has_escapes) {
+    string(cg, yrc_str_ptr(str), size, delim);
+    return;
+  }
+  if (size > sizeof(stack) && (buf = malloc(size)) == NULL) {
+    cg->w.err = 1;
+    return;
+  }
+  if (yrc_token_string_value(value, buf, size, &len)) {
+    cg->w.err = 1;
+  } else {
+    string(cg, buf, len, delim);
+  }
+  if (buf != stack) {
+    free(buf);
+  }
+}
+
+static void literal(codegen_t* cg, yrc_token_t* value) {
+  yrc_regexp_flags flags;
+  yrc_str_t* str;
+  char tail[5];
+  size_t len = 0;
+
+  /* a regexp token starts past its `/`; expr() marked the node's first token */
+  if (value->type != YRC_TOKEN_REGEXP) {
+    mark(cg, value);
+  }
+  switch (value->type) {
+    case YRC_TOKEN_NUMBER:
+      number(cg, &value->info.as_number);
+    break;
+    case YRC_TOKEN_STRING:
+      string_literal(cg, value);
+    break;
+    case YRC_TOKEN_REGEXP:
+      flags = value->info.as_regexp.flags;
+      str = &value->info.as_regexp.str;
+      /* a regexp is the one token that can follow a word and start with `/` */
+      if (is_word(cg->last)) {
+        yrc_writer_putc(&cg->w, ' ');
+      }
+      TOKEN(cg, "/");
+      more(cg, yrc_str_ptr(str), yrc_str_len(str));
+      tail[len++] = '/';
+      if (flags & YRC_REGEXP_GLOBAL) tail[len++] = 'g';
+      if (flags & YRC_REGEXP_IGNORECASE) tail[len++] = 'i';
+      if (flags & YRC_REGEXP_MULTILINE) tail[len++] = 'm';
+      if (flags & YRC_REGEXP_STICKY) tail[len++] = 'y';
+      more(cg, tail, len);
+      /* a word straight after would read as more flags */
+      cg->last = 'g';
+    break;
+    case YRC_TOKEN_KEYWORD:
+      op(cg, (yrc_operator_t)value->info.as_keyword);
+    break;
+    default:
+      str = &value->info.as_ident.str;
+      token(cg, yrc_str_ptr(str), yrc_str_len(str));
+    break;
+  }
+}
+
+/* an expression in a slot of its own (an argument, an element), where `in` is fine */
+static void nested(codegen_t* cg, yrc_ast_node_t* node, unsigned min) {
+  uint_fast8_t no_in = cg->no_in;
+  cg->no_in = 0;
+  expr(cg, node, min);
+  cg->no_in = no_in;
+}
+
+static void list(codegen_t* cg, yrc_llist_t* items) {
+  yrc_llist_iter_t iter;
+  yrc_ast_node_t* item;
+  size_t count = each(items, &iter);
+  size_t i;
+
+  for (i = 0; i < count; ++i) {
+    item = yrc_llist_iter_next(&iter);
+    if (i) {
+      comma(cg);
+    }
+    if (item) {
+      nested(cg, item, cg->lbp[YRC_OP_EQ]);
+    } else if (i + 1 == count) {
+      /* a trailing hole needs a comma of its own */
+      TOKEN(cg, ",");
+    }
+  }
+}
+
+static void block(codegen_t* cg, yrc_llist_t* body) {
+  yrc_llist_iter_t iter;
+  yrc_ast_node_t* item;
+  size_t count = each(body, &iter);
+
+  TOKEN(cg, "{");
+  if (count) {
+    ++cg->depth;
+    while (count-- && !cg->w.err) {
+      item = yrc_llist_iter_next(&iter);
+      newline(cg);
+      stmt(cg, item);
+    }
+    --cg->depth;
+    newline(cg);
+  }
+  TOKEN(cg, "}");
+}
+
+static void function(codegen_t* cg, yrc_ast_node_t* node) {
+  yrc_ast_node_t* body = node->data.as_function.body;
+  uint_fast8_t no_in = cg->no_in;
+  TOKEN(cg, "function");
+  if (node->data.as_function.id) {
+    space(cg);
+    literal(cg, node->data.as_function.id);
+  } else {
+    space(cg);
+  }
+  TOKEN(cg, "(");
+  list(cg, node->data.as_function.params);
+  TOKEN(cg, ")");
+  space(cg);
+  cg->no_in = 0;
+  block(cg, body ? body->data.as_block.body : NULL);
+  cg->no_in = no_in;
+}
+
+static void property(codegen_t* cg, yrc_ast_node_t* node) {
+  yrc_ast_node_t* key = node->data.as_property.key;
+  if (node->data.as_property.type & YRC_PROP_COMPUTED) {
+    TOKEN(cg, "[");
+    nested(cg, key, cg->lbp[YRC_OP_EQ]);
+    TOKEN(cg, "]");
+  } else if (key->kind == YRC_AST_EXPR_IDENTIFIER) {
+    literal(cg, key->data.as_ident.name);
+  } else {
+    expr(cg, key, kPrimary);
+  }
+  if (node->data.as_property.type & YRC_PROP_SHORTHAND) {
+    return;
+  }
+  TOKEN(cg, ":");
+  space(cg);
+  nested(cg, node->data.as_property.expression, cg->lbp[YRC_OP_EQ]);
+}
+
+/* the binding power an expression prints at */
+static unsigned precedence(codegen_t* cg, yrc_ast_node_t* node) {
+  switch (node->kind) {
+    case YRC_AST_EXPR_SEQUENCE:
+      return 0;
+    case YRC_AST_EXPR_ASSIGNMENT:
+      return cg->lbp[YRC_OP_EQ];
+    case YRC_AST_EXPR_CONDITIONAL:
+      return cg->lbp[YRC_OP_QUESTION];
+    case YRC_AST_EXPR_BINARY:
+    case YRC_AST_EXPR_LOGICAL:
+      return cg->lbp[node->data.as_binary.op];
+    case YRC_AST_EXPR_UNARY:
+      return YRC_BP_PREFIX;
+    case YRC_AST_EXPR_UPDATE:
+      /* postfix: tighter than any prefix operator, looser than a call */
+      return node->data.as_update.prefix ? YRC_BP_PREFIX : YRC_BP_PREFIX + 1;
+    case YRC_AST_EXPR_CALL:
+    case YRC_AST_EXPR_MEMBER:
+      return cg->lbp[YRC_OP_LPAREN];
+    default:
+      return kPrimary;
+  }
+}
+
+/* `new`'s argument, keeping `new` on the same call; see the top of the file */
+static void new_argument(codegen_t* cg, yrc_ast_node_t* node) {
+  yrc_ast_node_t* paren = cg->paren;
+  yrc_ast_node_t* end = node;
+  while (!end->has_parens) {
+    if (end->kind == YRC_AST_EXPR_CALL) {
+      end = end->data.as_call.callee;
+    } else if (end->kind == YRC_AST_EXPR_MEMBER) {
+      end = end->data.as_member.object;
+    } else {
+      break;
+    }
+  }
+  if (end->has_parens &&
+      (end->kind == YRC_AST_EXPR_CALL || end->kind == YRC_AST_EXPR_MEMBER ||
+       end->kind == YRC_AST_EXPR_UNARY)) {
+    cg->paren = end;
+  }
+  expr(cg, node, cg->lbp[YRC_OP_LPAREN]);
+  cg->paren = paren;
+}
+
+static void expr(codegen_t* cg, yrc_ast_node_t* node, unsigned min) {
+  unsigned prec = precedence(cg, node);
+  uint_fast8_t no_in = cg->no_in;
+  yrc_ast_node_t* item;
+  int parens = prec < min || node == cg->paren ||
+    (no_in && node->kind == YRC_AST_EXPR_BINARY && (int)node->data.as_binary.op == YRC_KW_IN);
+
+  mark(cg, node->first);
+  if (parens) {
+    TOKEN(cg, "(");
+    cg->no_in = 0;
+  }
+  switch (node->kind) {
+    case YRC_AST_EXPR_IDENTIFIER:
+      literal(cg, node->data.as_ident.name);
+    break;
+    case YRC_AST_EXPR_LITERAL:
+      literal(cg, node->data.as_literal.value);
+    break;
+    case YRC_AST_EXPR_THIS:
+      TOKEN(cg, "this");
+    break;
+    case YRC_AST_EXPR_ARRAY:
+      TOKEN(cg, "[");
+      list(cg, node->data.as_array.elements);
+      TOKEN(cg, "]");
+    break;
+    case YRC_AST_EXPR_OBJECT: {
+        yrc_llist_iter_t iter;
+        size_t count = each(node->data.as_object.properties, &iter);
+        size_t i;
+        TOKEN(cg, "{");
+        for (i = 0; i < count; ++i) {
+          if (i) {
+            comma(cg);
+          }
+          property(cg, yrc_llist_iter_next(&iter));
+        }
+        TOKEN(cg, "}");
+      }
+    break;
+    case YRC_AST_EXPR_FUNCTION:
+      function(cg, node);
+    break;
+    case YRC_AST_EXPR_SEQUENCE:
+      item = node->data.as_sequence.right;
+      expr(cg, node->data.as_sequence.left, cg->lbp[YRC_OP_EQ]);
+      comma(cg);
+      /* sequences nest to the right; one the source parenthesized stays so */
+      expr(cg, item, item->has_parens ? 1 : 0);
+    break;
+    case YRC_AST_EXPR_UNARY:
+      op(cg, node->data.as_unary.op);
+      if ((int)node->data.as_unary.op == YRC_KW_NEW) {
+        new_argument(cg, node->data.as_unary.argument);
+        break;
+      }
+      expr(cg, node->data.as_unary.argument, YRC_BP_PREFIX);
+    break;
+    case YRC_AST_EXPR_UPDATE:
+      if (node->data.as_update.prefix) {
+        op(cg, node->data.as_update.op);
+        expr(cg, node->data.as_update.argument, YRC_BP_PREFIX);
+      } else {
+        expr(cg, node->data.as_update.argument, cg->lbp[YRC_OP_LPAREN]);
+        op(cg, node->data.as_update.op);
+      }
+    break;
+    case YRC_AST_EXPR_BINARY:
+    case YRC_AST_EXPR_LOGICAL:
+      expr(cg, node->data.as_binary.left, prec);
+      infix(cg, node->data.as_binary.op);
+      expr(cg, node->data.as_binary.right, prec + 1);
+    break;
+    case YRC_AST_EXPR_ASSIGNMENT:
+      expr(cg, node->data.as_binary.left, cg->lbp[YRC_OP_LPAREN]);
+      infix(cg, node->data.as_binary.op);
+      expr(cg, node->data.as_binary.right, prec);
+    break;
+    case YRC_AST_EXPR_CONDITIONAL:
+      expr(cg, node->data.as_conditional.test, prec + 1);
+      infix(cg, YRC_OP_QUESTION);
+      expr(cg, node->data.as_conditional.consequent, cg->lbp[YRC_OP_EQ]);
+      infix(cg, YRC_OP_COLON);
+      expr(cg, node->data.as_conditional.alternate, cg->lbp[YRC_OP_EQ]);
+    break;
+    case YRC_AST_EXPR_CALL:
+      expr(cg, node->data.as_call.callee, prec);
+      TOKEN(cg, "(");
+      list(cg, node->data.as_call.arguments);
+      TOKEN(cg, ")");
+    break;
+    case YRC_AST_EXPR_MEMBER:
+      item = node->data.as_member.object;
+      if (!node->data.as_member.computed && item->kind == YRC_AST_EXPR_LITERAL &&
+          item->data.as_literal.value->type == YRC_TOKEN_NUMBER) {
+        /* `1.x` would be read as a number */
+        TOKEN(cg, "(");
+        literal(cg, item->data.as_literal.value);
+        TOKEN(cg, ")");
+      } else {
+        expr(cg, item, prec);
+      }
+      if (node->data.as_member.computed) {
+        TOKEN(cg, "[");
+        nested(cg, node->data.as_member.property, 0);
+        TOKEN(cg, "]");
+      } else {
+        TOKEN(cg, ".");
+        literal(cg, node->data.as_member.property->data.as_ident.name);
+      }
+    break;
+    default:
+      /* arrows, yields and the rest aren't parsed yet */
+      cg->w.err = 1;
+    break;
+  }
+  if (parens) {
+    TOKEN(cg, ")");
+    cg->no_in = no_in;
+  }
+}
+
+/* would this expression, printed as a statement, start with `function` or `{`? */
+static int starts_ambiguous(yrc_ast_node_t* node) {
+  while (1) {
+    switch (node->kind) {
+      case YRC_AST_EXPR_FUNCTION:
+      case YRC_AST_EXPR_OBJECT:
+        return 1;
+      case YRC_AST_EXPR_SEQUENCE: node = node->data.as_sequence.left; break;
+      case YRC_AST_EXPR_BINARY:
+      case YRC_AST_EXPR_LOGICAL:
+      case YRC_AST_EXPR_ASSIGNMENT: node = node->data.as_binary.left; break;
+      case YRC_AST_EXPR_CONDITIONAL: node = node->data.as_conditional.test; break;
+      case YRC_AST_EXPR_CALL: node = node->data.as_call.callee; break;
+      case YRC_AST_EXPR_MEMBER: node = node->data.as_member.object; break;
+      case YRC_AST_EXPR_UPDATE:
+        if (node->data.as_update.prefix) {
+          return 0;
+        }
+        node = node->data.as_update.argument;
+      break;
+      default:
+        return 0;
+    }
+  }
+}
+
+/* does this statement end in an `if` that an `else` after it would join? */
+static int ends_open_if(yrc_ast_node_t* node) {
+  while (node) {
+    switch (node->kind) {
+      case YRC_AST_STMT_IF:
+        if (node->data.as_if.alternate == NULL) {
+          return 1;
+        }
+        node = node->data.as_if.alternate;
+      break;
+      case YRC_AST_STMT_WHILE: node = node->data.as_while.body; break;
+      case YRC_AST_STMT_FOR: node = node->data.as_for.body; break;
+      case YRC_AST_STMT_FORIN:
+      case YRC_AST_STMT_FOROF: node = node->data.as_for_in.body; break;
+      default:
+        return 0;
+    }
+  }
+  return 0;
+}
+
+static void var(codegen_t* cg, yrc_ast_node_t* node) {
+  yrc_llist_iter_t iter;
+  yrc_ast_node_t* item;
+  size_t count = each(node->data.as_var.declarations, &iter);
+  size_t i;
+
+  switch (node->data.as_var.type) {
+    case YRC_VARTYPE_CONST: TOKEN(cg, "const"); break;
+    case YRC_VARTYPE_LET: TOKEN(cg, "let"); break;
+    default: TOKEN(cg, "var"); break;
+  }
+  space(cg);
+  for (i = 0; i < count; ++i) {
+    item = yrc_llist_iter_next(&iter);
+    if (i) {
+      comma(cg);
+    }
+    expr(cg, item->data.as_vardecl.id, kPrimary);
+    if (item->data.as_vardecl.init) {
+      infix(cg, YRC_OP_EQ);
+      expr(cg, item->data.as_vardecl.init, cg->lbp[YRC_OP_EQ]);
+    }
+  }
+}
+
+/* a loop or if body: blocks stay on the line, anything else goes below it */
+static void body(codegen_t* cg, yrc_ast_node_t* node) {
+  if (node->kind == YRC_AST_STMT_BLOCK) {
+    space(cg);
+    stmt(cg, node);
+    return;
+  }
+  ++cg->depth;
+  newline(cg);
+  stmt(cg, node);
+  --cg->depth;
+}
+
+/* `keyword (` ... the head of if, while, for, switch and catch */
+static void head(codegen_t* cg, const char* keyword, size_t size) {
+  token(cg, keyword, size);
+  space(cg);
+  TOKEN(cg, "(");
+}
+
+#define HEAD(CG, LITERAL) head(CG, LITERAL, sizeof(LITERAL) - 1)
+
+static void stmt(codegen_t* cg, yrc_ast_node_t* node) {
+  yrc_ast_node_t* item;
+  yrc_llist_iter_t iter;
+  size_t count;
+
+  mark(cg, node->first);
+  switch (node->kind) {
+    case YRC_AST_STMT_BLOCK:
+      block(cg, node->data.as_block.body);
+    break;
+    case YRC_AST_STMT_EMPTY:
+      TOKEN(cg, ";");
+    break;
+    case YRC_AST_STMT_EXPR:
+      item = node->data.as_exprstmt.expression;
+      if (starts_ambiguous(item)) {
+        TOKEN(cg, "(");
+        expr(cg, item, 0);
+        TOKEN(cg, ")");
+      } else {
+        expr(cg, item, 0);
+      }
+      end_statement(cg);
+    break;
+    case YRC_AST_STMT_IF:
+      HEAD(cg, "if");
+      expr(cg, node->data.as_if.test, 0);
+      TOKEN(cg, ")");
+      item = node->data.as_if.consequent;
+      if (node->data.as_if.alternate && item->kind != YRC_AST_STMT_BLOCK && ends_open_if(item)) {
+        /* only a block keeps the else from joining the inner if */
+        space(cg);
+        TOKEN(cg, "{");
+        stmt(cg, item);
+        TOKEN(cg, "}");
+      } else {
+        body(cg, item);
+      }
+      if (node->data.as_if.alternate == NULL) {
+        break;
+      }
+      if (item->kind == YRC_AST_STMT_BLOCK) {
+        space(cg);
+      } else {
+        newline(cg);
+      }
+      TOKEN(cg, "else");
+      item = node->data.as_if.alternate;
+      if (item->kind == YRC_AST_STMT_IF) {
+        space(cg);
+        stmt(cg, item);
+      } else {
+        body(cg, item);
+      }
+    break;
+    case YRC_AST_STMT_BREAK:
+    case YRC_AST_STMT_CONTINUE:
+      if (node->kind == YRC_AST_STMT_BREAK) {
+        TOKEN(cg, "break");
+      } else {
+        TOKEN(cg, "continue");
+      }
+      if (node->data.as_break.label) {
+        space(cg);
+        literal(cg, node->data.as_break.label);
+      }
+      end_statement(cg);
+    break;
+    case YRC_AST_STMT_RETURN:
+    case YRC_AST_STMT_THROW:
+      if (node->kind == YRC_AST_STMT_RETURN) {
+        TOKEN(cg, "return");
+      } else {
+        TOKEN(cg, "throw");
+      }
+      if (node->data.as_return.argument) {
+        space(cg);
+        expr(cg, node->data.as_return.argument, 0);
+      }
+      end_statement(cg);
+    break;
+    case YRC_AST_STMT_TRY:
+      item = node->data.as_try.handler;
+      TOKEN(cg, "try");
+      body(cg, node->data.as_try.block);
+      if (item) {
+        space(cg);
+        HEAD(cg, "catch");
+        expr(cg, item->data.as_catch.param, 0);
+        TOKEN(cg, ")");
+        body(cg, item->data.as_catch.body);
+      }
+      /* a catch followed by finally holds the finalizer itself */
+      item = item && item->data.as_try.finalizer ? item->data.as_try.finalizer : node->data.as_try.finalizer;
+      if (item) {
+        space(cg);
+        TOKEN(cg, "finally");
+        body(cg, item);
+      }
+    break;
+    case YRC_AST_STMT_SWITCH:
+      HEAD(cg, "switch");
+      expr(cg, node->data.as_switch.discriminant, 0);
+      TOKEN(cg, ")");
+      space(cg);
+      TOKEN(cg, "{");
+      count = each(node->data.as_switch.cases, &iter);
+      ++cg->depth;
+      while (count--) {
+        item = yrc_llist_iter_next(&iter);
+        newline(cg);
+        stmt(cg, item);
+      }
+      --cg->depth;
+      newline(cg);
+      TOKEN(cg, "}");
+    break;
+    case YRC_AST_CLSE_CASE:
+      if (node->data.as_case.test) {
+        TOKEN(cg, "case");
+        space(cg);
+        expr(cg, node->data.as_case.test, 0);
+      } else {
+        TOKEN(cg, "default");
+      }
+      TOKEN(cg, ":");
+      count = each(node->data.as_case.consequent, &iter);
+      ++cg->depth;
+      while (count--) {
+        newline(cg);
+        stmt(cg, yrc_llist_iter_next(&iter));
+      }
+      --cg->depth;
+    break;
+    case YRC_AST_STMT_WHILE:
+      HEAD(cg, "while");
+      expr(cg, node->data.as_while.test, 0);
+      TOKEN(cg, ")");
+      body(cg, node->data.as_while.body);
+    break;
+    case YRC_AST_STMT_DOWHILE:
+      item = node->data.as_do_while.body;
+      TOKEN(cg, "do");
+      body(cg, item);
+      if (item->kind == YRC_AST_STMT_BLOCK) {
+        space(cg);
+      } else {
+        newline(cg);
+      }
+      HEAD(cg, "while");
+      expr(cg, node->data.as_do_while.test, 0);
+      TOKEN(cg, ")");
+      end_statement(cg);
+    break;
+    case YRC_AST_STMT_FOR:
+      HEAD(cg, "for");
+      item = node->data.as_for.init;
+      cg->no_in = 1;
+      if (item && item->kind == YRC_AST_DECL_VAR) {
+        var(cg, item);
+      } else if (item) {
+        expr(cg, item, 0);
+      }
+      cg->no_in = 0;
+      TOKEN(cg, ";");
+      if (node->data.as_for.test) {
+        space(cg);
+        expr(cg, node->data.as_for.test, 0);
+      }
+      TOKEN(cg, ";");
+      if (node->data.as_for.update) {
+        space(cg);
+        expr(cg, node->data.as_for.update, 0);
+      }
+      TOKEN(cg, ")");
+      body(cg, node->data.as_for.body);
+    break;
+    case YRC_AST_STMT_FORIN:
+    case YRC_AST_STMT_FOROF:
+      HEAD(cg, "for");
+      item = node->data.as_for_in.left;
+      cg->no_in = 1;
+      if (item->kind == YRC_AST_DECL_VAR) {
+        var(cg, item);
+      } else {
+        expr(cg, item, cg->lbp[YRC_OP_LPAREN]);
+      }
+      cg->no_in = 0;
+      if (node->kind == YRC_AST_STMT_FORIN) {
+        TOKEN(cg, "in");
+      } else {
+        TOKEN(cg, "of");
+      }
+      space(cg);
+      expr(cg, node->data.as_for_in.right, 0);
+      TOKEN(cg, ")");
+      body(cg, node->data.as_for_in.body);
+    break;
+    case YRC_AST_DECL_VAR:
+      var(cg, node);
+      end_statement(cg);
+    break;
+    case YRC_AST_DECL_FUNCTION:
+      function(cg, node);
+    break;
+    default:
+      /* labels and `with` aren't parsed yet */
+      cg->w.err = 1;
+    break;
+  }
+}
+
+YRC_EXTERN int yrc_codegen(yrc_ast_node_t* root, yrc_output_t* output, int flags) {
+  return yrc_codegen_map(root, output, NULL, NULL, flags);
+}
+
+YRC_EXTERN int yrc_codegen_map(yrc_ast_node_t* root, yrc_output_t* output,
+                               yrc_output_t* map, const char* source, int flags) {
+  char fallback[kFallbackBuffer];
+  char map_fallback[kFallbackBuffer];
+  yrc_llist_iter_t iter;
+  codegen_t cg;
+  size_t count;
+  int rc;
+
+  yrc_writer_init(&cg.w, output, fallback, sizeof(fallback));
+  yrc_parser_binding_powers(cg.lbp);
+  cg.minify = (flags & YRC_CODEGEN_MINIFY) != 0;
+  cg.no_in = 0;
+  cg.semicolon = 0;
+  cg.last = 0;
+  cg.depth = 0;
+  cg.paren = NULL;
+  cg.mapping = map != NULL;
+  cg.segments = 0;
+  cg.mark = NULL;
+  cg.line_start = 0;
+  cg.skew = 0;
+  cg.column = 0;
+  cg.source_line = 0;
+  cg.source_column = 0;
+  if (map) {
+    yrc_writer_init(&cg.map, map, map_fallback, sizeof(map_fallback));
+    yrc_writer_puts(&cg.map, "{\"version\":3,\"sources\":[\"");
+    if (source) {
+      yrc_writer_json_str(&cg.map, source, strlen(source));
+    }
+    yrc_writer_puts(&cg.map, "\"],\"names\":[],\"mappings\":\"");
+  }
+
+  if (root->kind != YRC_AST_PROGRAM) {
+    stmt(&cg, root);
+  } else {
+    count = each(root->data.as_program.body, &iter);
+    while (count-- && !cg.w.err) {
+      stmt(&cg, yrc_llist_iter_next(&iter));
+      if (count) {
+        newline(&cg);
+      }
+    }
+  }
+  /* the owed `;` is kept at the very end: a trailing number needs it */
+  if (cg.semicolon) {
+    yrc_writer_putc(&cg.w, ';');
+  }
+  if (!cg.minify && cg.w.total) {
+    yrc_writer_putc(&cg.w, '\n');
+  }
+  rc = yrc_writer_flush(&cg.w);
+  if (map) {
+    yrc_writer_puts(&cg.map, "\"}");
+    rc = yrc_writer_flush(&cg.map) || rc;
+  }
+  return rc;
+}
@@ -0,0 +1,256 @@
+#include "yrc-common.h"
+#include "tokenizer.h"
+#include <string.h> /* memcmp */
+
+/**
+  dependency scanning straight off the token stream: no parser, no
+  nodes. each significant token moves a small state machine through the
+  few shapes a bundler cares about,
+
+    require("x")                      YRC_DEPENDENCY_REQUIRE
+    import "x", import ... from "x"   YRC_DEPENDENCY_IMPORT
+    export ... from "x"               YRC_DEPENDENCY_EXPORT
+    import("x")                       YRC_DEPENDENCY_DYNAMIC
+
+  and anything that strays from them drops it back to looking for the
+  next. strings, comments and regexps are single tokens, so nothing
+  inside them can match. whether a `/` starts a regexp is decided as in
+  yrc-bench's tokenize mode (yrc_tokenizer_regexp_mode), except that a
+  `)` closing the head of an if, for, while or with is remembered as
+  such: a regexp can follow that one.
+
+  every token is released once passed over, so memory stays flat however
+  long the input.
+**/
+
+enum {
+  kParenDepth=256   /* deeper parens are taken for plain grouping */
+};
+
+typedef enum {
+  SCAN_NONE,
+  SCAN_CALL,          /* saw require: want `(` */
+  SCAN_CALL_STRING,   /* want the specifier */
+  SCAN_CALL_CLOSE,    /* want `)` */
+  SCAN_IMPORT,        /* a specifier, `(`, or the start of a clause */
+  SCAN_EXPORT,        /* `*` or `{` start a clause */
+  SCAN_CLAUSE,        /* in `a, {b as c}` or `* as ns`: want `from` */
+  SCAN_FROM           /* want the specifier */
+} scan_state;
+
+typedef struct deps_s {
+  yrc_dependencycb    cb;
+  void*               ctx;
+  scan_state          state;
+  yrc_dependency_kind kind;
+  yrc_token_t*        specifier;
+  size_t              braces;     /* open in the current clause */
+  size_t              parens;
+  uint_fast8_t        after_head; /* the last token closed an if (...) */
+  uint8_t             heads[kParenDepth / 8];
+} deps_t;
+
+static int is_op(yrc_token_t* token, yrc_operator_t op) {
+  return token->type == YRC_TOKEN_OPERATOR && token->info.as_operator == op;
+}
+
+static int is_kw(yrc_token_t* token, int kw) {
+  return token->type == YRC_TOKEN_KEYWORD && (int)token->info.as_keyword == kw;
+}
+
+static int is_ident(yrc_token_t* token, const char* name, size_t size) {
+  return token->type == YRC_TOKEN_IDENT &&
+         yrc_str_len(&token->info.as_ident.str) == size &&
+         memcmp(yrc_str_ptr(&token->info.as_ident.str), name, size) == 0;
+}
+
+/* track which parens belong to a statement head, for the next `/` */
+static void parens(deps_t* deps, yrc_token_t* prev, yrc_token_t* token) {
+  size_t depth = deps->parens;
+  uint8_t bit;
+  deps->after_head = 0;
+  if (token->type != YRC_TOKEN_OPERATOR) {
+    return;
+  }
+  if (token->info.as_operator == YRC_OP_LPAREN) {
+    if (depth < kParenDepth) {
+      bit = 1 << (depth & 7);
+      if (prev && (is_kw(prev, YRC_KW_IF) || is_kw(prev, YRC_KW_FOR) ||
+                   is_kw(prev, YRC_KW_WHILE) || is_kw(prev, YRC_KW_WITH))) {
+        deps->heads[depth >> 3] |= bit;
+      } else {
+        deps->heads[depth >> 3] &= ~bit;
+      }
+    }
+    ++deps->parens;
+  } else if (token->info.as_operator == YRC_OP_RPAREN && depth) {
+    depth = --deps->parens;
+    deps->after_head = depth < kParenDepth && (deps->heads[depth >> 3] & (1 << (depth & 7)));
+  }
+}
+
+/* where a token that isn't part of a pattern in progress may start one */
+static void start(deps_t* deps, yrc_token_t* prev, yrc_token_t* token) {
+  /* obj.require(...) and import.meta are someone else's */
+  if (prev && is_op(prev, YRC_OP_DOT)) {
+    return;
+  }
+  if (is_ident(token, "require", 7)) {
+    deps->kind = YRC_DEPENDENCY_REQUIRE;
+    deps->state = SCAN_CALL;
+  } else if (is_kw(token, YRC_KW_IMPORT)) {
+    deps->state = SCAN_IMPORT;
+  } else if (is_kw(token, YRC_KW_EXPORT)) {
+    deps->state = SCAN_EXPORT;
+  }
+}
+
+/* returns -1 to look at `token` again from SCAN_NONE */
+static int clause(deps_t* deps, yrc_token_t* token) {
+  switch (token->type) {
+    case YRC_TOKEN_IDENT:
+      if (deps->braces == 0 && is_ident(token, "from", 4)) {
+        deps->state = SCAN_FROM;
+      }
+      return 0;
+    case YRC_TOKEN_KEYWORD:
+      /* `{default as x}`; outside braces a keyword starts something else */
+      return deps->braces ? 0 : -1;
+    case YRC_TOKEN_OPERATOR:
+      switch (token->info.as_operator) {
+        case YRC_OP_COMMA:
+        case YRC_OP_MUL:
+          return 0;
+        case YRC_OP_LBRACE:
+          ++deps->braces;
+          return deps->braces == 1 ? 0 : -1;
+        case YRC_OP_RBRACE:
+          if (deps->braces == 0) {
+            return -1;
+          }
+          --deps->braces;
+          return 0;
+        default:
+          return -1;
+      }
+    default:
+      return -1;
+  }
+}
+
+/* returns -1 to look at `token` again from SCAN_NONE */
+static int step(deps_t* deps, yrc_token_t* token) {
+  switch (deps->state) {
+    case SCAN_CALL:
+      if (!is_op(token, YRC_OP_LPAREN)) {
+        return -1;
+      }
+      deps->state = SCAN_CALL_STRING;
+      return 0;
+    case SCAN_CALL_STRING:
+      if (token->type != YRC_TOKEN_STRING) {
+        return -1;
+      }
+      deps->specifier = token;
+      deps->state = SCAN_CALL_CLOSE;
+      return 0;
+    case SCAN_CALL_CLOSE:
+      /* require("x" + y) isn't static */
+      if (!is_op(token, YRC_OP_RPAREN)) {
+        return -1;
+      }
+      deps->state = SCAN_NONE;
+      return deps->cb(deps->kind, deps->specifier, deps->ctx) ? 1 : 0;
+    case SCAN_IMPORT:
+      if (token->type == YRC_TOKEN_STRING) {
+        deps->state = SCAN_NONE;
+        return deps->cb(YRC_DEPENDENCY_IMPORT, token, deps->ctx) ? 1 : 0;
+      }
+      if (is_op(token, YRC_OP_LPAREN)) {
+        deps->kind = YRC_DEPENDENCY_DYNAMIC;
+        deps->state = SCAN_CALL_STRING;
+        return 0;
+      }
+      if (token->type != YRC_TOKEN_IDENT && !is_op(token, YRC_OP_MUL) &&
+          !is_op(token, YRC_OP_LBRACE)) {
+        return -1;
+      }
+      deps->kind = YRC_DEPENDENCY_IMPORT;
+      deps->braces = 0;
+      deps->state = SCAN_CLAUSE;
+      return clause(deps, token);
+    case SCAN_EXPORT:
+      /* export var, export function, export default: nothing to fetch */
+      if (!is_op(token, YRC_OP_MUL) && !is_op(token, YRC_OP_LBRACE)) {
+        return -1;
+      }
+      deps->kind = YRC_DEPENDENCY_EXPORT;
+      deps->braces = 0;
+      deps->state = SCAN_CLAUSE;
+      return clause(deps, token);
+    case SCAN_CLAUSE:
+      return clause(deps, token);
+    case SCAN_FROM:
+      if (token->type != YRC_TOKEN_STRING) {
+        return -1;
+      }
+      deps->state = SCAN_NONE;
+      return deps->cb(deps->kind, token, deps->ctx) ? 1 : 0;
+    default:
+      return -1;
+  }
+}
+
+YRC_EXTERN int yrc_scan_dependencies(yrc_parse_request_t* req, yrc_dependencycb cb, void* ctx) {
+  yrc_tokenizer_t* tokenizer;
+  yrc_token_t* prev = NULL;
+  yrc_token_t* token = NULL;
+  yrc_scan_allow_regexp mode;
+  deps_t deps;
+  int rc = 1;
+  int moved;
+
+  deps.cb = cb;
+  deps.ctx = ctx;
+  deps.state = SCAN_NONE;
+  deps.kind = YRC_DEPENDENCY_REQUIRE;
+  deps.specifier = NULL;
+  deps.braces = 0;
+  deps.parens = 0;
+  deps.after_head = 0;
+  if (yrc_tokenizer_init(&tokenizer, req->readsize, req->readctx)) {
+    return 1;
+  }
+  for (;;) {
+    if (yrc_tokenizer_scan(tokenizer, req->read, &token, YRC_ISNT_REGEXP)) {
+      break;
+    }
+    if (token == NULL) {
+      rc = 0;
+      break;
+    }
+    if (token->type == YRC_TOKEN_WHITESPACE || token->type == YRC_TOKEN_COMMENT) {
+      continue;
+    }
+    mode = yrc_tokenizer_regexp_mode(deps.after_head ? NULL : prev, token);
+    if (mode != YRC_ISNT_REGEXP &&
+        yrc_tokenizer_scan(tokenizer, req->read, &token, mode)) {
+      break;
+    }
+    parens(&deps, prev, token);
+    moved = deps.state == SCAN_NONE ? -1 : step(&deps, token);
+    if (moved > 0) {
+      break;
+    }
+    if (moved < 0) {
+      deps.state = SCAN_NONE;
+      start(&deps, prev, token);
+    }
+    prev = token;
+    if (yrc_tokenizer_release(tokenizer, prev)) {
+      break;
+    }
+  }
+  yrc_tokenizer_free(tokenizer);
+  return rc;
+}
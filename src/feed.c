@@ -0,0 +1,244 @@
+#if defined(__APPLE__) && !defined(_XOPEN_SOURCE)
+# define _XOPEN_SOURCE 600  /* for the (deprecated) ucontext routines */
+#endif
+#include "yrc-common.h"
+#include "parser.h"
+#include <string.h> /* memcpy, memmove */
+
+#ifndef _WIN32
+# include <ucontext.h>
+#endif
+
+/**
+  push-mode parsing. yrc_parse pulls its input through a yrc_readcb and
+  recurses as deep as the source nests, so rather than unwinding the
+  parser into an explicit stack, each yrc_parser_t runs yrc_parse on a
+  stack of its own as a coroutine. the read callback it's given switches
+  back to whoever called yrc_parser_feed whenever the fed bytes run out,
+  and the next feed switches in again right where the parse left off.
+  nothing blocks and nothing needs a thread, so one thread can keep as
+  many parses in flight as it has memory for stacks. a request budget
+  switches back the same way, between tokens, leaving the parse to be
+  resumed whenever the caller likes.
+
+  on windows there's no ucontext: fed bytes are buffered until the end of
+  input, then parsed in one go, and a spent budget fails the parse.
+**/
+
+enum {
+  kFeedStack=8 << 20   /* default coroutine stack: what a main thread gets */
+};
+
+struct yrc_parser_s {
+  yrc_parse_request_t   req;
+  yrc_parse_response_t* response;
+  const char*           data;       /* fed, not yet read */
+  size_t                size;
+  uint_fast8_t          ended;      /* fed an empty chunk */
+  uint_fast8_t          closing;    /* fail at the next yield */
+  int                   status;
+#ifdef _WIN32
+  char*                 buffer;
+  size_t                buffered;
+  size_t                capacity;
+  size_t                offset;
+#else
+  ucontext_t            caller;
+  ucontext_t            parse;
+  char*                 stack;
+  size_t                stack_size;
+  char*                 kept;       /* fed bytes left over at a yield */
+  size_t                kept_size;
+#endif
+};
+
+#ifdef _WIN32
+static size_t feed_read(char* data, size_t desired, void* ctx) {
+  yrc_parser_t* parser = ctx;
+  size_t toread = parser->buffered - parser->offset;
+  if (toread > desired) {
+    toread = desired;
+  }
+  memcpy(data, parser->buffer + parser->offset, toread);
+  parser->offset += toread;
+  return toread;
+}
+
+static int buffer(yrc_parser_t* parser, const char* data, size_t size) {
+  char* grown;
+  if (parser->buffered + size > parser->capacity) {
+    parser->capacity = npot(parser->buffered + size);
+    grown = realloc(parser->buffer, parser->capacity);
+    if (grown == NULL) {
+      return 1;
+    }
+    parser->buffer = grown;
+  }
+  memcpy(parser->buffer + parser->buffered, data, size);
+  parser->buffered += size;
+  return 0;
+}
+#else
+/* runs on the parser's stack; only returns once the input has ended */
+static size_t feed_read(char* data, size_t desired, void* ctx) {
+  yrc_parser_t* parser = ctx;
+  size_t toread;
+  while (parser->size == 0 && !parser->ended) {
+    swapcontext(&parser->parse, &parser->caller);
+  }
+  if (parser->ended) {
+    return 0;
+  }
+  toread = parser->size < desired ? parser->size : desired;
+  memcpy(data, parser->data, toread);
+  parser->data += toread;
+  parser->size -= toread;
+  return toread;
+}
+
+/* the budget is spent: wait for yrc_parser_resume */
+static int yield(void* ctx) {
+  yrc_parser_t* parser = ctx;
+  if (!parser->closing) {
+    parser->status = YRC_FEED_YIELD;
+    swapcontext(&parser->parse, &parser->caller);
+  }
+  return parser->closing;
+}
+
+/* makecontext only passes ints, so the pointer comes in halves */
+static void run(unsigned int hi, unsigned int lo) {
+  yrc_parser_t* parser = (yrc_parser_t*)(((uintptr_t)hi << 16 << 16) | lo);
+  parser->status = yrc_parse_exhaustible(&parser->req, &parser->response, yield, parser) ?
+    YRC_FEED_ERROR : YRC_FEED_DONE;
+}
+
+static int step(yrc_parser_t* parser) {
+  if (swapcontext(&parser->caller, &parser->parse)) {
+    parser->status = YRC_FEED_ERROR;
+  }
+  if (parser->status != YRC_FEED_YIELD || parser->size == 0) {
+    /* don't leave a pointer to the caller's bytes behind */
+    parser->data = NULL;
+    parser->size = 0;
+    return parser->status;
+  }
+  /* the rest of this feed has to outlast it */
+  if (parser->data != parser->kept) {
+    if (parser->size > parser->kept_size) {
+      free(parser->kept);
+      parser->kept = malloc(parser->size);
+      parser->kept_size = parser->kept ? parser->size : 0;
+      if (parser->kept == NULL) {
+        /* let the parse fail now, while it can still clean up */
+        parser->closing = 1;
+        parser->size = 0;
+        return step(parser);
+      }
+    }
+    memmove(parser->kept, parser->data, parser->size);
+    parser->data = parser->kept;
+  }
+  return parser->status;
+}
+#endif
+
+YRC_EXTERN int yrc_parser_init(yrc_parser_t** out, yrc_parse_request_t* req, size_t stacksize) {
+  yrc_parser_t* parser = calloc(1, sizeof(*parser));
+  if (parser == NULL) {
+    return 1;
+  }
+  parser->req = *req;
+  parser->req.read = feed_read;
+  parser->req.readctx = parser;
+  parser->status = YRC_FEED_NEED_MORE;
+#ifndef _WIN32
+  /* getcontext returns twice, so nothing it spans may be assigned to */
+  parser->stack_size = stacksize ? stacksize : kFeedStack;
+  parser->stack = malloc(parser->stack_size);
+  if (parser->stack == NULL || getcontext(&parser->parse)) {
+    free(parser->stack);
+    free(parser);
+    return 1;
+  }
+  parser->parse.uc_stack.ss_sp = parser->stack;
+  parser->parse.uc_stack.ss_size = parser->stack_size;
+  parser->parse.uc_link = &parser->caller;
+  makecontext(&parser->parse, (void (*)(void))run, 2,
+              (unsigned int)((uintptr_t)parser >> 16 >> 16),
+              (unsigned int)(uintptr_t)parser);
+#endif
+  *out = parser;
+  return 0;
+}
+
+/**
+  the parse runs until it has read all of `data` and wants more, or has
+  finished. the bytes are copied as they're read, so they needn't outlive
+  the call.
+**/
+YRC_EXTERN int yrc_parser_feed(yrc_parser_t* parser, const char* data, size_t size) {
+  if (parser->status != YRC_FEED_NEED_MORE) {
+    return parser->status;
+  }
+#ifdef _WIN32
+  if (size) {
+    if (buffer(parser, data, size)) {
+      parser->status = YRC_FEED_ERROR;
+    }
+    return parser->status;
+  }
+  parser->status = yrc_parse(&parser->req, &parser->response) ?
+    YRC_FEED_ERROR : YRC_FEED_DONE;
+#else
+  parser->data = data;
+  parser->size = size;
+  parser->ended = size == 0;
+  return step(parser);
+#endif
+  return parser->status;
+}
+
+YRC_EXTERN int yrc_parser_resume(yrc_parser_t* parser) {
+  if (parser->status != YRC_FEED_YIELD) {
+    return parser->status;
+  }
+#ifdef _WIN32
+  return parser->status;
+#else
+  parser->status = YRC_FEED_NEED_MORE;
+  return step(parser);
+#endif
+}
+
+/* a failed parse's response says why, as yrc_parse's does */
+YRC_EXTERN int yrc_parser_response(yrc_parser_t* parser, yrc_parse_response_t** out) {
+  *out = NULL;
+  if (parser->status != YRC_FEED_DONE && parser->status != YRC_FEED_ERROR) {
+    return 1;
+  }
+  *out = parser->response;
+  parser->response = NULL;
+  return parser->status != YRC_FEED_DONE || *out == NULL;
+}
+
+YRC_EXTERN int yrc_parser_free(yrc_parser_t* parser) {
+#ifdef _WIN32
+  free(parser->buffer);
+#else
+  /* a parse still waiting is ended, so that it frees its own */
+  parser->closing = 1;
+  if (parser->status == YRC_FEED_YIELD) {
+    yrc_parser_resume(parser);
+  } else if (parser->status == YRC_FEED_NEED_MORE) {
+    yrc_parser_feed(parser, NULL, 0);
+  }
+  free(parser->stack);
+  free(parser->kept);
+#endif
+  if (parser->response) {
+    yrc_parse_free(parser->response);
+  }
+  free(parser);
+  return 0;
+}
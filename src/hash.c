@@ -0,0 +1,120 @@
+#include "hash.h"
+#include <string.h> /* memcpy */
+
+/* spelled out in halves to stay clear of C90's lack of long long literals */
+#define U64(HI, LO) (((uint64_t)(HI) << 32) | (uint64_t)(LO))
+#define PRIME1 U64(0x9E3779B1, 0x85EBCA87)
+#define PRIME2 U64(0xC2B2AE3D, 0x27D4EB4F)
+#define PRIME3 U64(0x165667B1, 0x9E3779F9)
+#define PRIME4 U64(0x85EBCA77, 0xC2B2AE63)
+#define PRIME5 U64(0x27D4EB2F, 0x165667C5)
+
+static inline uint64_t rotl(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+/* little-endian loads, whatever the host */
+static inline uint64_t read64(const uint8_t* p) {
+  return (uint64_t)p[0] | ((uint64_t)p[1] << 8) |
+         ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+         ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) |
+         ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+         ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input) {
+  acc += input * PRIME2;
+  acc = rotl(acc, 31);
+  return acc * PRIME1;
+}
+
+static inline uint64_t merge64(uint64_t acc, uint64_t val) {
+  acc ^= round64(0, val);
+  return acc * PRIME1 + PRIME4;
+}
+
+static void stripe(yrc_hash_t* hash, const uint8_t* p) {
+  hash->acc[0] = round64(hash->acc[0], read64(p));
+  hash->acc[1] = round64(hash->acc[1], read64(p + 8));
+  hash->acc[2] = round64(hash->acc[2], read64(p + 16));
+  hash->acc[3] = round64(hash->acc[3], read64(p + 24));
+}
+
+void yrc_hash_init(yrc_hash_t* hash, uint64_t seed) {
+  hash->acc[0] = seed + PRIME1 + PRIME2;
+  hash->acc[1] = seed + PRIME2;
+  hash->acc[2] = seed;
+  hash->acc[3] = seed - PRIME1;
+  hash->seed = seed;
+  hash->total = 0;
+  hash->buflen = 0;
+}
+
+void yrc_hash_update(yrc_hash_t* hash, const void* data, size_t size) {
+  const uint8_t* p = data;
+  const uint8_t* end = p + size;
+  size_t fill;
+
+  hash->total += size;
+  if (hash->buflen) {
+    fill = 32 - hash->buflen;
+    if (size < fill) {
+      memcpy(hash->buf + hash->buflen, p, size);
+      hash->buflen += size;
+      return;
+    }
+    memcpy(hash->buf + hash->buflen, p, fill);
+    stripe(hash, hash->buf);
+    p += fill;
+    hash->buflen = 0;
+  }
+  while (end - p >= 32) {
+    stripe(hash, p);
+    p += 32;
+  }
+  memcpy(hash->buf, p, end - p);
+  hash->buflen = end - p;
+}
+
+uint64_t yrc_hash_digest(yrc_hash_t* hash) {
+  const uint8_t* p = hash->buf;
+  const uint8_t* end = p + hash->buflen;
+  uint64_t h;
+
+  if (hash->total >= 32) {
+    h = rotl(hash->acc[0], 1) + rotl(hash->acc[1], 7) +
+        rotl(hash->acc[2], 12) + rotl(hash->acc[3], 18);
+    h = merge64(h, hash->acc[0]);
+    h = merge64(h, hash->acc[1]);
+    h = merge64(h, hash->acc[2]);
+    h = merge64(h, hash->acc[3]);
+  } else {
+    h = hash->seed + PRIME5;
+  }
+  h += hash->total;
+
+  for (; end - p >= 8; p += 8) {
+    h ^= round64(0, read64(p));
+    h = rotl(h, 27) * PRIME1 + PRIME4;
+  }
+  if (end - p >= 4) {
+    h ^= (uint64_t)read32(p) * PRIME1;
+    h = rotl(h, 23) * PRIME2 + PRIME3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    h ^= *p * PRIME5;
+    h = rotl(h, 11) * PRIME1;
+  }
+
+  h ^= h >> 33;
+  h *= PRIME2;
+  h ^= h >> 29;
+  h *= PRIME3;
+  h ^= h >> 32;
+  return h;
+}
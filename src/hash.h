@@ -0,0 +1,22 @@
+#ifndef _YRC_HASH_H
+#define _YRC_HASH_H
+#include "yrc-common.h"
+
+/**
+  streaming 64-bit xxhash (XXH64). not cryptographic: it's only used to
+  name cache entries, where speed matters and collisions are vanishingly
+  unlikely for the inputs we see.
+**/
+typedef struct yrc_hash_s {
+  uint64_t  acc[4];
+  uint64_t  seed;
+  uint64_t  total;
+  uint8_t   buf[32];
+  size_t    buflen;
+} yrc_hash_t;
+
+void yrc_hash_init(yrc_hash_t*, uint64_t);
+void yrc_hash_update(yrc_hash_t*, const void*, size_t);
+uint64_t yrc_hash_digest(yrc_hash_t*);
+
+#endif
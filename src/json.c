@@ -0,0 +1,767 @@
+#include "yrc-common.h"
+#include "parser.h"
+#include "tokenizer.h"
+#include "output.h"
+#include <stdio.h>  /* sprintf */
+#include <string.h> /* memchr */
+
+/**
+  ESTree JSON, written straight from the tree in one recursive pass.
+  every node is an object whose first key is `type`, with `range` and
+  `loc` last. positions come from the node's first and last tokens;
+  nodes built without them (object keys, member properties) fall back to
+  their own token, and the program to the extent of its body.
+
+  a few shapes differ between the trees and ESTree:
+
+  - `new` is a unary node whose argument swallowed the call after it,
+    so `new a.b(c).d` arrives as new(member(call(member(a, b), c), d)).
+    the innermost call on that chain is the one `new` applies to; the
+    chain is written back out with that call as the NewExpression.
+  - prefix `++` and `--` are unary nodes; they become UpdateExpressions.
+  - sequences nest to the right.
+  - `true`, `false` and `null` are identifiers.
+  - a catch clause followed by `finally` keeps the finalizer itself.
+**/
+
+enum {
+  kFallbackBuffer=4096,
+  kIndentWidth=2
+};
+
+typedef struct pos_s {
+  const yrc_position_t* start;
+  const yrc_position_t* end;
+} pos_t;
+
+typedef struct json_s {
+  yrc_writer_t  w;
+  uint_fast8_t  compact;
+  uint_fast8_t  positions;
+  size_t        depth;
+} json_t;
+
+static const char kSpaces[] = "                                ";
+
+static void emit(json_t*, yrc_ast_node_t*, pos_t*);
+
+static void pos_token(pos_t* pos, yrc_token_t* token) {
+  pos->start = &token->start;
+  pos->end = &token->end;
+}
+
+/* widen `pos` to cover `other` too */
+static void pos_merge(pos_t* pos, const pos_t* other) {
+  if (other->start == NULL) {
+    return;
+  }
+  if (pos->start == NULL || other->start->fpos < pos->start->fpos) {
+    pos->start = other->start;
+  }
+  if (pos->end == NULL || other->end->fpos > pos->end->fpos) {
+    pos->end = other->end;
+  }
+}
+
+static void newline(json_t* json) {
+  size_t indent;
+  size_t chunk;
+  if (json->compact) {
+    return;
+  }
+  yrc_writer_putc(&json->w, '\n');
+  for (indent = json->depth * kIndentWidth; indent; indent -= chunk) {
+    chunk = indent < sizeof(kSpaces) - 1 ? indent : sizeof(kSpaces) - 1;
+    yrc_writer_putv(&json->w, kSpaces, chunk);
+  }
+}
+
+static void key(json_t* json, const char* compact, size_t compact_size, const char* pretty, size_t pretty_size) {
+  if (json->compact) {
+    yrc_writer_putv(&json->w, compact, compact_size);
+    return;
+  }
+  yrc_writer_putc(&json->w, ',');
+  newline(json);
+  yrc_writer_putv(&json->w, pretty, pretty_size);
+}
+
+#define KEY(JSON, NAME) \
+  key(JSON, ",\"" NAME "\":", sizeof(",\"" NAME "\":") - 1, "\"" NAME "\": ", sizeof("\"" NAME "\": ") - 1)
+
+static void open_node(json_t* json, const char* type, size_t size) {
+  yrc_writer_putc(&json->w, '{');
+  ++json->depth;
+  newline(json);
+  if (json->compact) {
+    yrc_writer_puts(&json->w, "\"type\":\"");
+  } else {
+    yrc_writer_puts(&json->w, "\"type\": \"");
+  }
+  yrc_writer_putv(&json->w, type, size);
+  yrc_writer_putc(&json->w, '"');
+}
+
+#define OPEN(JSON, TYPE) open_node(JSON, TYPE, sizeof(TYPE) - 1)
+
+static void string(json_t* json, const char* data, size_t size) {
+  yrc_writer_putc(&json->w, '"');
+  yrc_writer_json_str(&json->w, data, size);
+  yrc_writer_putc(&json->w, '"');
+}
+
+enum {
+  kValueStack=256   /* decoded string values up to this size stay off the heap */
+};
+
+/**
+  a decoded value keeps any lone surrogate an escape spelled as WTF-8,
+  which isn't UTF-8; JSON gets those back as \uXXXX, as codegen.c does.
+**/
+static void decoded_string(json_t* json, const char* data, size_t size) {
+  const unsigned char* str = (const unsigned char*)data;
+  const unsigned char* lead;
+  char esc[7];
+  size_t run = 0;
+  size_t i = 0;
+  yrc_writer_putc(&json->w, '"');
+  while ((lead = memchr(str + i, 0xed, size - i)) != NULL) {
+    i = lead - str;
+    if (i + 2 < size && str[i + 1] >= 0xa0) {
+      yrc_writer_json_str(&json->w, data + run, i - run);
+      sprintf(esc, "\\u%04x", 0xd000 | (str[i + 1] & 0x3f) << 6 | (str[i + 2] & 0x3f));
+      yrc_writer_putv(&json->w, esc, 6);
+      i += 2;
+      run = i + 1;
+    }
+    ++i;
+  }
+  yrc_writer_json_str(&json->w, data + run, size - run);
+  yrc_writer_putc(&json->w, '"');
+}
+
+/* a string token's value, decoded if it has escapes */
+static void string_value(json_t* json, yrc_token_t* token) {
+  yrc_str_t* str = &token->info.as_string.str;
+  size_t size = yrc_str_len(str);
+  char stack[kValueStack];
+  char* buf = stack;
+  size_t len;
+  if (!token->info.as_string.has_escapes) {
+    string(json, yrc_str_ptr(str), size);
+    return;
+  }
+  if (size > sizeof(stack) && (buf = malloc(size)) == NULL) {
+    json->w.err = 1;
+    return;
+  }
+  if (yrc_token_string_value(token, buf, size, &len)) {
+    json->w.err = 1;
+  } else {
+    decoded_string(json, buf, len);
+  }
+  if (buf != stack) {
+    free(buf);
+  }
+}
+
+static void boolean(json_t* json, int value) {
+  if (value) {
+    yrc_writer_puts(&json->w, "true");
+  } else {
+    yrc_writer_puts(&json->w, "false");
+  }
+}
+
+static void point(json_t* json, const yrc_position_t* pos) {
+  /* columns count from 1 after the first newline; see yrc_tokenizer_scan */
+  size_t column = pos->line > 1 && pos->col ? pos->col - 1 : pos->col;
+  if (json->compact) {
+    yrc_writer_puts(&json->w, "{\"line\":");
+    yrc_writer_uint(&json->w, pos->line);
+    yrc_writer_puts(&json->w, ",\"column\":");
+  } else {
+    yrc_writer_puts(&json->w, "{\"line\": ");
+    yrc_writer_uint(&json->w, pos->line);
+    yrc_writer_puts(&json->w, ", \"column\": ");
+  }
+  yrc_writer_uint(&json->w, column);
+  yrc_writer_putc(&json->w, '}');
+}
+
+/* finish a node: its extent is `exact` if known, else what its children covered */
+static void close_node(json_t* json, pos_t* pos, const pos_t* exact, pos_t* out) {
+  if (exact && exact->start) {
+    *pos = *exact;
+  }
+  if (json->positions && pos->start) {
+    KEY(json, "range");
+    yrc_writer_putc(&json->w, '[');
+    yrc_writer_uint(&json->w, pos->start->fpos);
+    yrc_writer_putv(&json->w, ", ", json->compact ? 1 : 2);
+    yrc_writer_uint(&json->w, pos->end->fpos);
+    yrc_writer_putc(&json->w, ']');
+    KEY(json, "loc");
+    if (json->compact) {
+      yrc_writer_puts(&json->w, "{\"start\":");
+      point(json, pos->start);
+      yrc_writer_puts(&json->w, ",\"end\":");
+    } else {
+      yrc_writer_puts(&json->w, "{\"start\": ");
+      point(json, pos->start);
+      yrc_writer_puts(&json->w, ", \"end\": ");
+    }
+    point(json, pos->end);
+    yrc_writer_putc(&json->w, '}');
+  }
+  --json->depth;
+  newline(json);
+  yrc_writer_putc(&json->w, '}');
+  if (out) {
+    *out = *pos;
+  }
+}
+
+/* a node that may be missing, widening `pos` by its extent */
+static void child(json_t* json, yrc_ast_node_t* node, pos_t* pos) {
+  pos_t inner = {NULL, NULL};
+  if (node == NULL) {
+    yrc_writer_puts(&json->w, "null");
+    return;
+  }
+  emit(json, node, &inner);
+  pos_merge(pos, &inner);
+}
+
+static void token_ident(json_t* json, yrc_token_t* token, pos_t* pos) {
+  pos_t inner = {NULL, NULL};
+  if (token == NULL) {
+    yrc_writer_puts(&json->w, "null");
+    return;
+  }
+  pos_token(&inner, token);
+  OPEN(json, "Identifier");
+  KEY(json, "name");
+  string(json, yrc_str_ptr(&token->info.as_ident.str), yrc_str_len(&token->info.as_ident.str));
+  close_node(json, &inner, NULL, NULL);
+  pos_merge(pos, &inner);
+}
+
+static void list(json_t* json, yrc_llist_t* items, pos_t* pos) {
+  yrc_llist_iter_t iter;
+  yrc_ast_node_t* item;
+  pos_t inner;
+  size_t count = items ? yrc_llist_len(items) : 0;
+  size_t i;
+
+  yrc_writer_putc(&json->w, '[');
+  if (count == 0) {
+    yrc_writer_putc(&json->w, ']');
+    return;
+  }
+  ++json->depth;
+  iter = yrc_llist_iter_start(items);
+  for (i = 0; i < count && !json->w.err; ++i) {
+    item = yrc_llist_iter_next(&iter);
+    if (i) {
+      yrc_writer_putc(&json->w, ',');
+    }
+    newline(json);
+    if (item == NULL) {
+      yrc_writer_puts(&json->w, "null");
+      continue;
+    }
+    inner.start = NULL;
+    emit(json, item, &inner);
+    pos_merge(pos, &inner);
+  }
+  --json->depth;
+  newline(json);
+  yrc_writer_putc(&json->w, ']');
+}
+
+static int is_word(yrc_token_t* token, const char* word, size_t size) {
+  return yrc_str_len(&token->info.as_ident.str) == size &&
+         memcmp(yrc_str_ptr(&token->info.as_ident.str), word, size) == 0;
+}
+
+/* an object key or non-computed member property: never a keyword literal */
+static void name(json_t* json, yrc_ast_node_t* node, pos_t* pos) {
+  yrc_token_t* token;
+  pos_t inner;
+  if (node->kind != YRC_AST_EXPR_IDENTIFIER) {
+    child(json, node, pos);
+    return;
+  }
+  token = node->data.as_ident.name;
+  if (token->type != YRC_TOKEN_STRING) {
+    token_ident(json, token, pos);
+    return;
+  }
+  pos_token(&inner, token);
+  OPEN(json, "Literal");
+  KEY(json, "value");
+  string_value(json, token);
+  close_node(json, &inner, NULL, NULL);
+  pos_merge(pos, &inner);
+}
+
+static void literal(json_t* json, yrc_token_t* token) {
+  yrc_token_number_t* number;
+  yrc_regexp_flags flags;
+
+  OPEN(json, "Literal");
+  KEY(json, "value");
+  switch (token->type) {
+    case YRC_TOKEN_NUMBER:
+      number = &token->info.as_number;
+      if (number->repr & REPR_IS_FLOAT) {
+        yrc_writer_double(&json->w, number->data.as_double);
+      } else {
+        yrc_writer_uint(&json->w, number->data.as_int);
+      }
+    break;
+    case YRC_TOKEN_STRING:
+      string_value(json, token);
+    break;
+    case YRC_TOKEN_REGEXP:
+      flags = token->info.as_regexp.flags;
+      yrc_writer_puts(&json->w, "null");
+      KEY(json, "regex");
+      if (json->compact) {
+        yrc_writer_puts(&json->w, "{\"pattern\":");
+      } else {
+        yrc_writer_puts(&json->w, "{\"pattern\": ");
+      }
+      string(json, yrc_str_ptr(&token->info.as_regexp.str), yrc_str_len(&token->info.as_regexp.str));
+      if (json->compact) {
+        yrc_writer_puts(&json->w, ",\"flags\":\"");
+      } else {
+        yrc_writer_puts(&json->w, ", \"flags\": \"");
+      }
+      if (flags & YRC_REGEXP_GLOBAL) yrc_writer_putc(&json->w, 'g');
+      if (flags & YRC_REGEXP_IGNORECASE) yrc_writer_putc(&json->w, 'i');
+      if (flags & YRC_REGEXP_MULTILINE) yrc_writer_putc(&json->w, 'm');
+      if (flags & YRC_REGEXP_STICKY) yrc_writer_putc(&json->w, 'y');
+      yrc_writer_puts(&json->w, "\"}");
+    break;
+    default:
+      /* `true`, `false` and `null` */
+      yrc_writer_putv(&json->w, yrc_str_ptr(&token->info.as_ident.str), yrc_str_len(&token->info.as_ident.str));
+    break;
+  }
+}
+
+static void op_string(json_t* json, yrc_operator_t op) {
+  const char* str = TOKEN_OPERATOR_MAP[op];
+  string(json, str, strlen(str));
+}
+
+/* the call on a `new` argument's member/call chain that `new` applies to */
+static yrc_ast_node_t* new_target(yrc_ast_node_t* node) {
+  yrc_ast_node_t* target = NULL;
+  while (!node->has_parens) {
+    if (node->kind == YRC_AST_EXPR_CALL) {
+      target = node;
+      node = node->data.as_call.callee;
+    } else if (node->kind == YRC_AST_EXPR_MEMBER) {
+      node = node->data.as_member.object;
+    } else {
+      break;
+    }
+  }
+  return target;
+}
+
+static void chain(json_t*, yrc_ast_node_t*, yrc_ast_node_t*, const yrc_position_t*, pos_t*);
+
+static void member(json_t* json, yrc_ast_node_t* node, yrc_ast_node_t* target, const yrc_position_t* start, pos_t* pos) {
+  OPEN(json, "MemberExpression");
+  KEY(json, "computed");
+  boolean(json, node->data.as_member.computed);
+  KEY(json, "object");
+  chain(json, node->data.as_member.object, target, start, pos);
+  KEY(json, "property");
+  if (node->data.as_member.computed) {
+    child(json, node->data.as_member.property, pos);
+  } else {
+    name(json, node->data.as_member.property, pos);
+  }
+}
+
+static void call(json_t* json, yrc_ast_node_t* node, yrc_ast_node_t* target, const yrc_position_t* start, pos_t* pos) {
+  if (node == target) {
+    OPEN(json, "NewExpression");
+  } else {
+    OPEN(json, "CallExpression");
+  }
+  KEY(json, "callee");
+  chain(json, node->data.as_call.callee, node == target ? NULL : target, start, pos);
+  KEY(json, "arguments");
+  list(json, node->data.as_call.arguments, pos);
+}
+
+/**
+  write `node`, which lies on the chain under a `new` aimed at `target`.
+  everything down to the target starts where the `new` does.
+**/
+static void chain(json_t* json, yrc_ast_node_t* node, yrc_ast_node_t* target, const yrc_position_t* start, pos_t* pos) {
+  pos_t inner = {NULL, NULL};
+  pos_t exact = {NULL, NULL};
+  if (target == NULL) {
+    child(json, node, pos);
+    return;
+  }
+  if (node->kind == YRC_AST_EXPR_MEMBER) {
+    member(json, node, target, start, &inner);
+  } else {
+    call(json, node, target, start, &inner);
+  }
+  if (start && node->last) {
+    exact.start = start;
+    exact.end = &node->last->end;
+  }
+  close_node(json, &inner, &exact, NULL);
+  pos_merge(pos, &inner);
+}
+
+static void function(json_t* json, yrc_ast_node_t* node, pos_t* pos) {
+  KEY(json, "id");
+  token_ident(json, node->data.as_function.id, pos);
+  KEY(json, "params");
+  list(json, node->data.as_function.params, pos);
+  KEY(json, "body");
+  child(json, node->data.as_function.body, pos);
+  KEY(json, "generator");
+  yrc_writer_puts(&json->w, "false");
+  KEY(json, "expression");
+  yrc_writer_puts(&json->w, "false");
+  KEY(json, "async");
+  yrc_writer_puts(&json->w, "false");
+}
+
+static void emit(json_t* json, yrc_ast_node_t* node, pos_t* out) {
+  pos_t pos = {NULL, NULL};
+  pos_t exact = {NULL, NULL};
+  yrc_ast_node_t* item;
+  yrc_token_t* token;
+
+  if (node->first && node->last) {
+    exact.start = &node->first->start;
+    exact.end = &node->last->end;
+  }
+
+  switch (node->kind) {
+    case YRC_AST_PROGRAM:
+      OPEN(json, "Program");
+      KEY(json, "body");
+      list(json, node->data.as_program.body, &pos);
+      KEY(json, "sourceType");
+      yrc_writer_puts(&json->w, "\"script\"");
+    break;
+    case YRC_AST_STMT_BLOCK:
+      OPEN(json, "BlockStatement");
+      KEY(json, "body");
+      list(json, node->data.as_block.body, &pos);
+    break;
+    case YRC_AST_STMT_EMPTY:
+      OPEN(json, "EmptyStatement");
+    break;
+    case YRC_AST_STMT_EXPR:
+      OPEN(json, "ExpressionStatement");
+      KEY(json, "expression");
+      child(json, node->data.as_exprstmt.expression, &pos);
+    break;
+    case YRC_AST_STMT_IF:
+      OPEN(json, "IfStatement");
+      KEY(json, "test");
+      child(json, node->data.as_if.test, &pos);
+      KEY(json, "consequent");
+      child(json, node->data.as_if.consequent, &pos);
+      KEY(json, "alternate");
+      child(json, node->data.as_if.alternate, &pos);
+    break;
+    case YRC_AST_STMT_BREAK:
+    case YRC_AST_STMT_CONTINUE:
+      if (node->kind == YRC_AST_STMT_BREAK) {
+        OPEN(json, "BreakStatement");
+      } else {
+        OPEN(json, "ContinueStatement");
+      }
+      KEY(json, "label");
+      token_ident(json, node->data.as_break.label, &pos);
+    break;
+    case YRC_AST_STMT_SWITCH:
+      OPEN(json, "SwitchStatement");
+      KEY(json, "discriminant");
+      child(json, node->data.as_switch.discriminant, &pos);
+      KEY(json, "cases");
+      list(json, node->data.as_switch.cases, &pos);
+    break;
+    case YRC_AST_STMT_RETURN:
+    case YRC_AST_STMT_THROW:
+      if (node->kind == YRC_AST_STMT_RETURN) {
+        OPEN(json, "ReturnStatement");
+      } else {
+        OPEN(json, "ThrowStatement");
+      }
+      KEY(json, "argument");
+      child(json, node->data.as_return.argument, &pos);
+    break;
+    case YRC_AST_STMT_TRY:
+      item = node->data.as_try.finalizer;
+      if (item == NULL && node->data.as_try.handler) {
+        item = node->data.as_try.handler->data.as_try.finalizer;
+      }
+      OPEN(json, "TryStatement");
+      KEY(json, "block");
+      child(json, node->data.as_try.block, &pos);
+      KEY(json, "handler");
+      child(json, node->data.as_try.handler, &pos);
+      KEY(json, "finalizer");
+      child(json, item, &pos);
+    break;
+    case YRC_AST_CLSE_CASE:
+      OPEN(json, "SwitchCase");
+      KEY(json, "test");
+      child(json, node->data.as_case.test, &pos);
+      KEY(json, "consequent");
+      list(json, node->data.as_case.consequent, &pos);
+    break;
+    case YRC_AST_CLSE_CATCH:
+      OPEN(json, "CatchClause");
+      KEY(json, "param");
+      child(json, node->data.as_catch.param, &pos);
+      KEY(json, "body");
+      child(json, node->data.as_catch.body, &pos);
+    break;
+    case YRC_AST_CLSE_VAR:
+      OPEN(json, "VariableDeclarator");
+      KEY(json, "id");
+      child(json, node->data.as_vardecl.id, &pos);
+      KEY(json, "init");
+      child(json, node->data.as_vardecl.init, &pos);
+    break;
+    case YRC_AST_STMT_WHILE:
+      OPEN(json, "WhileStatement");
+      KEY(json, "test");
+      child(json, node->data.as_while.test, &pos);
+      KEY(json, "body");
+      child(json, node->data.as_while.body, &pos);
+    break;
+    case YRC_AST_STMT_DOWHILE:
+      OPEN(json, "DoWhileStatement");
+      KEY(json, "body");
+      child(json, node->data.as_do_while.body, &pos);
+      KEY(json, "test");
+      child(json, node->data.as_do_while.test, &pos);
+    break;
+    case YRC_AST_STMT_FOR:
+      OPEN(json, "ForStatement");
+      KEY(json, "init");
+      child(json, node->data.as_for.init, &pos);
+      KEY(json, "test");
+      child(json, node->data.as_for.test, &pos);
+      KEY(json, "update");
+      child(json, node->data.as_for.update, &pos);
+      KEY(json, "body");
+      child(json, node->data.as_for.body, &pos);
+    break;
+    case YRC_AST_STMT_FORIN:
+    case YRC_AST_STMT_FOROF:
+      if (node->kind == YRC_AST_STMT_FORIN) {
+        OPEN(json, "ForInStatement");
+      } else {
+        OPEN(json, "ForOfStatement");
+      }
+      KEY(json, "left");
+      child(json, node->data.as_for_in.left, &pos);
+      KEY(json, "right");
+      child(json, node->data.as_for_in.right, &pos);
+      KEY(json, "body");
+      child(json, node->data.as_for_in.body, &pos);
+    break;
+    case YRC_AST_DECL_FUNCTION:
+      OPEN(json, "FunctionDeclaration");
+      function(json, node, &pos);
+    break;
+    case YRC_AST_EXPR_FUNCTION:
+      OPEN(json, "FunctionExpression");
+      function(json, node, &pos);
+    break;
+    case YRC_AST_DECL_VAR:
+      OPEN(json, "VariableDeclaration");
+      KEY(json, "declarations");
+      list(json, node->data.as_var.declarations, &pos);
+      KEY(json, "kind");
+      switch (node->data.as_var.type) {
+        case YRC_VARTYPE_CONST: yrc_writer_puts(&json->w, "\"const\""); break;
+        case YRC_VARTYPE_LET: yrc_writer_puts(&json->w, "\"let\""); break;
+        default: yrc_writer_puts(&json->w, "\"var\""); break;
+      }
+    break;
+    case YRC_AST_EXPR_IDENTIFIER:
+      token = node->data.as_ident.name;
+      pos_token(&pos, token);
+      if (token->type == YRC_TOKEN_IDENT &&
+          (is_word(token, "true", 4) || is_word(token, "false", 5) || is_word(token, "null", 4))) {
+        literal(json, token);
+        break;
+      }
+      token_ident(json, token, &pos);
+      if (out) {
+        *out = pos;
+      }
+    return;
+    case YRC_AST_EXPR_THIS:
+      OPEN(json, "ThisExpression");
+    break;
+    case YRC_AST_EXPR_ARRAY:
+      OPEN(json, "ArrayExpression");
+      KEY(json, "elements");
+      list(json, node->data.as_array.elements, &pos);
+    break;
+    case YRC_AST_EXPR_OBJECT:
+      OPEN(json, "ObjectExpression");
+      KEY(json, "properties");
+      list(json, node->data.as_object.properties, &pos);
+    break;
+    case YRC_AST_EXPR_PROPERTY:
+      OPEN(json, "Property");
+      KEY(json, "key");
+      if (node->data.as_property.type & YRC_PROP_COMPUTED) {
+        child(json, node->data.as_property.key, &pos);
+      } else {
+        name(json, node->data.as_property.key, &pos);
+      }
+      KEY(json, "computed");
+      boolean(json, node->data.as_property.type & YRC_PROP_COMPUTED);
+      KEY(json, "value");
+      child(json, node->data.as_property.expression, &pos);
+      KEY(json, "kind");
+      yrc_writer_puts(&json->w, "\"init\"");
+      KEY(json, "method");
+      yrc_writer_puts(&json->w, "false");
+      KEY(json, "shorthand");
+      boolean(json, node->data.as_property.type & YRC_PROP_SHORTHAND);
+    break;
+    case YRC_AST_EXPR_SEQUENCE:
+      OPEN(json, "SequenceExpression");
+      KEY(json, "expressions");
+      yrc_writer_putc(&json->w, '[');
+      ++json->depth;
+      item = node;
+      while (item->kind == YRC_AST_EXPR_SEQUENCE && (item == node || !item->has_parens)) {
+        newline(json);
+        child(json, item->data.as_sequence.left, &pos);
+        yrc_writer_putc(&json->w, ',');
+        item = item->data.as_sequence.right;
+      }
+      newline(json);
+      child(json, item, &pos);
+      --json->depth;
+      newline(json);
+      yrc_writer_putc(&json->w, ']');
+    break;
+    case YRC_AST_EXPR_UNARY:
+      switch ((int)node->data.as_unary.op) {
+        case YRC_OP_INCR:
+        case YRC_OP_DECR:
+          OPEN(json, "UpdateExpression");
+          KEY(json, "operator");
+          op_string(json, node->data.as_unary.op);
+          KEY(json, "argument");
+          child(json, node->data.as_unary.argument, &pos);
+          KEY(json, "prefix");
+          yrc_writer_puts(&json->w, "true");
+        break;
+        case YRC_KW_NEW:
+          item = new_target(node->data.as_unary.argument);
+          if (item) {
+            chain(json, node->data.as_unary.argument, item, exact.start, &pos);
+            if (out) {
+              *out = pos;
+            }
+            return;
+          }
+          OPEN(json, "NewExpression");
+          KEY(json, "callee");
+          child(json, node->data.as_unary.argument, &pos);
+          KEY(json, "arguments");
+          yrc_writer_puts(&json->w, "[]");
+        break;
+        default:
+          OPEN(json, "UnaryExpression");
+          KEY(json, "operator");
+          op_string(json, node->data.as_unary.op);
+          KEY(json, "argument");
+          child(json, node->data.as_unary.argument, &pos);
+          KEY(json, "prefix");
+          yrc_writer_puts(&json->w, "true");
+        break;
+      }
+    break;
+    case YRC_AST_EXPR_BINARY:
+    case YRC_AST_EXPR_ASSIGNMENT:
+    case YRC_AST_EXPR_LOGICAL:
+      if (node->kind == YRC_AST_EXPR_BINARY) {
+        OPEN(json, "BinaryExpression");
+      } else if (node->kind == YRC_AST_EXPR_LOGICAL) {
+        OPEN(json, "LogicalExpression");
+      } else {
+        OPEN(json, "AssignmentExpression");
+      }
+      KEY(json, "operator");
+      op_string(json, node->data.as_binary.op);
+      KEY(json, "left");
+      child(json, node->data.as_binary.left, &pos);
+      KEY(json, "right");
+      child(json, node->data.as_binary.right, &pos);
+    break;
+    case YRC_AST_EXPR_UPDATE:
+      OPEN(json, "UpdateExpression");
+      KEY(json, "operator");
+      op_string(json, node->data.as_update.op);
+      KEY(json, "argument");
+      child(json, node->data.as_update.argument, &pos);
+      KEY(json, "prefix");
+      boolean(json, node->data.as_update.prefix);
+    break;
+    case YRC_AST_EXPR_LITERAL:
+      pos_token(&pos, node->data.as_literal.value);
+      literal(json, node->data.as_literal.value);
+    break;
+    case YRC_AST_EXPR_CONDITIONAL:
+      OPEN(json, "ConditionalExpression");
+      KEY(json, "test");
+      child(json, node->data.as_conditional.test, &pos);
+      KEY(json, "consequent");
+      child(json, node->data.as_conditional.consequent, &pos);
+      KEY(json, "alternate");
+      child(json, node->data.as_conditional.alternate, &pos);
+    break;
+    case YRC_AST_EXPR_CALL:
+      call(json, node, NULL, NULL, &pos);
+    break;
+    case YRC_AST_EXPR_MEMBER:
+      member(json, node, NULL, NULL, &pos);
+    break;
+    default:
+      /* labels, `with`, arrows and yields aren't parsed yet */
+      json->w.err = 1;
+    return;
+  }
+  close_node(json, &pos, &exact, out);
+}
+
+YRC_EXTERN int yrc_ast_to_json(yrc_ast_node_t* root, yrc_output_t* output, int flags) {
+  char fallback[kFallbackBuffer];
+  json_t json;
+
+  yrc_writer_init(&json.w, output, fallback, sizeof(fallback));
+  json.compact = (flags & YRC_JSON_COMPACT) != 0;
+  json.positions = (flags & YRC_JSON_NO_POSITIONS) == 0;
+  json.depth = 0;
+  emit(&json, root, NULL);
+  return yrc_writer_flush(&json.w);
+}
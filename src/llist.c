@@ -11,6 +11,7 @@ struct yrc_llist_s {
   yrc_llist_node_t* head;
   yrc_llist_node_t* tail;
   size_t size;
+  yrc_pool_t* pool;   /* the list's own nodes, or NULL for the shared pool */
 };
 
 
@@ -45,15 +46,18 @@ typedef struct _anyall_ctx_s {
 /* shared pool for all llist nodes */
 static yrc_pool_t* llist_node_pool = NULL;
 
-static void* alloc_node() {
+static void* alloc_node(yrc_llist_t* list) {
+  if (list->pool) {
+    return yrc_pool_attain(list->pool);
+  }
   if (llist_node_pool == NULL) {
     yrc_pool_init(&llist_node_pool, sizeof(yrc_llist_node_t));
   }
   return yrc_pool_attain(llist_node_pool);
 }
 
-static int free_node(yrc_llist_node_t* node) {
-  return yrc_pool_release(llist_node_pool, node);
+static int free_node(yrc_llist_t* list, yrc_llist_node_t* node) {
+  return yrc_pool_release(list->pool ? list->pool : llist_node_pool, node);
 }
 
 
@@ -65,20 +69,40 @@ int yrc_llist_init(yrc_llist_t** pllist) {
   }
   list->head = list->tail = NULL;
   list->size = 0;
+  list->pool = NULL;
   *pllist = list;
   return 0;
 }
 
 
+/**
+  a list with a pool of its own, freed along with it. the shared pool
+  isn't locked, so a list built off the calling thread needs one.
+**/
+int yrc_llist_init_local(yrc_llist_t** pllist) {
+  if (yrc_llist_init(pllist)) {
+    return 1;
+  }
+  if (yrc_pool_init(&(*pllist)->pool, sizeof(yrc_llist_node_t))) {
+    free(*pllist);
+    return 1;
+  }
+  return 0;
+}
+
+
 int yrc_llist_free(yrc_llist_t* list) {
   yrc_llist_node_t* current;
   yrc_llist_node_t* next;
   current = list->head;
   while(current) {
     next = current->next;
-    free_node(current);
+    free_node(list, current);
     current = next;
   }
+  if (list->pool) {
+    yrc_pool_free(list->pool);
+  }
   free(list);
   return 0;
 }
@@ -86,7 +110,7 @@ int yrc_llist_free(yrc_llist_t* list) {
 
 int yrc_llist_push(yrc_llist_t* list, void* item) {
   yrc_llist_node_t* node;
-  node = alloc_node();
+  node = alloc_node(list);
   if (node == NULL) {
     return 1;
   }
@@ -94,6 +118,7 @@ int yrc_llist_push(yrc_llist_t* list, void* item) {
   node->item = item;
   if (list->head == NULL) {
     list->head = list->tail = node;
+    ++list->size;
     return 0;
   }
   list->tail->next = node;
@@ -115,7 +140,7 @@ void* yrc_llist_pop(yrc_llist_t* list) {
   if (tail == iter) {
     item = iter->item;
     --list->size;
-    free_node(iter);
+    free_node(list, iter);
     list->head = list->tail = NULL;
     return item;
   }
@@ -124,7 +149,7 @@ void* yrc_llist_pop(yrc_llist_t* list) {
   }
   --list->size;
   item = iter->next->item;
-  free_node(iter->next);
+  free_node(list, iter->next);
   iter->next = NULL;
   list->tail = iter;
   return item;
@@ -145,13 +170,13 @@ void* yrc_llist_shift(yrc_llist_t* list) {
   if (list->head == list->tail) {
     item = list->head->item;
     --list->size;
-    free_node(list->head);
+    free_node(list, list->head);
     list->head = list->tail = NULL;
     return item;
   }
   next = list->head->next;
   item = list->head->item;
-  free_node(list->head);
+  free_node(list, list->head);
   list->head = next;
   --list->size;
   return item;
@@ -160,7 +185,7 @@ void* yrc_llist_shift(yrc_llist_t* list) {
 
 int yrc_llist_unshift(yrc_llist_t* list, void* item) {
   yrc_llist_node_t* node;
-  node = alloc_node();
+  node = alloc_node(list);
   if (node == NULL) {
     return 1;
   }
@@ -0,0 +1,171 @@
+#include "output.h"
+#include <stdio.h>  /* snprintf */
+#include <stdlib.h> /* strtod */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define YRC_OUTPUT_SSE2 1
+# include <emmintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+# endif
+#endif
+
+/**
+  what each byte turns into inside a JSON string: 0 for itself, `u` for
+  a \u00XX escape, anything else for that character after a backslash.
+**/
+static const char kEscape[256] = {
+  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+  'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+  0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0
+  /* the rest are zero */
+};
+
+static const char kHex[] = "0123456789abcdef";
+
+void yrc_writer_init(yrc_writer_t* w, yrc_output_t* out, char* fallback, size_t fallback_size) {
+  w->write = out->write;
+  w->ctx = out->writectx;
+  if (out->buffer && out->buffersize) {
+    w->buf = out->buffer;
+    w->size = out->buffersize;
+  } else {
+    w->buf = fallback;
+    w->size = fallback_size;
+  }
+  w->len = 0;
+  w->total = 0;
+  w->err = 0;
+}
+
+int yrc_writer_flush(yrc_writer_t* w) {
+  if (w->len && !w->err && w->write(w->buf, w->len, w->ctx)) {
+    w->err = 1;
+  }
+  w->len = 0;
+  return w->err;
+}
+
+void yrc_writer_putv_slow(yrc_writer_t* w, const char* data, size_t size) {
+  size_t chunk;
+  w->total += size;
+  while (size) {
+    if (w->len == w->size) {
+      yrc_writer_flush(w);
+    }
+    chunk = w->size - w->len;
+    if (chunk > size) {
+      chunk = size;
+    }
+    memcpy(w->buf + w->len, data, chunk);
+    w->len += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+}
+
+/* how many bytes at the start of `str` need no escaping */
+static size_t plain_prefix(const unsigned char* str, size_t size) {
+  size_t i = 0;
+#ifdef YRC_OUTPUT_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  __m128i chunk;
+  __m128i hits;
+  int mask;
+  unsigned long bit;
+
+  for (; i + 16 <= size; i += 16) {
+    chunk = _mm_loadu_si128((const __m128i*)(str + i));
+    /* unsigned x <= 0x1f is min(x, 0x1f) == x */
+    hits = _mm_or_si128(
+        _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+    mask = _mm_movemask_epi8(hits);
+    if (mask) {
+# ifdef _MSC_VER
+      _BitScanForward(&bit, mask);
+# else
+      bit = __builtin_ctz(mask);
+# endif
+      return i + bit;
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (kEscape[str[i]]) {
+      break;
+    }
+  }
+  return i;
+}
+
+void yrc_writer_json_str(yrc_writer_t* w, const char* data, size_t size) {
+  const unsigned char* str = (const unsigned char*)data;
+  char esc[6] = {'\\', 'u', '0', '0', 0, 0};
+  size_t run;
+  char kind;
+
+  while (size) {
+    run = plain_prefix(str, size);
+    yrc_writer_putv(w, (const char*)str, run);
+    if (run == size) {
+      return;
+    }
+    kind = kEscape[str[run]];
+    if (kind == 'u') {
+      esc[4] = kHex[str[run] >> 4];
+      esc[5] = kHex[str[run] & 0xf];
+      yrc_writer_putv(w, esc, 6);
+    } else {
+      esc[1] = kind;
+      yrc_writer_putv(w, esc, 2);
+      esc[1] = 'u';
+    }
+    str += run + 1;
+    size -= run + 1;
+  }
+}
+
+void yrc_writer_uint(yrc_writer_t* w, uint64_t value) {
+  char digits[20];
+  size_t i = sizeof(digits);
+  do {
+    digits[--i] = '0' + (char)(value % 10);
+    value /= 10;
+  } while (value);
+  yrc_writer_putv(w, digits + i, sizeof(digits) - i);
+}
+
+void yrc_writer_double(yrc_writer_t* w, double value) {
+  char digits[32];
+  int precision;
+  int len = 0;
+
+  /* inf - inf and NaN - NaN are both NaN */
+  if (value - value != 0.0) {
+    yrc_writer_puts(w, "null");
+    return;
+  }
+  /* whole numbers below 2^53 print exactly, and without a trip through libc */
+  if (value < 9007199254740992.0 && value > -9007199254740992.0 &&
+      value == (double)(int64_t)value) {
+    if (value < 0) {
+      yrc_writer_putc(w, '-');
+      value = -value;
+    }
+    yrc_writer_uint(w, (uint64_t)value);
+    return;
+  }
+  for (precision = 15; precision <= 17; ++precision) {
+    len = snprintf(digits, sizeof(digits), "%.*g", precision, value);
+    if (strtod(digits, NULL) == value) {
+      break;
+    }
+  }
+  yrc_writer_putv(w, digits, len);
+}
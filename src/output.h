@@ -0,0 +1,52 @@
+#ifndef _YRC_OUTPUT_H
+#define _YRC_OUTPUT_H
+#include "yrc-common.h"
+#include <string.h> /* memcpy */
+
+/**
+  buffered writer behind the text emitters. bytes collect in the
+  caller's buffer (see yrc_output_t) and go to the write callback a
+  buffer at a time; the first failed write sticks, and everything after
+  it is dropped, so emitters only check `err` once at the end.
+**/
+typedef struct yrc_writer_s {
+  yrc_writecb write;
+  void*       ctx;
+  char*       buf;
+  size_t      size;
+  size_t      len;
+  size_t      total;  /* bytes written so far, flushed or not */
+  int         err;
+} yrc_writer_t;
+
+void yrc_writer_init(yrc_writer_t*, yrc_output_t*, char*, size_t);
+int yrc_writer_flush(yrc_writer_t*);
+void yrc_writer_putv_slow(yrc_writer_t*, const char*, size_t);
+
+/* `str` as the contents of a JSON string, without the quotes */
+void yrc_writer_json_str(yrc_writer_t*, const char*, size_t);
+void yrc_writer_uint(yrc_writer_t*, uint64_t);
+/* shortest %g that reads back as the same double; null if not finite */
+void yrc_writer_double(yrc_writer_t*, double);
+
+static inline void yrc_writer_putv(yrc_writer_t* w, const char* data, size_t size) {
+  if (size <= w->size - w->len) {
+    memcpy(w->buf + w->len, data, size);
+    w->len += size;
+    w->total += size;
+    return;
+  }
+  yrc_writer_putv_slow(w, data, size);
+}
+
+static inline void yrc_writer_putc(yrc_writer_t* w, char ch) {
+  if (w->len == w->size) {
+    yrc_writer_flush(w);
+  }
+  w->buf[w->len++] = ch;
+  ++w->total;
+}
+
+#define yrc_writer_puts(W, LITERAL) yrc_writer_putv(W, LITERAL, sizeof(LITERAL) - 1)
+
+#endif
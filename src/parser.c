@@ -1,7 +1,16 @@
 #include "yrc-common.h"
+#include "parser.h"
 #include "traverse.h"
 #include "tokenizer.h"
 #include "pool.h"
+#include "stats.h"
+#include <string.h> /* memset */
+#include <stdio.h>  /* snprintf */
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <time.h>
+#endif
 
 typedef int (*yrc_parser_led_t)(yrc_parser_state_t*, yrc_ast_node_t*, yrc_ast_node_t**);
 typedef int (*yrc_parser_nud_t)(yrc_parser_state_t*, yrc_token_t*, yrc_ast_node_t**);
@@ -27,6 +36,28 @@ typedef struct yrc_parse_error_s {
   yrc_token_t expected;
 } yrc_parse_error_t;
 
+/**
+  where each statement of a statement list (program, block or case body)
+  begins and ends, kept only for incremental parses. `open` is the token
+  just before the list -- `{` or `:`, NULL at the top level -- and `close`
+  the one that ended it: `}`, `case`, `default`, or NULL at end of input.
+  holding tokens rather than offsets means yrc_reparse only has to move
+  the tokens after an edit; the spans follow.
+**/
+typedef struct yrc_span_s {
+  yrc_token_t*      first;
+  yrc_token_t*      last;
+  yrc_ast_node_t*   node;
+} yrc_span_t;
+
+struct yrc_span_list_s {
+  yrc_token_t*  open;
+  yrc_token_t*  close;
+  size_t        count;
+  size_t        capacity;
+  yrc_span_t*   spans;
+};
+
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define IS_EOF(K) (K == &eof)
 #define IS_OP(K, T) (K->type == YRC_TOKEN_OPERATOR && K->info.as_operator == YRC_OP_##T)
@@ -41,13 +72,31 @@ struct yrc_parser_state_s {
   uint_fast8_t          saw_newline;
   uint_fast8_t          allow_comma;
   yrc_error_t**         errorptr;
+  yrc_stmtcb            stmtcb;
+  void*                 stmtctx;
+  uint_fast8_t          incremental;
+  uint_fast32_t         lbp;          /* of the infix operator being parsed */
+  uint_fast8_t          validate;     /* keep nothing: see yrc_validate */
+  uint_fast8_t          scan_failed;
+  yrc_token_t*          unexpected;   /* a failing token already passed */
+  size_t                budget;       /* tokens between checks, or 0 */
+  size_t                spent;
+  uint64_t              deadline;
+  uint_fast8_t          limited;      /* `budget` is the request's own */
+  uint_fast8_t          over_budget;
+  uint_fast8_t          aborted;      /* by the statement callback */
+  yrc_parser_exhaustedcb exhausted;
+  void*                 exhaustedctx;
+  void**                pending;      /* lists not yet in a finished tree */
+  size_t                npending;
+  size_t                pending_size;
+  yrc_ast_node_t        scratch;      /* every node, when validating */
+#ifdef YRC_STATS
+  yrc_parse_stats_t*    stats;
+  size_t                depth;
+#endif
 };
 
-typedef struct yrc_parse_response_priv_s {
-  yrc_parse_response_t  response;
-  yrc_tokenizer_t*      tokenizer;
-  yrc_pool_t*           node_pool;
-} yrc_parse_response_priv_t;
 
 #define CONSUME_CLEAN(state, CHECK, T, CLEANUP)\
   do {\
@@ -60,29 +109,192 @@ static int advance(yrc_parser_state_t*, uint_fast8_t);
 static inline int commaexpression(yrc_parser_state_t*, uint_fast32_t, yrc_ast_node_t**, uint_fast8_t);
 static int expression(yrc_parser_state_t*, uint_fast32_t, yrc_ast_node_t**, uint_fast8_t);
 static int statement(yrc_parser_state_t*, yrc_ast_node_t**, uint_fast8_t);
-static int statements(yrc_parser_state_t*, yrc_llist_t*);
+static int statements(yrc_parser_state_t*, yrc_llist_t*, yrc_span_list_t**);
+static int release_statement(yrc_parser_state_t*, yrc_ast_node_t*);
+static void span_list_free(yrc_span_list_t*);
 static int _ident(yrc_parser_state_t*, yrc_token_t*, yrc_ast_node_t**);
+
+/* pooled nodes come back dirty; these are the fields not every node sets */
+enum {
+  kDeadlineEvery=1024   /* tokens between clock checks, with no budget */
+};
+
+/**
+  nodes are pooled in size classes, by how much of the union their kind
+  fills in, so that identifiers and literals don't pay for for loops and
+  functions. a node is only ever as big as its class: nothing may touch a
+  part of the union its kind doesn't use, nor change a node's kind.
+**/
+#define NODE_SIZE(MEMBER) \
+  (offsetof(yrc_ast_node_t, data) + sizeof(((yrc_ast_node_t*)0)->data.MEMBER))
+
+enum {
+  kNodeOne,     /* one pointer */
+  kNodeTwo,     /* two pointers, or a pointer and an int */
+  kNodeThree,   /* three */
+  kNodeAll,     /* the whole union */
+  kNodeClasses
+};
+
+static const size_t node_class_sizes[kNodeClasses] = {
+  NODE_SIZE(as_ident), NODE_SIZE(as_call), NODE_SIZE(as_try), sizeof(yrc_ast_node_t)
+};
+
+/* as the parser fills them in; see layout() in serialize.c */
+static inline size_t node_class(yrc_ast_node_type kind) {
+  switch (kind) {
+    case YRC_AST_STMT_EMPTY:
+    case YRC_AST_STMT_EXPR:
+    case YRC_AST_STMT_BREAK:
+    case YRC_AST_STMT_CONTINUE:
+    case YRC_AST_STMT_RETURN:
+    case YRC_AST_STMT_THROW:
+    case YRC_AST_EXPR_IDENTIFIER:
+    case YRC_AST_EXPR_THIS:
+    case YRC_AST_EXPR_ARRAY:
+    case YRC_AST_EXPR_OBJECT:
+    case YRC_AST_EXPR_LITERAL: return kNodeOne;
+    case YRC_AST_PROGRAM:
+    case YRC_AST_STMT_BLOCK:
+    case YRC_AST_STMT_SWITCH:
+    case YRC_AST_STMT_WHILE:
+    case YRC_AST_STMT_DOWHILE:
+    case YRC_AST_CLSE_VAR:
+    case YRC_AST_DECL_VAR:
+    case YRC_AST_EXPR_SEQUENCE:
+    case YRC_AST_EXPR_UNARY:
+    case YRC_AST_EXPR_CALL: return kNodeTwo;
+    /* catch clauses keep a trailing finally in as_try.finalizer */
+    case YRC_AST_STMT_IF:
+    case YRC_AST_STMT_TRY:
+    case YRC_AST_STMT_FORIN:
+    case YRC_AST_STMT_FOROF:
+    case YRC_AST_CLSE_CASE:
+    case YRC_AST_CLSE_CATCH:
+    case YRC_AST_EXPR_PROPERTY:
+    case YRC_AST_EXPR_BINARY:
+    case YRC_AST_EXPR_LOGICAL:
+    case YRC_AST_EXPR_ASSIGNMENT:
+    case YRC_AST_EXPR_UPDATE:
+    case YRC_AST_EXPR_CONDITIONAL:
+    case YRC_AST_EXPR_MEMBER: return kNodeThree;
+    default: return kNodeAll;
+  }
+}
+
+static inline int init_node_pool(yrc_pool_t** pool) {
+  return yrc_pool_init_classes(pool, node_class_sizes, kNodeClasses);
+}
+
+/**
+  a validating parse builds no tree: every node it asks for is the same
+  scratch node, and lists are never started or pushed onto. so nothing
+  may read a child back out of a node it has been stored in; parse
+  functions keep what they need to look at in locals.
+**/
+static inline yrc_ast_node_t* attain_node(yrc_parser_state_t* state, yrc_ast_node_type kind) {
+  yrc_ast_node_t* node = state->validate ? &state->scratch :
+    yrc_pool_attain_class(state->node_pool, node_class(kind));
+  if (node) {
+    node->kind = kind;
+    node->has_parens = 0;
+    node->first = NULL;
+    node->last = NULL;
+  }
+  return node;
+}
+
+/**
+  until a parse is over, every list it starts is kept on `pending` as
+  well. a failure leaves half-built nodes behind in the pool, holding
+  lists nothing else can reach; settle_pending frees them, or hands them
+  over to the finished tree. span lists go on with the low bit set.
+  streamed statements take theirs back off the end.
+**/
+enum {
+  kPendingSpans=1
+};
+
+static int pend(yrc_parser_state_t* state, void* list, uintptr_t tag) {
+  void** grown;
+  size_t size;
+  if (state->npending == state->pending_size) {
+    size = state->pending_size ? state->pending_size * 2 : 64;
+    grown = realloc(state->pending, size * sizeof(*grown));
+    if (grown == NULL) {
+      return 1;
+    }
+    state->pending = grown;
+    state->pending_size = size;
+  }
+  state->pending[state->npending++] = (void*)((uintptr_t)list | tag);
+  return 0;
+}
+
+static int list_init(yrc_parser_state_t* state, yrc_llist_t** out) {
+  if (state->validate) {
+    *out = NULL;
+    return 0;
+  }
+  if (yrc_llist_init(out)) {
+    return 1;
+  }
+  if (pend(state, *out, 0)) {
+    yrc_llist_free(*out);
+    return 1;
+  }
+  return 0;
+}
+
+static inline int list_push(yrc_parser_state_t* state, yrc_llist_t* list, void* item) {
+  return state->validate ? 0 : yrc_llist_push(list, item);
+}
+
+static void settle_pending(yrc_parser_state_t* state, uint_fast8_t failed) {
+  uintptr_t item;
+  size_t i;
+  for (i = 0; failed && i < state->npending; ++i) {
+    item = (uintptr_t)state->pending[i];
+    if (item & kPendingSpans) {
+      span_list_free((yrc_span_list_t*)(item & ~(uintptr_t)kPendingSpans));
+    } else {
+      yrc_llist_free((yrc_llist_t*)item);
+    }
+  }
+  free(state->pending);
+  state->pending = NULL;
+  state->npending = 0;
+  state->pending_size = 0;
+}
+
 static yrc_token_t eof = {YRC_TOKEN_EOF, {{0, 0, NULL}}, {0, 0, 0}, {0, 0, 0}};
 static yrc_parser_symbol_t sym_eof = {NULL, NULL, NULL, 0};
 
 
+/* statements that don't read their own `;` leave it for an EmptyStatement */
+static int end_statement(yrc_parser_state_t* state, uint_fast8_t flags) {
+  if ((flags & CONSUME_SEMICOLON) && IS_OP(state->token, SEMICOLON)) {
+    return advance(state, YRC_ISNT_REGEXP);
+  }
+  return 0;
+}
+
+
 static int _block(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_BLOCK);
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_STMT_BLOCK;
-  if (yrc_llist_init(&node->data.as_block.body)) {
+  node->first = state->last;
+  if (list_init(state, &node->data.as_block.body)) {
     return 1;
   }
   
-  if (statements(state, node->data.as_block.body)) {
-    yrc_llist_free(node->data.as_block.body);
+  if (statements(state, node->data.as_block.body, &node->data.as_block.spans)) {
     return 1;
   }
-  CONSUME_CLEAN(state, IS_OP, RBRACE, {
-    yrc_llist_free(node->data.as_block.body);
-  });
+  CONSUME(state, IS_OP, RBRACE);
+  node->last = state->last;
   *out = (yrc_ast_node_t*)node;
   
   return 0;
@@ -90,11 +302,10 @@ static int _block(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t
 
 
 static int _break(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_BREAK);
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_STMT_BREAK;
 
   /* XXX: need to advance if there is a label */
   /* XXX: ASI */
@@ -103,16 +314,15 @@ static int _break(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t
     NULL;
   *out = (yrc_ast_node_t*)node;
   
-  return 0;
+  return end_statement(state, flags);
 }
 
 
 static int _throw(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_THROW);
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_STMT_THROW;
 
   /* XXX: ASI */
   if (commaexpression(state, 0, &node->data.as_throw.argument, 0)) {
@@ -120,17 +330,16 @@ static int _throw(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t
   }
   *out = node;
   
-  return 0;
+  return end_statement(state, flags);
 }
 
 
 static int _do_regexp(yrc_parser_state_t* state, yrc_ast_node_t** out, yrc_scan_allow_regexp kind) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_LITERAL);
   if (node == NULL) {
     return 1;
   }
   *out = (yrc_ast_node_t*)node;
-  node->kind = YRC_AST_EXPR_LITERAL;
   node->data.as_literal.value = state->token;
   
   if (advance(state, YRC_ISNT_REGEXP)) {
@@ -152,14 +361,13 @@ static int _regexp_eq(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node
 
 
 static int _call(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_CALL);
   yrc_ast_node_t* item;
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_EXPR_CALL;
   node->data.as_call.callee = left;
-  if (yrc_llist_init(&node->data.as_call.arguments)) {
+  if (list_init(state, &node->data.as_call.arguments)) {
     return 1;
   }
   if (!IS_OP(state->token, RPAREN))
@@ -168,7 +376,7 @@ static int _call(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t
     if (expression(state, 0, &item, 0)) {
       goto cleanup;
     }
-    if (yrc_llist_push(node->data.as_call.arguments, item)) {
+    if (list_push(state, node->data.as_call.arguments, item)) {
       goto cleanup;
     }
     if (!IS_OP(state->token, COMMA)) {
@@ -179,9 +387,7 @@ static int _call(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t
     }
   } while(1);
 
-  CONSUME_CLEAN(state, IS_OP, RPAREN, {
-    yrc_llist_free(node->data.as_call.arguments);
-  });
+  CONSUME(state, IS_OP, RPAREN);
   *out = (yrc_ast_node_t*)node;
   return 0;
 
@@ -191,26 +397,24 @@ cleanup:
 
 
 static int _continue(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_CONTINUE);
   if (node == NULL) {
     return 1;
   }
 
   /* XXX: ASI */
-  node->kind = YRC_AST_STMT_CONTINUE;
   node->data.as_continue.label = (state->token->type == YRC_TOKEN_IDENT) ?
     node->data.as_continue.label = state->token :
     NULL;
   *out = (yrc_ast_node_t*)node;
-  return 0;
+  return end_statement(state, flags);
 }
 
 
 static int _do(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_DOWHILE);
   *out = node;
   if (node == NULL) return 1;
-  node->kind = YRC_AST_STMT_DOWHILE;
   if (statement(state, &node->data.as_do_while.body, CONSUME_SEMICOLON)) {
     return 1;
   }
@@ -220,15 +424,14 @@ static int _do(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t fla
     return 1;
   }
   CONSUME(state, IS_OP, RPAREN);
-  return 0;
+  return end_statement(state, flags);
 }
 
 
 static int _parse_for(yrc_parser_state_t* state, yrc_ast_node_t* init, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_FOR);
   *out = node;
   if (node == NULL) return 1;
-  node->kind = YRC_AST_STMT_FOR;
   node->data.as_for.init = init;
   CONSUME(state, IS_OP, SEMICOLON);
   if (IS_OP(state->token, SEMICOLON)) {
@@ -251,10 +454,9 @@ static int _parse_for(yrc_parser_state_t* state, yrc_ast_node_t* init, yrc_ast_n
 
 
 static int _parse_forinof(yrc_parser_state_t* state, yrc_ast_node_t* init, yrc_ast_node_t** out, yrc_ast_node_type type) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, type);
   *out = node;
   if (node == NULL) return 1;
-  node->kind = type;
   node->data.as_for_in.left = init;
   CONSUME(state, IS_KW, IN);
   if (commaexpression(state, 0, &node->data.as_for_in.right, 0)) {
@@ -305,10 +507,9 @@ static int _for(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t fl
 
 
 static int _if(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_IF);
   *out = node;
   if (node == NULL) return 1;
-  node->kind = YRC_AST_STMT_IF;
   node->data.as_if.alternate = NULL;
   CONSUME(state, IS_OP, LPAREN);
   if (commaexpression(state, 0, &node->data.as_if.test, 0)) {
@@ -334,32 +535,30 @@ static int _if(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t fla
 #define INFIX(NAME, TYPE, RBP_MOD, KIND, EXTRA) \
 static int NAME(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t** out) { \
   yrc_token_t* token = state->last;\
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);\
+  yrc_ast_node_t* node = attain_node(state, KIND);\
   if (node == NULL) {\
     return 1;\
   }\
-  node->kind = KIND;\
   node->data.as_binary.left = left;\
-  if (expression(state, state->symbol->lbp + RBP_MOD, &node->data.as_binary.right, 0)) {\
+  do { EXTRA } while(0);\
+  if (expression(state, state->lbp + RBP_MOD, &node->data.as_binary.right, 0)) {\
     return 1;\
   }\
-  do { EXTRA } while(0);\
   *out = (yrc_ast_node_t*)node;\
   return 0;\
 }
 
 #define PREFIX(NAME, TYPE, BP, KIND, EXTRA)\
 static int NAME(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t** out) { \
-  yrc_token_t* token = state->token;\
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);\
+  yrc_token_t* token = orig;\
+  yrc_ast_node_t* node = attain_node(state, KIND);\
   if (node == NULL) {\
     return 1;\
   }\
+  do { EXTRA } while(0);\
   if (expression(state, BP, &node->data.as_unary.argument, 0)) {\
     return 1;\
   }\
-  node->kind = KIND;\
-  do { EXTRA } while(0);\
   *out = (yrc_ast_node_t*)node;\
   return 0;\
 }
@@ -368,21 +567,22 @@ static int NAME(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t** o
 INFIX(_infix, yrc_ast_node_binary_t, 0, YRC_AST_EXPR_BINARY, {
   node->data.as_binary.op = token->info.as_operator;
 })
-INFIX(_infixr, yrc_ast_node_binary_t, -1, YRC_AST_EXPR_LOGICAL, {
+INFIX(_logical, yrc_ast_node_binary_t, 0, YRC_AST_EXPR_LOGICAL, {
   node->data.as_binary.op = token->info.as_operator;
 })
 INFIX(_assign, yrc_ast_node_binary_t, -1, YRC_AST_EXPR_ASSIGNMENT, {
   node->data.as_assign.op = token->info.as_operator;
 })
-PREFIX(_prefix, yrc_ast_node_unary_t, 0, YRC_AST_EXPR_UNARY, {
+/* binds looser than member access and calls, tighter than any infix */
+PREFIX(_prefix, yrc_ast_node_unary_t, YRC_BP_PREFIX, YRC_AST_EXPR_UNARY, {
+  /* keywords share the operator numbering; see yrc_keyword_t */
   node->data.as_unary.op = token->info.as_operator;
 })
 
 
 static int _dynget(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_MEMBER);
   if (node == NULL) return 1;
-  node->kind = YRC_AST_EXPR_MEMBER;
   node->data.as_member.computed = 1;
   node->data.as_member.object = left;
   if (commaexpression(state, 0, &node->data.as_member.property, 0)) {
@@ -395,9 +595,8 @@ static int _dynget(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node
 
 
 static int _get(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_MEMBER);
   if (node == NULL) return 1;
-  node->kind = YRC_AST_EXPR_MEMBER;
   node->data.as_member.computed = 0;
   if (state->token->type != YRC_TOKEN_IDENT) {
     return 1;
@@ -415,12 +614,11 @@ static int _get(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t*
 
 
 static int _prefix_array(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_ARRAY);
   yrc_ast_node_t* item;
-  if (yrc_llist_init(&node->data.as_array.elements)) {
+  if (list_init(state, &node->data.as_array.elements)) {
     return 1;
   }
-  node->kind = YRC_AST_EXPR_ARRAY;
   do {
     if (IS_OP(state->token, RBRACK)) {
       break;
@@ -435,7 +633,7 @@ static int _prefix_array(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_n
     if (expression(state, 0, &item, 0)) {
       goto cleanup;
     }
-    if (yrc_llist_push(node->data.as_array.elements, item)) {
+    if (list_push(state, node->data.as_array.elements, item)) {
       goto cleanup;
     }
     CONSUME_CLEAN(state, IS_OP, COMMA, { break; });
@@ -448,7 +646,6 @@ static int _prefix_array(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_n
   *out = node;
   return 0;
 cleanup:
-  yrc_llist_free(node->data.as_array.elements);
   return 1;
 }
 
@@ -456,29 +653,29 @@ cleanup:
 static int _prefix_object(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t** out) {
   /* this could be either a block or destructuring */
   /* TODO: support es6 */
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_OBJECT);
   yrc_ast_node_t* item;
   uint_fast8_t shorthand_prop_ok = 0;
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_EXPR_OBJECT;
   *out = node;
 
   if (IS_OP(state->token, RBRACE)) {
     node->data.as_object.properties = NULL;
     return advance(state, YRC_ISNT_REGEXP);
   }
-  if (yrc_llist_init(&node->data.as_object.properties)) {
+  if (list_init(state, &node->data.as_object.properties)) {
     return 1;
   }
   do {
     shorthand_prop_ok = 1;
-    item = yrc_pool_attain(state->node_pool);
+    item = attain_node(state, YRC_AST_EXPR_PROPERTY);
     if (item == NULL) {
       goto cleanup;
     }
-    item->kind = YRC_AST_EXPR_PROPERTY;
+    item->data.as_property.type = 0;
+    item->first = state->token;
 
     /* XXX: todo, support "{get: x}" */
     if (0)
@@ -565,7 +762,8 @@ not_getter_or_setter:
     }
 
 shorthand:
-    if (yrc_llist_push(node->data.as_object.properties, item)) {
+    item->last = state->last;
+    if (list_push(state, node->data.as_object.properties, item)) {
       goto cleanup;
     }
 
@@ -584,7 +782,6 @@ shorthand:
   });
   return 0;
 cleanup:
-  yrc_llist_free(node->data.as_object.properties);
   return 1;
 }
 
@@ -604,10 +801,10 @@ static int _parameters(yrc_parser_state_t* state, yrc_ast_node_function_t* fn) {
     } else {
       def = NULL;
     }
-    if (yrc_llist_push(fn->params, expr)) {
+    if (list_push(state, fn->params, expr)) {
       return 1;
     }
-    if (yrc_llist_push(fn->defaults, def)) {
+    if (list_push(state, fn->defaults, def)) {
       return 1;
     }
     if (!IS_OP(state->token, COMMA)) {
@@ -630,19 +827,15 @@ static int _parse_function(yrc_parser_state_t* state, yrc_ast_node_t** out, uint
   if (needs_ident && state->token->type != YRC_TOKEN_IDENT) {
     return 1;
   }
-  node = yrc_pool_attain(state->node_pool);
+  node = attain_node(state, kind);
   *out = node;
   if (node == NULL) {
     return 1;
   }
-  if (yrc_llist_init(&node->data.as_function.params)) {
-    return 1;
-  }
-  if (yrc_llist_init(&node->data.as_function.defaults)) {
-    yrc_llist_free(node->data.as_function.params);
+  if (list_init(state, &node->data.as_function.params) ||
+      list_init(state, &node->data.as_function.defaults)) {
     return 1;
   }
-  node->kind = kind;
   if (needs_ident && state->token->type != YRC_TOKEN_IDENT) {
     return 1;
   }
@@ -666,8 +859,6 @@ static int _parse_function(yrc_parser_state_t* state, yrc_ast_node_t** out, uint
   }
   return 0;
 cleanup:
-  yrc_llist_free(node->data.as_function.params);
-  yrc_llist_free(node->data.as_function.defaults);
   return err;
 }
 
@@ -697,11 +888,10 @@ static int _prefix_paren(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_n
 
 
 static int _return(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_RETURN);
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_STMT_RETURN;
   node->data.as_return.argument = NULL;
   *out = node;
   if (IS_OP(state->token, SEMICOLON)) {
@@ -730,11 +920,10 @@ static int _return(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t
 
 
 static int _suffix(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t** out, yrc_operator_t op) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_UPDATE);
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_EXPR_UPDATE;
   node->data.as_update.op = op;
   node->data.as_update.argument = left;
   node->data.as_update.prefix = 0;
@@ -752,10 +941,9 @@ static int _suffix_add(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_
 }
 
 static int _ternary(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_CONDITIONAL);
   *out = node;
   if (node == NULL) return 1;
-  node->kind = YRC_AST_EXPR_CONDITIONAL;
   node->data.as_conditional.test = left;
   if (commaexpression(state, 0, &node->data.as_conditional.consequent, 0)) {
     return 1;
@@ -769,13 +957,13 @@ static int _ternary(yrc_parser_state_t* state, yrc_ast_node_t* left, yrc_ast_nod
 
 
 static int _catch(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_CLSE_CATCH);
   *out = node;
   if (node == NULL) return 1;
   node->data.as_try.finalizer = NULL;
   node->data.as_try.handler = NULL;
 
-  node->kind = YRC_AST_CLSE_CATCH;
+  node->first = state->last;
   CONSUME(state, IS_OP, LPAREN);
   if (expression(state, 0, &node->data.as_catch.param, 0)) {
     return 1;
@@ -785,6 +973,7 @@ static int _catch(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t
   if (_block(state, &node->data.as_catch.body, 0)) {
     return 1;
   }
+  node->last = state->last;
   if (IS_KW(state->token, FINALLY)) {
     if (advance(state, YRC_ISNT_REGEXP)) {
       return 1;
@@ -799,10 +988,11 @@ static int _catch(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t
 
 
 static int _trystmt(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_TRY);
   *out = node;
   if (node == NULL) return 1;
-  node->kind = YRC_AST_STMT_TRY;
+  node->data.as_try.handler = NULL;
+  node->data.as_try.finalizer = NULL;
   CONSUME(state, IS_OP, LBRACE);
   if (_block(state, &node->data.as_try.block, 0)) {
     return 1;
@@ -835,11 +1025,11 @@ static int _cases(yrc_parser_state_t* state, yrc_llist_t* cases) {
     if (IS_OP(state->token, RBRACE)) {
       break;
     }
-    node = yrc_pool_attain(state->node_pool);
+    node = attain_node(state, YRC_AST_CLSE_CASE);
     if (node == NULL) {
       return 1;
     }
-    node->kind = YRC_AST_CLSE_CASE;
+    node->first = state->token;
     if (IS_KW(state->token, CASE)) {
       CONSUME(state, IS_KW, CASE);
       if (commaexpression(state, 0, &node->data.as_case.test, 0)) {
@@ -852,15 +1042,16 @@ static int _cases(yrc_parser_state_t* state, yrc_llist_t* cases) {
       return 1;
     }
     CONSUME(state, IS_OP, COLON);
-    if (yrc_llist_init(&node->data.as_case.consequent)) {
+    if (list_init(state, &node->data.as_case.consequent)) {
       return 1;
     }
 
-    if (statements(state, node->data.as_case.consequent)) {
+    if (statements(state, node->data.as_case.consequent, &node->data.as_case.spans)) {
       return 1;
     }
+    node->last = state->last;
 
-    if (yrc_llist_push(cases, node)) {
+    if (list_push(state, cases, node)) {
       return 1;
     }
     node = NULL;
@@ -870,11 +1061,10 @@ static int _cases(yrc_parser_state_t* state, yrc_llist_t* cases) {
 }
 
 static int _switchstmt(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_SWITCH);
   *out = node;
   if (node == NULL) return 1;
-  node->kind = YRC_AST_STMT_SWITCH;
-  if (yrc_llist_init(&node->data.as_switch.cases)) {
+  if (list_init(state, &node->data.as_switch.cases)) {
     return 1;
   }
 
@@ -890,31 +1080,30 @@ static int _switchstmt(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fas
   CONSUME_CLEAN(state, IS_OP, RBRACE, { goto cleanup; });
   return 0;
 cleanup:
-  yrc_llist_free(node->data.as_switch.cases);
   return 1;
 }
 
 static int _decl(yrc_parser_state_t* state, yrc_ast_node_t** out, yrc_var_type type, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_DECL_VAR);
   yrc_ast_node_t* item = NULL;
+  yrc_ast_node_t* id;
   *out = node;
   if (node == NULL) return 1;
-  node->kind = YRC_AST_DECL_VAR;
   node->data.as_var.type = type;
-  if (yrc_llist_init(&node->data.as_var.declarations)) {
+  if (list_init(state, &node->data.as_var.declarations)) {
     return 1;
   }
 
   do {
-    item = yrc_pool_attain(state->node_pool);
+    item = attain_node(state, YRC_AST_CLSE_VAR);
     if (item == NULL) goto cleanup;
-    item->kind = YRC_AST_CLSE_VAR;
     item->data.as_vardecl.init = NULL;
 
     /* don't take any assignment operations */
-    if (expression(state, 10, &item->data.as_vardecl.id, flags)) {
+    if (expression(state, 10, &id, flags)) {
       return 1;
     }
+    item->data.as_vardecl.id = id;
     if (IS_OP(state->token, EQ)) {
       if (advance(state, YRC_ISNT_REGEXP)) {
         return 1;
@@ -923,8 +1112,10 @@ static int _decl(yrc_parser_state_t* state, yrc_ast_node_t** out, yrc_var_type t
         return 1;
       }
     }
+    item->first = id->first;
+    item->last = state->last;
 
-    if (yrc_llist_push(node->data.as_var.declarations, item)) {
+    if (list_push(state, node->data.as_var.declarations, item)) {
       return 1;
     }
 
@@ -938,8 +1129,7 @@ static int _decl(yrc_parser_state_t* state, yrc_ast_node_t** out, yrc_var_type t
   } while(1);
 
   /* XXX: ASI */
-
-  return 0;
+  return end_statement(state, flags);
 cleanup:
   return 1;
 }
@@ -961,10 +1151,9 @@ static int _let(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t fl
 
 
 static int _while(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t flags) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_STMT_WHILE);
   *out = node;
   if (node == NULL) return 1;
-  node->kind = YRC_AST_STMT_WHILE;
   CONSUME(state, IS_OP, LPAREN);
   if (commaexpression(state, 0, &node->data.as_while.test, 0)) {
     return 1;
@@ -978,39 +1167,43 @@ static int _while(yrc_parser_state_t* state, yrc_ast_node_t** out, uint_fast8_t
 
 
 static int _literal(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_LITERAL);
   if (node == NULL) {
     return 1;
   }
   node->data.as_literal.value = orig;
-  node->kind = YRC_AST_EXPR_LITERAL;
   *out = node;
   return 0;
 }
 
 
 static int _ident(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_IDENTIFIER);
   if (node == NULL) {
     return 1;
   }
   node->data.as_ident.name = orig;
-  node->kind = YRC_AST_EXPR_IDENTIFIER;
   *out = (yrc_ast_node_t*)node;
   return 0;
 }
 
 
 static int _this(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t** out) {
-  yrc_ast_node_t* node = yrc_pool_attain(state->node_pool);
+  yrc_ast_node_t* node = attain_node(state, YRC_AST_EXPR_THIS);
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_EXPR_THIS;
   *out = (yrc_ast_node_t*)node;
   return 0;
 }
 
+/**
+  binding powers follow javascript's precedence, loosest first:
+  assignment 10, `?:` 20, `||` 32, `&&` 34, `|` 38, `^` 40, `&` 42,
+  equality 44, relational 46, shifts 48, additive 50, multiplicative 60,
+  prefix operators 70 (YRC_BP_PREFIX), calls and member access 80 and
+  postfix `++`/`--` 150. codegen.c parenthesizes by the same numbers.
+**/
 #define SYMBOLS(XX) \
   XX(stmtthis,       KEYWORD, as_keyword == YRC_KW_THIS,        0, _this,     NULL, NULL)\
   XX(stmtwhile,      KEYWORD, as_keyword == YRC_KW_WHILE,       0, NULL,      NULL, _while)\
@@ -1026,13 +1219,13 @@ static int _this(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t**
   XX(stmtlet,        KEYWORD, as_keyword == YRC_KW_LET,         0, NULL,      NULL, _let)\
   XX(stmtconst,      KEYWORD, as_keyword == YRC_KW_CONST,       0, NULL,      NULL, _const)\
   XX(stmtswitch,     KEYWORD, as_keyword == YRC_KW_SWITCH,      0, NULL,      NULL, _switchstmt)\
-  XX(exprin,         KEYWORD, as_keyword == YRC_KW_IN,         50, NULL,      _infix, NULL)\
+  XX(exprin,         KEYWORD, as_keyword == YRC_KW_IN,         46, NULL,      _infix, NULL)\
   XX(exprfunction,   KEYWORD, as_keyword == YRC_KW_FUNCTION,    0, _function, NULL, _functionstmt)\
   XX(exprvoid,       KEYWORD, as_keyword == YRC_KW_VOID,        0, _prefix,   NULL, NULL)\
   XX(exprtypeof,     KEYWORD, as_keyword == YRC_KW_TYPEOF,      0, _prefix,   NULL, NULL)\
   XX(exprdelete,     KEYWORD, as_keyword == YRC_KW_DELETE,      0, _prefix,   NULL, NULL)\
   XX(exprnew,        KEYWORD, as_keyword == YRC_KW_NEW,         0, _prefix,   NULL, NULL)\
-  XX(exprinstanceof, KEYWORD, as_keyword == YRC_KW_INSTANCEOF, 50, NULL,      _infix, NULL)\
+  XX(exprinstanceof, KEYWORD, as_keyword == YRC_KW_INSTANCEOF, 46, NULL,      _infix, NULL)\
   XX(null_else,      KEYWORD, as_keyword == YRC_KW_ELSE,        0, NULL, NULL, NULL)\
   XX(null_catch,     KEYWORD, as_keyword == YRC_KW_CATCH,       0, NULL, NULL, NULL)\
   XX(null_finally,   KEYWORD, as_keyword == YRC_KW_FINALLY,     0, NULL, NULL, NULL)\
@@ -1051,23 +1244,23 @@ static int _this(yrc_parser_state_t* state, yrc_token_t* orig, yrc_ast_node_t**
   XX(exprdecr,       OPERATOR, as_operator == YRC_OP_DECR,      150, _prefix, _suffix_min, NULL)\
   XX(expradd,        OPERATOR, as_operator == YRC_OP_ADD,        50, _prefix, _infix, NULL)\
   XX(exprsub,        OPERATOR, as_operator == YRC_OP_SUB,        50, _prefix, _infix, NULL)\
-  XX(exprlesser,     OPERATOR, as_operator == YRC_OP_LESSER,     40, NULL, _infix, NULL)\
-  XX(exprgreater,    OPERATOR, as_operator == YRC_OP_GREATER,    40, NULL, _infix, NULL)\
-  XX(exprand,        OPERATOR, as_operator == YRC_OP_AND,        40, NULL, _infix, NULL)\
-  XX(expror,         OPERATOR, as_operator == YRC_OP_OR,         40, NULL, _infix, NULL)\
+  XX(exprlesser,     OPERATOR, as_operator == YRC_OP_LESSER,     46, NULL, _infix, NULL)\
+  XX(exprgreater,    OPERATOR, as_operator == YRC_OP_GREATER,    46, NULL, _infix, NULL)\
+  XX(exprand,        OPERATOR, as_operator == YRC_OP_AND,        42, NULL, _infix, NULL)\
+  XX(expror,         OPERATOR, as_operator == YRC_OP_OR,         38, NULL, _infix, NULL)\
   XX(exprxor,        OPERATOR, as_operator == YRC_OP_XOR,        40, NULL, _infix, NULL)\
-  XX(exprlshf,       OPERATOR, as_operator == YRC_OP_LSHF,       40, NULL, _infix, NULL)\
-  XX(exprrshf,       OPERATOR, as_operator == YRC_OP_RSHF,       40, NULL, _infix, NULL)\
-  XX(exprurshf,      OPERATOR, as_operator == YRC_OP_URSHF,      40, NULL, _infix, NULL)\
-  XX(exprlessereq,   OPERATOR, as_operator == YRC_OP_LESSEREQ,   40, NULL, _infix, NULL)\
-  XX(exprgreatereq,  OPERATOR, as_operator == YRC_OP_GREATEREQ,  40, NULL, _infix, NULL)\
-  XX(expreqeq,       OPERATOR, as_operator == YRC_OP_EQEQ,       40, NULL, _infix, NULL)\
-  XX(expreqeqeq,     OPERATOR, as_operator == YRC_OP_EQEQEQ,     40, NULL, _infix, NULL)\
-  XX(exprnoteq,      OPERATOR, as_operator == YRC_OP_NOTEQ,      40, NULL, _infix, NULL)\
-  XX(exprnoteqeq,    OPERATOR, as_operator == YRC_OP_NOTEQEQ,    40, NULL, _infix, NULL)\
-  XX(exprlor,        OPERATOR, as_operator == YRC_OP_LOR,        30, NULL, _infixr, NULL)\
-  XX(exprland,       OPERATOR, as_operator == YRC_OP_LAND,       30, NULL, _infixr, NULL)\
-  XX(exprlxor,       OPERATOR, as_operator == YRC_OP_LXOR,       30, NULL, _infixr, NULL)\
+  XX(exprlshf,       OPERATOR, as_operator == YRC_OP_LSHF,       48, NULL, _infix, NULL)\
+  XX(exprrshf,       OPERATOR, as_operator == YRC_OP_RSHF,       48, NULL, _infix, NULL)\
+  XX(exprurshf,      OPERATOR, as_operator == YRC_OP_URSHF,      48, NULL, _infix, NULL)\
+  XX(exprlessereq,   OPERATOR, as_operator == YRC_OP_LESSEREQ,   46, NULL, _infix, NULL)\
+  XX(exprgreatereq,  OPERATOR, as_operator == YRC_OP_GREATEREQ,  46, NULL, _infix, NULL)\
+  XX(expreqeq,       OPERATOR, as_operator == YRC_OP_EQEQ,       44, NULL, _infix, NULL)\
+  XX(expreqeqeq,     OPERATOR, as_operator == YRC_OP_EQEQEQ,     44, NULL, _infix, NULL)\
+  XX(exprnoteq,      OPERATOR, as_operator == YRC_OP_NOTEQ,      44, NULL, _infix, NULL)\
+  XX(exprnoteqeq,    OPERATOR, as_operator == YRC_OP_NOTEQEQ,    44, NULL, _infix, NULL)\
+  XX(exprlor,        OPERATOR, as_operator == YRC_OP_LOR,        32, NULL, _logical, NULL)\
+  XX(exprland,       OPERATOR, as_operator == YRC_OP_LAND,       34, NULL, _logical, NULL)\
+  XX(exprlxor,       OPERATOR, as_operator == YRC_OP_LXOR,       32, NULL, _logical, NULL)\
   XX(exprquestion,   OPERATOR, as_operator == YRC_OP_QUESTION,   20, NULL, _ternary, NULL)\
   XX(expreq,         OPERATOR, as_operator == YRC_OP_EQ,         10, NULL, _assign, NULL)\
   XX(expraddeq,      OPERATOR, as_operator == YRC_OP_ADDEQ,      10, NULL, _assign, NULL)\
@@ -1096,16 +1289,91 @@ static yrc_parser_symbol_t sym_literal = {_literal, NULL, NULL, 0};
 SYMBOLS(XX)
 #undef XX
 
+void yrc_parser_binding_powers(uint8_t* lbp) {
+  yrc_token_t token;
+  int value;
+  for (value = 0; value < YRC_KW_LAST; ++value) {
+    lbp[value] = 0;
+    if (value > YRC_OP_NULL && value < YRC_OP_LAST) {
+      token.type = YRC_TOKEN_OPERATOR;
+      token.info.as_operator = value;
+    } else if (value > YRC_KWOP_FENCE) {
+      token.type = YRC_TOKEN_KEYWORD;
+      token.info.as_keyword = value;
+    } else {
+      continue;
+    }
+#define XX(NAME, TYPE, SUBTYPECHECK, LBP, NUD, LED, STD) \
+    if (sym_##NAME.led && token.type == YRC_TOKEN_##TYPE && token.info.SUBTYPECHECK) {\
+      lbp[value] = LBP;\
+      continue;\
+    }
+SYMBOLS(XX)
+#undef XX
+  }
+}
+
+YRC_EXTERN uint64_t yrc_now(void) {
+#ifdef _WIN32
+  LARGE_INTEGER count;
+  LARGE_INTEGER freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (uint64_t)(count.QuadPart / freq.QuadPart) * 1000000000 +
+         (uint64_t)(count.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/**
+  runs every `budget` tokens. past the deadline the parse fails; once the
+  request's own budget is spent, it fails too unless there's an
+  `exhausted` callback (see feed.c) to say carry on.
+**/
+static int out_of_budget(yrc_parser_state_t* parser) {
+  parser->spent = 0;
+  if (parser->deadline && yrc_now() >= parser->deadline) {
+    parser->over_budget = 1;
+    return 1;
+  }
+  if (!parser->limited ||
+      (parser->exhausted && parser->exhausted(parser->exhaustedctx) == 0)) {
+    return 0;
+  }
+  parser->over_budget = 1;
+  return 1;
+}
+
+static void set_budget(yrc_parser_state_t* parser, yrc_parse_request_t* req) {
+  parser->limited = req->budget != 0;
+  parser->budget = req->budget ? req->budget : req->deadline ? kDeadlineEvery : 0;
+  parser->deadline = req->deadline;
+}
+
 static int advance(yrc_parser_state_t* parser, uint_fast8_t flags) {
   yrc_token_t* token = NULL;
   uint_fast8_t allow_regexp = flags & (YRC_IS_REGEXP | YRC_IS_REGEXP_EQ);
+  YRC_STAT_TIMER(scan_start)
   if (parser->token == &eof) {
     return 0;
   }
+  if (parser->budget && ++parser->spent == parser->budget && out_of_budget(parser)) {
+    return 1;
+  }
+  /* when validating, only the current token outlives the next scan */
+  if (parser->validate && yrc_tokenizer_release(parser->tokenizer, parser->token)) {
+    return 1;
+  }
 
+  YRC_STAT_TIMER_START(scan_start);
   if (yrc_tokenizer_scan(parser->tokenizer, parser->readcb, &token, allow_regexp)) {
+    parser->scan_failed = 1;
     return 1;
   }
+  YRC_STAT_TIMER_STOP(parser, scan_ns, scan_start);
 
   if (token == NULL) {
     parser->last = parser->token;
@@ -1166,6 +1434,10 @@ static int expression(yrc_parser_state_t* parser, uint_fast32_t rbp, yrc_ast_nod
   yrc_token_t* tok = parser->token;
   yrc_scan_allow_regexp type = YRC_ISNT_REGEXP;
 
+#ifdef YRC_STATS
+  ++parser->depth;
+  YRC_STAT_MAX(parser, max_depth, parser->depth);
+#endif
   if (IS_OP(tok, DIV)) {
     type = YRC_IS_REGEXP;
   } else if (IS_OP(tok, DIVEQ)) {
@@ -1176,11 +1448,17 @@ static int expression(yrc_parser_state_t* parser, uint_fast32_t rbp, yrc_ast_nod
     return 1;
   }
   if (sym->nud == NULL) {
+    parser->unexpected = tok;
     return 1;
   }
   if (sym->nud(parser, tok, &left)) {
     return 1;
   }
+  /* a parenthesized expression keeps the extent inside its parens */
+  if (!left->has_parens) {
+    left->first = tok;
+    left->last = parser->last;
+  }
   while (rbp < parser->symbol->lbp) {
     sym = parser->symbol;
     if (advance(parser, flags)) {
@@ -1189,33 +1467,43 @@ static int expression(yrc_parser_state_t* parser, uint_fast32_t rbp, yrc_ast_nod
     if (sym->led == NULL) {
       return 1;
     }
+    parser->lbp = sym->lbp;
     if (sym->led(parser, left, &left)) {
       return 1;
     }
+    left->first = tok;
+    left->last = parser->last;
   }
 
+#ifdef YRC_STATS
+  --parser->depth;
+#endif
   *out = left;
   return 0;
 }
 
 
 int commaexpression(yrc_parser_state_t* parser, uint_fast32_t rbp, yrc_ast_node_t** out, uint_fast8_t flags) {
+  yrc_token_t* first = parser->token;
   if (expression(parser, rbp, out, flags)) {
     return 1;
   }
   if (IS_OP(parser->token, COMMA)) {
     yrc_ast_node_t* seq = NULL;
-    seq = yrc_pool_attain(parser->node_pool);
+    seq = attain_node(parser, YRC_AST_EXPR_SEQUENCE);
     if (seq == NULL) {
       return 1;
     }
-    seq->kind = YRC_AST_EXPR_SEQUENCE;
     seq->data.as_sequence.left = *out;
     *out = seq;
     if (advance(parser, YRC_ISNT_REGEXP)) {
       return 1;
     }
-    return commaexpression(parser, 0, &seq->data.as_sequence.right, 0);
+    if (commaexpression(parser, 0, &seq->data.as_sequence.right, 0)) {
+      return 1;
+    }
+    seq->first = first;
+    seq->last = parser->last;
   }
   return 0;
 }
@@ -1223,25 +1511,30 @@ int commaexpression(yrc_parser_state_t* parser, uint_fast32_t rbp, yrc_ast_node_
 
 static int statement(yrc_parser_state_t* parser, yrc_ast_node_t** out, uint_fast8_t flags) {
   yrc_parser_symbol_t* sym = parser->symbol;
+  yrc_token_t* first = parser->token;
   yrc_ast_node_t* node;
   if (sym->std) {
     if (advance(parser, YRC_ISNT_REGEXP)) {
       return 1;
     }
-    if (sym->std(parser, out, flags)) {
+    if (sym->std(parser, &node, flags)) {
       return 1;
     }
+    node->first = first;
+    node->last = parser->last;
+    *out = node;
     return 0;
   }
-  node = yrc_pool_attain(parser->node_pool);
+  node = attain_node(parser, YRC_AST_STMT_EXPR);
   *out = node;
   if (node == NULL) {
     return 1;
   }
-  node->kind = YRC_AST_STMT_EXPR;
+  node->first = first;
   if (commaexpression(parser, 0, &node->data.as_exprstmt.expression, flags)) {
     return 1;
   }
+  node->last = parser->last;
 
   if (!(flags & CONSUME_SEMICOLON)) {
     return 0;
@@ -1251,118 +1544,469 @@ static int statement(yrc_parser_state_t* parser, yrc_ast_node_t** out, uint_fast
     return !(parser->saw_newline || IS_OP(parser->token, RBRACE) || IS_EOF(parser->token));
   }
   /* consume semicolon! */
+  node->last = parser->token;
   if (advance(parser, YRC_ISNT_REGEXP)) {
     return 1;
   }
   return 0;
 }
 
-static int statements(yrc_parser_state_t* parser, yrc_llist_t* out) {
+static inline int at_statements_end(yrc_parser_state_t* parser) {
+  return IS_OP(parser->token, RBRACE) ||
+         IS_EOF(parser->token) ||
+         IS_KW(parser->token, CASE) ||
+         IS_KW(parser->token, DEFAULT);
+}
+
+static int list_statement(yrc_parser_state_t* parser, yrc_ast_node_t** out) {
+  yrc_ast_node_t* stmt = NULL;
+  if (IS_OP(parser->token, SEMICOLON)) {
+    stmt = attain_node(parser, YRC_AST_STMT_EMPTY);
+    if (stmt == NULL) {
+      return 1;
+    }
+    stmt->first =
+    stmt->last = parser->token;
+    if (advance(parser, YRC_ISNT_REGEXP)) {
+      return 1;
+    }
+  } else if (statement(parser, &stmt, CONSUME_SEMICOLON)) {
+    return 1;
+  }
+  *out = stmt;
+  return 0;
+}
+
+static int span_list_init(yrc_span_list_t** out, yrc_token_t* open) {
+  yrc_span_list_t* list = malloc(sizeof(*list));
+  *out = list;
+  if (list == NULL) {
+    return 1;
+  }
+  list->open = open;
+  list->close = NULL;
+  list->count = 0;
+  list->capacity = 0;
+  list->spans = NULL;
+  return 0;
+}
+
+static int span_list_push(yrc_span_list_t* list, yrc_token_t* first, yrc_token_t* last, yrc_ast_node_t* node) {
+  yrc_span_t* grown;
+  if (list->count == list->capacity) {
+    list->capacity = list->capacity ? list->capacity * 2 : 8;
+    grown = realloc(list->spans, list->capacity * sizeof(*grown));
+    if (grown == NULL) {
+      return 1;
+    }
+    list->spans = grown;
+  }
+  list->spans[list->count].first = first;
+  list->spans[list->count].last = last;
+  list->spans[list->count].node = node;
+  ++list->count;
+  return 0;
+}
+
+static void span_list_free(yrc_span_list_t* list) {
+  if (list) {
+    free(list->spans);
+    free(list);
+  }
+}
+
+/* `spans` is set to NULL unless the parse is incremental */
+static int statements(yrc_parser_state_t* parser, yrc_llist_t* out, yrc_span_list_t** spans) {
+  yrc_span_list_t* list = NULL;
   yrc_ast_node_t* stmt;
-  while (1) {
-    if (IS_OP(parser->token, RBRACE) ||
-        IS_EOF(parser->token) ||
-        IS_KW(parser->token, CASE) ||
-        IS_KW(parser->token, DEFAULT)) {
-      break;
+  yrc_token_t* first;
+  *spans = NULL;
+  if (parser->incremental && span_list_init(&list, parser->last)) {
+    return 1;
+  }
+  if (list && pend(parser, list, kPendingSpans)) {
+    span_list_free(list);
+    return 1;
+  }
+  *spans = list;
+  while (!at_statements_end(parser)) {
+    first = parser->token;
+    if (list_statement(parser, &stmt)) {
+      return 1;
     }
-    stmt = NULL;
-    if (IS_OP(parser->token, SEMICOLON)) {
-      stmt = yrc_pool_attain(parser->node_pool);
-      if (stmt == NULL) {
-        return 1;
-      }
-      stmt->kind = YRC_AST_STMT_EMPTY;
-      if (advance(parser, YRC_ISNT_REGEXP)) {
-        return 1;
-      }
-    } else if (statement(parser, &stmt, CONSUME_SEMICOLON)) {
+    if (list_push(parser, out, stmt)) {
       return 1;
     }
-    if (yrc_llist_push(out, stmt)) {
+    if (list && span_list_push(list, first, parser->last, stmt)) {
       return 1;
     }
   }
+  if (list) {
+    list->close = IS_EOF(parser->token) ? NULL : parser->token;
+  }
   return 0;
 }
 
+#ifdef YRC_STATS
+typedef struct stats_visitor_s {
+  yrc_visitor_t visitor;  /* visitor *must* come first! */
+  yrc_parse_stats_t* stats;
+} stats_visitor_t;
+
+static yrc_visitor_mode count_node(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  ++((stats_visitor_t*)ctx)->stats->nodes[node->kind];
+  return kYrcTraverseContinue;
+}
+
+static int count_nodes(yrc_parser_state_t* parser, yrc_ast_node_t* node) {
+  stats_visitor_t visitor;
+  visitor.visitor.enter = count_node;
+  visitor.visitor.exit = NULL;
+  visitor.visitor.mask = YRC_TRAVERSE_ALL;
+  visitor.stats = parser->stats;
+  return yrc_traverse(node, &visitor.visitor);
+}
+# define COUNT_NODES(parser, node) count_nodes(parser, node)
+#else
+# define COUNT_NODES(parser, node) 0
+#endif
+
+/* streaming mode: hand each top-level statement off, then recycle it */
+static int stream_statements(yrc_parser_state_t* parser) {
+  yrc_ast_node_t* stmt;
+  size_t mark;
+  while (!at_statements_end(parser)) {
+    mark = parser->npending;
+    if (list_statement(parser, &stmt)) {
+      return 1;
+    }
+    if (COUNT_NODES(parser, stmt)) {
+      return 1;
+    }
+    if (parser->stmtcb(stmt, parser->stmtctx)) {
+      parser->aborted = 1;
+      return 1;
+    }
+    if (release_statement(parser, stmt)) {
+      return 1;
+    }
+    parser->npending = mark;
+  }
+  return 0;
+}
+
+/* why a parse failed, from where the parser stopped; NULL if out of memory */
+static yrc_error_t* parse_error(yrc_parser_state_t* parser) {
+  yrc_parse_error_t* error = malloc(sizeof(*error));
+  yrc_token_t* got = parser->unexpected ? parser->unexpected : parser->token;
+  yrc_position_t pos;
+  if (error == NULL) {
+    return NULL;
+  }
+  memset(error, 0, sizeof(*error));
+  error->type = parser->over_budget ? YRC_EBUDGET :
+                parser->scan_failed ? YRC_EBADTOKEN : YRC_EUNEXPECTED;
+  error->got.type = YRC_TOKEN_EOF;
+  error->expected.type = YRC_TOKEN_EOF;
+  if (parser->scan_failed || got == NULL || IS_EOF(got)) {
+    yrc_tokenizer_position(parser->tokenizer, &pos);
+  } else {
+    error->got.type = got->type;
+    if (got->type == YRC_TOKEN_OPERATOR || got->type == YRC_TOKEN_KEYWORD) {
+      error->got.info.as_operator = got->info.as_operator;
+    }
+    error->got.start = got->start;
+    error->got.end = got->end;
+    pos = got->start;
+  }
+  error->line = pos.line;
+  error->col = pos.line > 1 && pos.col ? pos.col - 1 : pos.col;
+  error->fpos = pos.fpos;
+  return (yrc_error_t*)error;
+}
+
 YRC_EXTERN int yrc_parse(yrc_parse_request_t* req, yrc_parse_response_t** out) {
-  yrc_llist_t* stmts;
-  yrc_parser_state_t parser = {
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    0,
-    1,
-    NULL
-  };
+  return yrc_parse_exhaustible(req, out, NULL, NULL);
+}
+
+int yrc_parse_exhaustible(yrc_parse_request_t* req, yrc_parse_response_t** out,
+                          yrc_parser_exhaustedcb exhausted, void* ctx) {
+  yrc_llist_t* stmts = NULL;
+  yrc_span_list_t* spans = NULL;
+  yrc_parser_state_t parser;
   yrc_parse_response_priv_t* resp;
+  YRC_STAT_TIMER(parse_start)
+  YRC_STAT_TIMER_START(parse_start);
+  *out = NULL;
+  memset(&parser, 0, sizeof(parser));
+  parser.allow_comma = 1;
   resp = malloc(sizeof(*resp));
+  if (resp == NULL) {
+    return 1;
+  }
   resp->response.error = NULL;
   resp->response.root = NULL;
+  resp->response.stats = NULL;
+  resp->arena = NULL;
+  resp->arena_nodes = 0;
+  resp->release_blob = NULL;
+  resp->segments = NULL;
+  resp->nsegments = 0;
   parser.errorptr = &resp->response.error;
   parser.readcb = req->read;
+  parser.stmtcb = req->statement;
+  parser.stmtctx = req->statementctx;
+  parser.incremental = req->incremental && !req->statement;
+  parser.exhausted = exhausted;
+  parser.exhaustedctx = ctx;
+  set_budget(&parser, req);
   if (yrc_tokenizer_init(&parser.tokenizer, req->readsize, req->readctx)) {
+    free(resp);
     return 1;
   }
+#ifdef YRC_STATS
+  memset(&resp->stats, 0, sizeof(resp->stats));
+  resp->response.stats = parser.stats = &resp->stats;
+  yrc_tokenizer_set_stats(parser.tokenizer, parser.stats);
+#endif
 
-  if (yrc_pool_init(&parser.node_pool, sizeof(yrc_ast_node_t))) {
+  if (init_node_pool(&parser.node_pool)) {
     yrc_tokenizer_free(parser.tokenizer);
+    free(resp);
     return 1;
   }
   resp->tokenizer = parser.tokenizer;
   resp->node_pool = parser.node_pool;
 
-  if (advance(&parser, YRC_ISNT_REGEXP)) {
-    yrc_tokenizer_free(parser.tokenizer);
-    yrc_pool_free(parser.node_pool);
+  if (advance(&parser, YRC_ISNT_REGEXP) ||
+      yrc_llist_init(&stmts) ||
+      (parser.stmtcb ? stream_statements(&parser) : statements(&parser, stmts, &spans))) {
+    goto failed;
+  }
+  resp->response.root = attain_node(&parser, YRC_AST_PROGRAM);
+  if (resp->response.root == NULL) {
+    goto failed;
+  }
+  settle_pending(&parser, 0);
+
+  resp->response.root->data.as_program.body = stmts;
+  resp->response.root->data.as_program.spans = spans;
+  YRC_STAT_TIMER_STOP(&parser, parse_ns, parse_start);
+  YRC_STAT_ADD(&parser, parse_ns, -parser.stats->scan_ns);
+  YRC_STAT_SET(&parser, node_arenas, yrc_pool_arena_count(parser.node_pool));
+  YRC_STAT_SET(&parser, node_bytes, yrc_pool_byte_count(parser.node_pool));
+  if (COUNT_NODES(&parser, resp->response.root)) {
+    yrc_parse_free((yrc_parse_response_t*)resp);
     return 1;
   }
+  *out = (yrc_parse_response_t*)resp;
+  return 0;
 
-  if (yrc_llist_init(&stmts)) {
+failed:
+  /* all that's left of a failed parse is why, if there's room to say */
+  resp->response.error = parser.aborted ? NULL : parse_error(&parser);
+  settle_pending(&parser, 1);
+  if (stmts) {
     yrc_llist_free(stmts);
-    yrc_pool_free(parser.node_pool);
+  }
+  yrc_tokenizer_free(parser.tokenizer);
+  yrc_pool_free(parser.node_pool);
+  resp->tokenizer = NULL;
+  resp->node_pool = NULL;
+  if (resp->response.error == NULL) {
+    free(resp);
     return 1;
   }
+  *out = (yrc_parse_response_t*)resp;
+  return 1;
+}
 
-  if (statements(&parser, stmts)) {
-    yrc_llist_free(stmts);
-    yrc_tokenizer_free(parser.tokenizer);
-    yrc_pool_free(parser.node_pool);
+
+/**
+  validation runs the parser as usual, but advance() lets go of every
+  token behind the current one, and no nodes or lists are built (see
+  attain_node), so memory stays flat however long the input.
+**/
+YRC_EXTERN int yrc_validate(yrc_parse_request_t* req, yrc_error_t** error) {
+  yrc_span_list_t* spans = NULL;
+  yrc_parser_state_t parser;
+  int rc;
+
+  memset(&parser, 0, sizeof(parser));
+  parser.allow_comma = 1;
+  parser.readcb = req->read;
+  parser.validate = 1;
+  set_budget(&parser, req);
+  *error = NULL;
+  if (yrc_tokenizer_init(&parser.tokenizer, req->readsize, req->readctx)) {
     return 1;
   }
+  rc = advance(&parser, YRC_ISNT_REGEXP) ||
+       statements(&parser, NULL, &spans) ||
+       !IS_EOF(parser.token);
+  if (rc) {
+    *error = parse_error(&parser);
+  }
+  yrc_tokenizer_free(parser.tokenizer);
+  return rc;
+}
 
-  resp->response.root = yrc_pool_attain(parser.node_pool);
-  if (resp->response.root == NULL) {
-    yrc_llist_free(stmts);
-    yrc_tokenizer_free(parser.tokenizer);
-    yrc_pool_free(parser.node_pool);
+
+static const char* error_token(yrc_parse_error_t* error) {
+  switch (error->got.type) {
+    case YRC_TOKEN_OPERATOR:
+    case YRC_TOKEN_KEYWORD:
+      return TOKEN_OPERATOR_MAP[error->got.info.as_operator];
+    case YRC_TOKEN_STRING: return "string";
+    case YRC_TOKEN_NUMBER: return "number";
+    case YRC_TOKEN_REGEXP: return "regexp";
+    case YRC_TOKEN_IDENT: return "identifier";
+    default: return error->type == YRC_EUNEXPECTED ? "end of input" : NULL;
+  }
+}
+
+YRC_EXTERN int yrc_error(yrc_error_t* error, char* buf, size_t size) {
+  yrc_token_type got;
+  const char* quote;
+  if (error == NULL || size == 0) {
+    return 1;
+  }
+  switch (error->type) {
+    case YRC_EUNEXPECTED:
+      /* operators and keywords are quoted, other tokens just named */
+      got = ((yrc_parse_error_t*)error)->got.type;
+      quote = got == YRC_TOKEN_OPERATOR || got == YRC_TOKEN_KEYWORD ? "`" : "";
+      snprintf(buf, size, "%lu:%lu: unexpected %s%s%s",
+               (unsigned long)error->line, (unsigned long)error->col + 1,
+               quote, error_token((yrc_parse_error_t*)error), quote);
+      return 0;
+    case YRC_EBADTOKEN:
+      snprintf(buf, size, "%lu:%lu: invalid or unexpected token",
+               (unsigned long)error->line, (unsigned long)error->col + 1);
+      return 0;
+    case YRC_EMEM:
+      snprintf(buf, size, "out of memory");
+      return 0;
+    case YRC_EBUDGET:
+      snprintf(buf, size, "%lu:%lu: out of time or tokens",
+               (unsigned long)error->line, (unsigned long)error->col + 1);
+      return 0;
+    default:
+      snprintf(buf, size, "%lu:%lu: not allowed here",
+               (unsigned long)error->line, (unsigned long)error->col + 1);
+      return 0;
+  }
+}
+
+YRC_EXTERN int yrc_error_token(yrc_error_t* error, const char** out) {
+  *out = NULL;
+  if (error == NULL || error->type != YRC_EUNEXPECTED) {
     return 1;
   }
+  *out = error_token((yrc_parse_error_t*)error);
+  return 0;
+}
 
-  resp->response.root->kind = YRC_AST_PROGRAM;
-  resp->response.root->data.as_program.body = stmts;
-  *out = (yrc_parse_response_t*)resp;
+YRC_EXTERN int yrc_error_position(yrc_error_t* error, size_t* line, size_t* col, size_t* fpos) {
+  if (error == NULL || error->type == YRC_EMEM) {
+    return 1;
+  }
+  *line = error->line;
+  *col = error->col;
+  *fpos = error->fpos;
   return 0;
 }
 
 
 static yrc_visitor_mode free_node(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx);
 
+/**
+  a streamed statement's nodes go back to the pool as the walk leaves
+  them. a shorthand property's key is its value too, and is visited as
+  both: it goes back on the second visit, since the first is followed by
+  another enter of the same node.
+**/
+typedef struct release_visitor_s {
+  yrc_visitor_t visitor;  /* visitor *must* come first! */
+  yrc_pool_t* pool;
+} release_visitor_t;
+
+static yrc_visitor_mode release_node(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  release_visitor_t* release = ctx;
+  if (rel == REL_KEY && parent->data.as_property.expression == node) {
+    return kYrcTraverseContinue;
+  }
+  free_node(node, rel, parent, NULL);
+  yrc_pool_release(release->pool, node);
+  return kYrcTraverseContinue;
+}
+
+static int release_statement(yrc_parser_state_t* parser, yrc_ast_node_t* stmt) {
+  release_visitor_t release;
+  release.visitor.enter = NULL;
+  release.visitor.exit = release_node;
+  release.visitor.mask = YRC_TRAVERSE_ALL;
+  release.pool = parser->node_pool;
+  if (yrc_traverse(stmt, &release.visitor)) {
+    return 1;
+  }
+  /* the lookahead token belongs to the next statement */
+  return yrc_tokenizer_release(parser->tokenizer, parser->token);
+}
 
-YRC_EXTERN int yrc_parse_free(yrc_parse_response_t* resp_) {
-  yrc_parse_response_priv_t* resp;
+
+/* releases the lists (and spans) under a tree; nodes go with their pools */
+static void list_free_visitor(yrc_visitor_t* visitor) {
+  visitor->exit = free_node;
+  visitor->enter = NULL;
+  /* only nodes that own lists need any freeing */
+  visitor->mask = YRC_TRAVERSE_KIND(CLSE_CASE) |
+                  YRC_TRAVERSE_KIND(STMT_SWITCH) |
+                  YRC_TRAVERSE_KIND(EXPR_FUNCTION) |
+                  YRC_TRAVERSE_KIND(DECL_FUNCTION) |
+                  YRC_TRAVERSE_KIND(DECL_VAR) |
+                  YRC_TRAVERSE_KIND(PROGRAM) |
+                  YRC_TRAVERSE_KIND(STMT_BLOCK) |
+                  YRC_TRAVERSE_KIND(EXPR_OBJECT) |
+                  YRC_TRAVERSE_KIND(EXPR_ARRAY) |
+                  YRC_TRAVERSE_KIND(EXPR_CALL);
+}
+
+static void free_contents(yrc_parse_response_priv_t* resp) {
+  yrc_parse_segment_t* segment;
   yrc_visitor_t visitor;
-  visitor.exit = free_node;
-  visitor.enter = NULL;
-  resp = (yrc_parse_response_priv_t*)resp_;
+  list_free_visitor(&visitor);
 
-  yrc_traverse(resp->response.root, &visitor);
-  yrc_tokenizer_free(resp->tokenizer);
-  yrc_pool_free(resp->node_pool);
+  if (resp->arena) {
+    /* arena nodes are contiguous, so there's no need to walk the tree */
+    yrc_ast_free_lists(resp->arena, resp->arena_nodes);
+  } else if (resp->response.root) {
+    yrc_traverse(resp->response.root, &visitor);
+  }
+  if (resp->tokenizer) {
+    yrc_tokenizer_free(resp->tokenizer);
+  }
+  if (resp->node_pool) {
+    yrc_pool_free(resp->node_pool);
+  }
+  while ((segment = resp->segments) != NULL) {
+    resp->segments = segment->next;
+    yrc_tokenizer_free(segment->tokenizer);
+    yrc_pool_free(segment->node_pool);
+    free(segment);
+  }
+  free(resp->arena);
+  if (resp->release_blob) {
+    resp->release_blob(resp->blob, resp->blob_size);
+  }
+}
+
+YRC_EXTERN int yrc_parse_free(yrc_parse_response_t* resp_) {
+  if (resp_ == NULL) {
+    return 0;
+  }
+  free_contents((yrc_parse_response_priv_t*)resp_);
+  free(resp_->error);
   free(resp_);
   return 0;
 }
@@ -1372,6 +2016,7 @@ static yrc_visitor_mode free_node(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_nod
     default: return kYrcTraverseContinue;
     case YRC_AST_CLSE_CASE:
       yrc_llist_free(node->data.as_case.consequent);
+      span_list_free(node->data.as_case.spans);
     break;
     case YRC_AST_STMT_SWITCH:
       yrc_llist_free(node->data.as_switch.cases);
@@ -1387,6 +2032,7 @@ static yrc_visitor_mode free_node(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_nod
     case YRC_AST_PROGRAM:
     case YRC_AST_STMT_BLOCK:
       yrc_llist_free(node->data.as_block.body);
+      span_list_free(node->data.as_block.spans);
     break;
     case YRC_AST_EXPR_OBJECT:
       if (node->data.as_object.properties)
@@ -1403,3 +2049,364 @@ static yrc_visitor_mode free_node(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_nod
   }
   return kYrcTraverseContinue;
 }
+
+
+/**
+  incremental reparsing. the edit is located in the innermost statement
+  list whose delimiters it falls between, and parsing restarts at the
+  start of the statement it touches -- or the one before, when the edit
+  reaches that statement's first token, since automatic semicolon
+  insertion can join the two. a statement boundary is always a safe
+  restart point: the tokenizer is in its default state and a `/` there
+  opens a regexp.
+
+  new statements are parsed until the next one starts at a boundary the
+  old list had past the edit, at which point the old statements from
+  there on are reused as they are. if instead the list ends somewhere
+  other than where it used to (the edit added or removed a brace), the
+  enclosing list is tried instead. tokens after the resync point are
+  moved to their new positions.
+
+  spliced-out nodes and tokens stay in their pools until the response is
+  freed, so after kMaxSegments reparses the whole text is parsed afresh.
+**/
+#define kMaxSegments 16
+#define kMaxDepth 64
+#define kReparseChunk 4096
+
+typedef struct text_reader_s {
+  const char* text;
+  size_t size;
+  size_t pos;
+} text_reader_t;
+
+static size_t read_text(char* data, size_t desired, void* ctx) {
+  text_reader_t* reader = ctx;
+  size_t avail = reader->size - reader->pos;
+  if (desired > avail) {
+    desired = avail;
+  }
+  memcpy(data, reader->text + reader->pos, desired);
+  reader->pos += desired;
+  return desired;
+}
+
+static yrc_span_list_t* node_spans(yrc_ast_node_t* node) {
+  switch (node->kind) {
+    case YRC_AST_PROGRAM:
+    case YRC_AST_STMT_BLOCK:
+      return node->data.as_block.spans;
+    case YRC_AST_CLSE_CASE:
+      return node->data.as_case.spans;
+    default:
+      return NULL;
+  }
+}
+
+static void set_node_body(yrc_ast_node_t* node, yrc_llist_t* body, yrc_span_list_t* spans) {
+  if (node->kind == YRC_AST_CLSE_CASE) {
+    yrc_llist_free(node->data.as_case.consequent);
+    span_list_free(node->data.as_case.spans);
+    node->data.as_case.consequent = body;
+    node->data.as_case.spans = spans;
+  } else {
+    yrc_llist_free(node->data.as_block.body);
+    span_list_free(node->data.as_block.spans);
+    node->data.as_block.body = body;
+    node->data.as_block.spans = spans;
+  }
+}
+
+static int spans_contain(yrc_span_list_t* spans, const yrc_edit_t* edit) {
+  return (spans->open == NULL || spans->open->end.fpos <= edit->start) &&
+         (spans->close == NULL || edit->old_end <= spans->close->start.fpos);
+}
+
+/* index of the first span whose last token ends at or after `fpos` */
+static size_t span_ending_after(yrc_span_list_t* spans, size_t fpos) {
+  size_t lo = 0;
+  size_t hi = spans->count;
+  size_t mid;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (spans->spans[mid].last->end.fpos < fpos) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* index of the span whose first token starts at `fpos`, or `count` */
+static size_t span_starting_at(yrc_span_list_t* spans, size_t fpos) {
+  size_t lo = 0;
+  size_t hi = spans->count;
+  size_t mid;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (spans->spans[mid].first->start.fpos < fpos) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < spans->count && spans->spans[lo].first->start.fpos == fpos ? lo : spans->count;
+}
+
+typedef struct find_visitor_s {
+  yrc_visitor_t visitor;  /* visitor *must* come first! */
+  const yrc_edit_t* edit;
+  yrc_ast_node_t* found;
+} find_visitor_t;
+
+/* finds the outermost statement list under a node that contains the edit */
+static yrc_visitor_mode find_list(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  find_visitor_t* visitor = ctx;
+  yrc_span_list_t* spans = node_spans(node);
+  if (spans == NULL) {
+    return kYrcTraverseContinue;
+  }
+  if (!spans_contain(spans, visitor->edit)) {
+    return kYrcTraverseSkip;
+  }
+  visitor->found = node;
+  return kYrcTraverseStop;
+}
+
+static void free_statements(yrc_span_list_t* spans, size_t from, size_t to) {
+  yrc_visitor_t visitor;
+  list_free_visitor(&visitor);
+  for (; from < to; ++from) {
+    yrc_traverse(spans->spans[from].node, &visitor);
+  }
+}
+
+static int append_spans(yrc_llist_t* body, yrc_span_list_t* out, yrc_span_list_t* in, size_t from, size_t to) {
+  for (; from < to; ++from) {
+    if (yrc_llist_push(body, in->spans[from].node) ||
+        span_list_push(out, in->spans[from].first, in->spans[from].last, in->spans[from].node)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* 0 when spliced, 1 on error, 2 when the edit escapes `owner`'s list */
+static int reparse_list(yrc_parse_response_priv_t* resp, yrc_ast_node_t* owner,
+                        const yrc_edit_t* edit, const char* text, size_t size) {
+  yrc_parser_state_t parser;
+  yrc_span_list_t* spans = node_spans(owner);
+  yrc_span_list_t* fresh = NULL;
+  yrc_span_list_t* merged = NULL;
+  yrc_llist_t* body = NULL;
+  yrc_llist_t* merged_body = NULL;
+  yrc_parse_segment_t* segment = NULL;
+  yrc_parse_segment_t* old;
+  yrc_error_t* error = NULL;
+  yrc_ast_node_t* stmt;
+  yrc_token_t* first;
+  yrc_position_t restart;
+  yrc_position_t from;
+  yrc_position_t to;
+  text_reader_t reader;
+  size_t i;
+  size_t j;
+  int resynced = 0;
+  int rc = 1;
+
+  i = span_ending_after(spans, edit->start);
+  if ((i == spans->count || edit->start <= spans->spans[i].first->end.fpos) && i > 0) {
+    --i;
+  }
+  if (i < spans->count && spans->spans[i].first->start.fpos <= edit->start) {
+    restart = spans->spans[i].first->start;
+  } else if (spans->open) {
+    restart = spans->open->end;
+  } else {
+    restart.fpos = 0;
+    restart.line = 1;
+    restart.col = 0;
+  }
+
+  reader.text = text;
+  reader.size = size;
+  reader.pos = restart.fpos;
+  memset(&parser, 0, sizeof(parser));
+  parser.allow_comma = 1;
+  parser.readcb = read_text;
+  parser.errorptr = &error;
+  parser.incremental = 1;
+  if (yrc_tokenizer_init(&parser.tokenizer, kReparseChunk, &reader)) {
+    return 1;
+  }
+  yrc_tokenizer_set_position(parser.tokenizer, &restart);
+  if (init_node_pool(&parser.node_pool)) {
+    yrc_tokenizer_free(parser.tokenizer);
+    return 1;
+  }
+  if (yrc_llist_init(&body) ||
+      span_list_init(&fresh, spans->open) ||
+      advance(&parser, YRC_ISNT_REGEXP)) {
+    goto cleanup;
+  }
+
+  j = spans->count;
+  while (!at_statements_end(&parser)) {
+    /* past the edit, an old statement starting here can be reused as is */
+    if (parser.token->start.fpos >= edit->new_end) {
+      j = span_starting_at(spans, parser.token->start.fpos - edit->new_end + edit->old_end);
+      if (j < spans->count) {
+        resynced = 1;
+        break;
+      }
+    }
+    first = parser.token;
+    if (list_statement(&parser, &stmt) ||
+        yrc_llist_push(body, stmt) ||
+        span_list_push(fresh, first, parser.last, stmt)) {
+      goto cleanup;
+    }
+  }
+  if (!resynced) {
+    j = spans->count;
+    if (spans->close == NULL ? !IS_EOF(parser.token) :
+        IS_EOF(parser.token) ||
+        parser.token->start.fpos < edit->new_end ||
+        parser.token->start.fpos - edit->new_end + edit->old_end != spans->close->start.fpos) {
+      rc = 2;
+      goto cleanup;
+    }
+  }
+
+  segment = malloc(sizeof(*segment));
+  if (segment == NULL ||
+      yrc_llist_init(&merged_body) ||
+      span_list_init(&merged, spans->open) ||
+      append_spans(merged_body, merged, spans, 0, i) ||
+      append_spans(merged_body, merged, fresh, 0, fresh->count) ||
+      append_spans(merged_body, merged, spans, j, spans->count)) {
+    goto cleanup;
+  }
+  merged->close = spans->close;
+
+  /* nothing can fail from here on */
+  if (resynced || spans->close) {
+    from = resynced ? spans->spans[j].first->start : spans->close->start;
+    to = parser.token->start;
+    if (resp->tokenizer) {
+      yrc_tokenizer_shift(resp->tokenizer, &from, &to);
+    }
+    for (old = resp->segments; old; old = old->next) {
+      yrc_tokenizer_shift(old->tokenizer, &from, &to);
+    }
+  }
+  free_statements(spans, i, j);
+  set_node_body(owner, merged_body, merged);
+  /* a case ends where its last statement does, and that may be new */
+  if (owner->kind == YRC_AST_CLSE_CASE) {
+    owner->last = merged->count ? merged->spans[merged->count - 1].last : merged->open;
+  }
+  yrc_llist_free(body);
+  span_list_free(fresh);
+  settle_pending(&parser, 0);
+
+  segment->tokenizer = parser.tokenizer;
+  segment->node_pool = parser.node_pool;
+  segment->next = resp->segments;
+  resp->segments = segment;
+  ++resp->nsegments;
+  return 0;
+
+cleanup:
+  settle_pending(&parser, 1);
+  if (body) {
+    yrc_llist_free(body);
+  }
+  span_list_free(fresh);
+  if (merged_body) {
+    yrc_llist_free(merged_body);
+  }
+  span_list_free(merged);
+  free(segment);
+  yrc_tokenizer_free(parser.tokenizer);
+  yrc_pool_free(parser.node_pool);
+  return rc;
+}
+
+static int reparse_all(yrc_parse_response_priv_t* resp, const char* text, size_t size) {
+  yrc_parse_response_priv_t old;
+  yrc_parse_response_t* fresh;
+  yrc_parse_request_t req;
+  text_reader_t reader;
+
+  reader.text = text;
+  reader.size = size;
+  reader.pos = 0;
+  memset(&req, 0, sizeof(req));
+  req.read = read_text;
+  req.readsize = 16384;
+  req.readctx = &reader;
+  req.incremental = 1;
+  if (yrc_parse(&req, &fresh)) {
+    yrc_parse_free(fresh);
+    return 1;
+  }
+  old = *resp;
+  *resp = *(yrc_parse_response_priv_t*)fresh;
+#ifdef YRC_STATS
+  resp->response.stats = &resp->stats;
+#endif
+  free(fresh);
+  free_contents(&old);
+  return 0;
+}
+
+YRC_EXTERN int yrc_reparse(yrc_parse_response_t* resp_, const yrc_edit_t* edit, const char* text, size_t size) {
+  yrc_parse_response_priv_t* resp = (yrc_parse_response_priv_t*)resp_;
+  yrc_ast_node_t* owners[kMaxDepth];
+  yrc_span_list_t* spans;
+  find_visitor_t finder;
+  size_t depth = 0;
+  size_t k;
+  int rc;
+
+  if (resp->response.root == NULL ||
+      resp->response.root->data.as_program.spans == NULL ||
+      edit->start > edit->old_end ||
+      edit->start > edit->new_end ||
+      edit->new_end > size) {
+    return 1;
+  }
+  if (resp->nsegments >= kMaxSegments) {
+    return reparse_all(resp, text, size);
+  }
+
+  finder.visitor.enter = find_list;
+  finder.visitor.exit = NULL;
+  finder.visitor.mask = YRC_TRAVERSE_ALL;
+  finder.edit = edit;
+  owners[depth++] = resp->response.root;
+  while (depth < kMaxDepth) {
+    /* descend into the statement that wholly contains the edit, if any */
+    spans = node_spans(owners[depth - 1]);
+    k = span_ending_after(spans, edit->old_end);
+    if (k == spans->count || spans->spans[k].first->start.fpos > edit->start) {
+      break;
+    }
+    finder.found = NULL;
+    if (yrc_traverse(spans->spans[k].node, &finder.visitor) || finder.found == NULL) {
+      break;
+    }
+    owners[depth++] = finder.found;
+  }
+
+  while (depth--) {
+    rc = reparse_list(resp, owners[depth], edit, text, size);
+    if (rc != 2) {
+      return rc;
+    }
+  }
+  /* the program itself ended somewhere new */
+  return reparse_all(resp, text, size);
+}
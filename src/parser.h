@@ -0,0 +1,60 @@
+#ifndef _YRC_PARSER_H
+#define _YRC_PARSER_H
+#include "yrc-common.h"
+#include "pool.h"
+
+/**
+  what a yrc_parse_response_t really points at. a parsed response owns
+  its tokenizer (and so every token) and the node pool; a response built
+  some other way (see serialize.c) may leave those NULL and keep its
+  `arena_nodes` nodes (followed by their tokens) in `arena` instead.
+  yrc_parse_free handles both. if `release_blob` is set it's called with
+  `blob` last of all, for responses whose strings point into a blob the
+  response owns (see cache.c). every yrc_reparse leaves the tokenizer and
+  node pool it parsed with on `segments`, since the spliced tree now
+  holds nodes and tokens from each of them.
+**/
+typedef struct yrc_parse_segment_s {
+  yrc_tokenizer_t*              tokenizer;
+  yrc_pool_t*                   node_pool;
+  struct yrc_parse_segment_s*   next;
+} yrc_parse_segment_t;
+
+typedef struct yrc_parse_response_priv_s {
+  yrc_parse_response_t  response;
+  yrc_tokenizer_t*      tokenizer;
+  yrc_pool_t*           node_pool;
+  void*                 arena;
+  size_t                arena_nodes;
+  void                  (*release_blob)(void*, size_t);
+  void*                 blob;
+  size_t                blob_size;
+  yrc_parse_segment_t*  segments;
+  size_t                nsegments;
+#ifdef YRC_STATS
+  yrc_parse_stats_t     stats;
+#endif
+} yrc_parse_response_priv_t;
+
+/**
+  binding powers, for printing the tree back out. yrc_parser_binding_powers
+  fills `lbp` (YRC_KW_LAST entries, by yrc_operator_t / yrc_keyword_t) with
+  each infix operator's from the parser's symbol table, and 0 for anything
+  that isn't one. prefix operators all bind at YRC_BP_PREFIX.
+**/
+#define YRC_BP_PREFIX 70
+void yrc_parser_binding_powers(uint8_t* lbp);
+
+/**
+  yrc_parse, with a say in what happens when the request's token budget
+  runs out: `exhausted` is called with `ctx` and returns 0 to go on with
+  a fresh budget (after yielding, in feed.c), or non-zero to fail the
+  parse. yrc_parse passes NULL, which always fails.
+**/
+typedef int (*yrc_parser_exhaustedcb)(void*);
+int yrc_parse_exhaustible(yrc_parse_request_t*, yrc_parse_response_t**, yrc_parser_exhaustedcb, void*);
+
+/* frees the lists owned by a flat array of nodes; see serialize.c */
+void yrc_ast_free_lists(yrc_ast_node_t* nodes, size_t count);
+
+#endif
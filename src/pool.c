@@ -3,6 +3,15 @@
 #include <stdlib.h> /* malloc + free */
 #include <string.h> /* memset */
 
+#if defined(YRC_POOL_MMAP) && !defined(_WIN32)
+# define YRC_POOL_CHUNKS
+# include <pthread.h>
+# include <sys/mman.h>
+# ifndef MAP_ANONYMOUS
+#  define MAP_ANONYMOUS MAP_ANON
+# endif
+#endif
+
 yrc_error_t yrc_error_mem;
 
 #ifdef WIN32
@@ -66,6 +75,18 @@ arenaptr
      basically O(1)
   * allocations out of an arena without room whose pool has deallocated are O(N)
   * deallocations are O(1) (and may help avoid O(N) search if a bunch are grouped)
+
+  a pool may also hold several size classes (see yrc_pool_init_classes), each
+  a chain of arenas as above. an arena points back at its class, so release
+  doesn't need telling which one an object came from. only the first class
+  gets an arena up front; the rest wait for their first attain.
+
+  built with YRC_POOL_MMAP, a pool that has grown past kMapAfter bytes
+  carves its further arenas out of 2MB chunks from mmap, aligned and
+  advised (MADV_HUGEPAGE) so the kernel can back each with one huge page
+  and a big parse doesn't walk the TLB across thousands of small pages.
+  small parses never map anything. freed chunks are MADV_DONTNEED'd and
+  kept for the next pool (up to kChunksKept of them) rather than unmapped.
 **/
 
 typedef size_t mask_member_t;
@@ -84,77 +105,207 @@ enum {
     kMaskMemberSize == 8 ? 6 : 7
 };
 
+typedef struct yrc_pool_class_s yrc_pool_class_t;
+
 typedef struct yrc_pool_arena_s {
   struct yrc_pool_arena_s* next;
+  yrc_pool_class_t* owner;
   uint64_t used_mask[kMaskSize];
+  uint_fast8_t mapped;    /* lives in a chunk, rather than from malloc */
   uint_fast32_t free;
-  char data[1];
+  char data[1];           /* keep last, and 8-byte aligned: see yrc_str.h */
 } yrc_pool_arena_t;
 
-struct yrc_pool_s {
+typedef struct yrc_pool_chunk_s {
+  struct yrc_pool_chunk_s* next;
+  size_t used;
+} yrc_pool_chunk_t;
+
+struct yrc_pool_class_s {
   yrc_pool_arena_t* head;
   yrc_pool_arena_t* current;
   yrc_pool_arena_t* last;
   size_t objsize;
-  size_t num_arenas;
   uint_fast8_t deallocs;
 };
 
-static yrc_pool_arena_t* alloc_arena(yrc_pool_t* pool) {
+struct yrc_pool_s {
+  yrc_pool_chunk_t* chunks;
+  size_t num_arenas;
+  size_t num_bytes;
+  size_t num_classes;
+  yrc_pool_class_t classes[1];
+};
+
+#ifdef YRC_POOL_CHUNKS
+enum {
+  kChunkSize=2 * 1024 * 1024,   /* one x86-64 / arm64 huge page */
+  kChunkAlign=64,
+  kMapAfter=kChunkSize,         /* bytes of malloc'd arenas before mapping */
+  kChunksKept=8
+};
+
+static pthread_mutex_t chunks_lock = PTHREAD_MUTEX_INITIALIZER;
+static yrc_pool_chunk_t* chunks_kept = NULL;
+static size_t chunks_kept_count = 0;
+
+#define CHUNK_ALIGN(N) (((N) + kChunkAlign - 1) & ~(size_t)(kChunkAlign - 1))
+
+static yrc_pool_chunk_t* map_chunk(void) {
+  yrc_pool_chunk_t* chunk;
+  char* base;
+  size_t lead;
+  pthread_mutex_lock(&chunks_lock);
+  chunk = chunks_kept;
+  if (chunk) {
+    chunks_kept = chunk->next;
+    --chunks_kept_count;
+  }
+  pthread_mutex_unlock(&chunks_lock);
+  if (chunk == NULL) {
+    /* map twice the size and trim it down to an aligned chunk */
+    base = mmap(NULL, 2 * kChunkSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      return NULL;
+    }
+    lead = (kChunkSize - ((size_t)base & (kChunkSize - 1))) & (kChunkSize - 1);
+    if (lead) {
+      munmap(base, lead);
+    }
+    munmap(base + lead + kChunkSize, kChunkSize - lead);
+    chunk = (yrc_pool_chunk_t*)(base + lead);
+#ifdef MADV_HUGEPAGE
+    madvise(chunk, kChunkSize, MADV_HUGEPAGE);
+#endif
+  }
+  chunk->next = NULL;
+  chunk->used = CHUNK_ALIGN(sizeof(*chunk));
+  return chunk;
+}
+
+static void unmap_chunk(yrc_pool_chunk_t* chunk) {
+  int keep;
+  pthread_mutex_lock(&chunks_lock);
+  keep = chunks_kept_count < kChunksKept;
+  chunks_kept_count += keep;
+  pthread_mutex_unlock(&chunks_lock);
+  if (!keep) {
+    munmap(chunk, kChunkSize);
+    return;
+  }
+  /* the pages go back to the kernel; the mapping (and its advice) stays */
+  madvise(chunk, kChunkSize, MADV_DONTNEED);
+  pthread_mutex_lock(&chunks_lock);
+  chunk->next = chunks_kept;
+  chunks_kept = chunk;
+  pthread_mutex_unlock(&chunks_lock);
+}
+#endif
+
+static void* arena_memory(yrc_pool_t* pool, size_t size, uint_fast8_t* mapped) {
+#ifdef YRC_POOL_CHUNKS
+  yrc_pool_chunk_t* chunk = pool->chunks;
+  void* memory;
+  size = CHUNK_ALIGN(size);
+  if (pool->num_bytes >= kMapAfter && size <= kChunkSize - CHUNK_ALIGN(sizeof(*chunk))) {
+    if (chunk == NULL || kChunkSize - chunk->used < size) {
+      chunk = map_chunk();
+      if (chunk) {
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+      }
+    }
+    if (chunk) {
+      memory = (char*)chunk + chunk->used;
+      chunk->used += size;
+      *mapped = 1;
+      return memory;
+    }
+  }
+#endif
+  *mapped = 0;
+  return malloc(size);
+}
+
+static yrc_pool_arena_t* alloc_arena(yrc_pool_t* pool, yrc_pool_class_t* owner) {
   yrc_pool_arena_t** iter;
   yrc_pool_arena_t* arena;
   uint_fast32_t i;
-  arena = malloc(sizeof(yrc_pool_arena_t) - 1 + (sizeof(yrc_pool_arena_t**) + pool->objsize) * kArenaByteLength);
+  size_t size = sizeof(yrc_pool_arena_t) - 1 + (sizeof(yrc_pool_arena_t**) + owner->objsize) * kArenaByteLength;
+  uint_fast8_t mapped;
+  arena = arena_memory(pool, size, &mapped);
   if (arena == NULL) {
     return NULL;
   }
   arena->next = NULL;
+  arena->owner = owner;
+  arena->mapped = mapped;
   memset(arena->used_mask, 0xFF, kMaskByteLength);
   arena->free = kArenaByteLength;
   ++pool->num_arenas;
+  pool->num_bytes += size;
   iter = (yrc_pool_arena_t**)arena->data;
   for(i = 0; i < kArenaByteLength; ++i) {
     *iter = arena;
-    iter = (void*)((sizeof(yrc_pool_arena_t**) + pool->objsize) + (size_t)(iter));
+    iter = (void*)((sizeof(yrc_pool_arena_t**) + owner->objsize) + (size_t)(iter));
   }
   return arena;
 }
 
 int yrc_pool_init(yrc_pool_t** ptr, size_t objsize) {
-  yrc_pool_t* pool = malloc(sizeof(*pool));
+  return yrc_pool_init_classes(ptr, &objsize, 1);
+}
+
+int yrc_pool_init_classes(yrc_pool_t** ptr, const size_t* objsizes, size_t count) {
+  yrc_pool_t* pool = malloc(sizeof(*pool) + (count - 1) * sizeof(yrc_pool_class_t));
+  size_t i;
   if (pool == NULL) {
     return 1;
   }
-  pool->objsize = objsize;
+  pool->chunks = NULL;
   pool->num_arenas = 0;
-  pool->deallocs = 0;
-  pool->head = alloc_arena(pool);
-  if (pool->head == NULL) {
+  pool->num_bytes = 0;
+  pool->num_classes = count;
+  for (i = 0; i < count; ++i) {
+    pool->classes[i].head = NULL;
+    pool->classes[i].current = NULL;
+    pool->classes[i].last = NULL;
+    pool->classes[i].objsize = objsizes[i];
+    pool->classes[i].deallocs = 0;
+  }
+  pool->classes[0].head = alloc_arena(pool, &pool->classes[0]);
+  if (pool->classes[0].head == NULL) {
     free(pool);
     return 1;
   }
-  pool->last = pool->head;
-  pool->current = pool->head;
+  pool->classes[0].last = pool->classes[0].head;
+  pool->classes[0].current = pool->classes[0].head;
   *ptr = pool;
   return 0;
 }
 
 void* yrc_pool_attain(yrc_pool_t* pool) {
+  return yrc_pool_attain_class(pool, 0);
+}
+
+void* yrc_pool_attain_class(yrc_pool_t* pool, size_t klass) {
+  yrc_pool_class_t* owner = &pool->classes[klass];
   yrc_pool_arena_t* cursor;
+  yrc_pool_arena_t* arena;
   int arena_pos;
   int i;
 retry:
-  if (pool->current->free) {
+  if (owner->current && owner->current->free) {
     for (i = 0; i < kMaskSize; ++i) {
-      if (pool->current->used_mask[i]) {
-        arena_pos = clz(pool->current->used_mask[i]);
-        pool->current->used_mask[i] &= ~(1UL << (kMaskMemberBitLengthMinusOne - arena_pos));
-        --pool->current->free;
+      if (owner->current->used_mask[i]) {
+        arena_pos = clz(owner->current->used_mask[i]);
+        owner->current->used_mask[i] &= ~(1UL << (kMaskMemberBitLengthMinusOne - arena_pos));
+        --owner->current->free;
         return (void*)(
-          (size_t)pool->current->data + 
+          (size_t)owner->current->data + 
           (size_t)(
             (arena_pos + (i << kMaskShift)) * 
-            (pool->objsize + sizeof(yrc_pool_arena_t**)) +
+            (owner->objsize + sizeof(yrc_pool_arena_t**)) +
             sizeof(yrc_pool_arena_t**)
           )
         );
@@ -162,12 +313,20 @@ retry:
     }
   }
   /* if we've seen no deallocations since last time, just skip forward. */
-  if (!pool->deallocs) {
-    pool->last->next = alloc_arena(pool);
-    pool->last = pool->current = pool->last->next;
+  if (!owner->deallocs) {
+    arena = alloc_arena(pool, owner);
+    if (arena == NULL) {
+      return NULL;
+    }
+    if (owner->last) {
+      owner->last->next = arena;
+    } else {
+      owner->head = arena;
+    }
+    owner->last = owner->current = arena;
     goto retry;
   }
-  cursor = pool->head;
+  cursor = owner->head;
   while (cursor) {
     if (cursor->free) {
       break;
@@ -175,34 +334,60 @@ retry:
     cursor = cursor->next;
   }
   if (!cursor) {
-    pool->deallocs = 0;
+    owner->deallocs = 0;
     goto retry;
   }
-  pool->current = cursor;
+  owner->current = cursor;
   goto retry;
 }
 
 int yrc_pool_release(yrc_pool_t* pool, void* ptr) {
   void* baseptr = (void*)((size_t)ptr - sizeof(yrc_pool_arena_t**));
   yrc_pool_arena_t* arena = *(yrc_pool_arena_t**)(baseptr);
+  yrc_pool_class_t* owner = arena->owner;
   int arena_pos = ((uint_fast32_t)((size_t)baseptr - (size_t)arena->data) /
-    (sizeof(yrc_pool_arena_t**) + pool->objsize));
-  arena->used_mask[arena_pos >> kMaskShift] |= 1UL << (arena_pos & kMaskMemberBitLengthMinusOne);
+    (sizeof(yrc_pool_arena_t**) + owner->objsize));
+  /* attain hands out slots from the most significant bit down; mirror that here */
+  arena->used_mask[arena_pos >> kMaskShift] |=
+    1UL << (kMaskMemberBitLengthMinusOne - (arena_pos & kMaskMemberBitLengthMinusOne));
   ++arena->free;
-  pool->deallocs = 1;
-  if (arena->free > pool->current->free) {
-    pool->current = arena;
+  owner->deallocs = 1;
+  if (arena->free > owner->current->free) {
+    owner->current = arena;
   }
   return 0;
 }
 
+size_t yrc_pool_arena_count(yrc_pool_t* pool) {
+  return pool->num_arenas;
+}
+
+size_t yrc_pool_byte_count(yrc_pool_t* pool) {
+  return pool->num_bytes;
+}
+
 int yrc_pool_free(yrc_pool_t* pool) {
-  yrc_pool_arena_t* cursor = pool->head, *next;
-  while (cursor) {
-    next = cursor->next;
-    free(cursor);
-    cursor = next;
+  yrc_pool_arena_t* cursor, *next;
+#ifdef YRC_POOL_CHUNKS
+  yrc_pool_chunk_t* chunk;
+#endif
+  size_t i;
+  for (i = 0; i < pool->num_classes; ++i) {
+    cursor = pool->classes[i].head;
+    while (cursor) {
+      next = cursor->next;
+      if (!cursor->mapped) {
+        free(cursor);
+      }
+      cursor = next;
+    }
+  }
+#ifdef YRC_POOL_CHUNKS
+  while ((chunk = pool->chunks) != NULL) {
+    pool->chunks = chunk->next;
+    unmap_chunk(chunk);
   }
+#endif
   free(pool);
   return 0;
 }
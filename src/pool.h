@@ -6,7 +6,18 @@ typedef struct yrc_pool_s yrc_pool_t;
 int yrc_pool_init(yrc_pool_t**, size_t);
 int yrc_pool_free(yrc_pool_t*);
 
+/**
+  a pool of several object sizes, one chain of arenas per size class;
+  yrc_pool_attain_class takes the class's index into `objsizes`, and
+  yrc_pool_attain is class 0. anything attained goes back through
+  yrc_pool_release whatever its class.
+**/
+int yrc_pool_init_classes(yrc_pool_t**, const size_t* objsizes, size_t count);
+void* yrc_pool_attain_class(yrc_pool_t*, size_t);
+
 void* yrc_pool_attain(yrc_pool_t*);
 int yrc_pool_release(yrc_pool_t*, void*);
+size_t yrc_pool_arena_count(yrc_pool_t*);
+size_t yrc_pool_byte_count(yrc_pool_t*);
 
 #endif
@@ -0,0 +1,161 @@
+#include "yrc-common.h"
+#include <string.h> /* memcpy */
+
+#ifndef _WIN32
+# include <pthread.h>
+#endif
+
+/**
+  double-buffered read-ahead: a background thread keeps calling the
+  wrapped yrc_readcb into whichever buffer is empty while the tokenizer
+  scans the chunk it was last handed. readers see the same byte stream
+  as the wrapped callback; the chunk they get is copied out of the
+  filled buffer, which is cheap next to the read latency it hides.
+
+  on windows reads pass straight through to the wrapped callback.
+**/
+
+typedef struct yrc_prefetch_buf_s {
+  char* data;
+  size_t size;
+  size_t offset;
+  uint_fast8_t filled;
+} yrc_prefetch_buf_t;
+
+struct yrc_prefetch_s {
+  yrc_readcb read;
+  void* readctx;
+  size_t chunksz;
+  yrc_prefetch_buf_t bufs[2];
+  uint_fast8_t reading;    /* buffer the consumer drains next */
+  uint_fast8_t eof;        /* producer saw a zero-length read */
+  uint_fast8_t closing;
+#ifndef _WIN32
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+#endif
+};
+
+#ifndef _WIN32
+static void* produce(void* ctx) {
+  yrc_prefetch_t* pf = ctx;
+  yrc_prefetch_buf_t* buf;
+  uint_fast8_t idx = 0;
+  size_t size;
+
+  while (1) {
+    buf = pf->bufs + idx;
+    pthread_mutex_lock(&pf->lock);
+    while (buf->filled && !pf->closing) {
+      pthread_cond_wait(&pf->cond, &pf->lock);
+    }
+    if (pf->closing) {
+      pthread_mutex_unlock(&pf->lock);
+      break;
+    }
+    pthread_mutex_unlock(&pf->lock);
+
+    /* the read itself happens outside the lock */
+    size = pf->read(buf->data, pf->chunksz, pf->readctx);
+
+    pthread_mutex_lock(&pf->lock);
+    buf->size = size;
+    buf->offset = 0;
+    buf->filled = 1;
+    if (size == 0) {
+      pf->eof = 1;
+    }
+    pthread_cond_broadcast(&pf->cond);
+    pthread_mutex_unlock(&pf->lock);
+    if (size == 0) {
+      break;
+    }
+    idx ^= 1;
+  }
+  return NULL;
+}
+#endif
+
+YRC_EXTERN int yrc_prefetch_init(yrc_prefetch_t** out, yrc_readcb read, void* readctx, size_t chunksz) {
+  yrc_prefetch_t* pf = calloc(1, sizeof(*pf));
+  if (pf == NULL) {
+    return 1;
+  }
+  pf->read = read;
+  pf->readctx = readctx;
+  pf->chunksz = chunksz;
+#ifndef _WIN32
+  pf->bufs[0].data = malloc(chunksz);
+  pf->bufs[1].data = malloc(chunksz);
+  if (pf->bufs[0].data == NULL || pf->bufs[1].data == NULL) {
+    goto cleanup;
+  }
+  pthread_mutex_init(&pf->lock, NULL);
+  pthread_cond_init(&pf->cond, NULL);
+  if (pthread_create(&pf->thread, NULL, produce, pf)) {
+    pthread_mutex_destroy(&pf->lock);
+    pthread_cond_destroy(&pf->cond);
+    goto cleanup;
+  }
+#endif
+  *out = pf;
+  return 0;
+
+#ifndef _WIN32
+cleanup:
+  free(pf->bufs[0].data);
+  free(pf->bufs[1].data);
+  free(pf);
+  return 1;
+#endif
+}
+
+YRC_EXTERN size_t yrc_prefetch_read(char* data, size_t desired, void* ctx) {
+  yrc_prefetch_t* pf = ctx;
+#ifdef _WIN32
+  return pf->read(data, desired, pf->readctx);
+#else
+  yrc_prefetch_buf_t* buf = pf->bufs + pf->reading;
+  size_t toread;
+
+  pthread_mutex_lock(&pf->lock);
+  while (!buf->filled) {
+    pthread_cond_wait(&pf->cond, &pf->lock);
+  }
+  pthread_mutex_unlock(&pf->lock);
+
+  toread = buf->size - buf->offset;
+  if (toread > desired) {
+    toread = desired;
+  }
+  memcpy(data, buf->data + buf->offset, toread);
+  buf->offset += toread;
+
+  /* keep returning 0 at eof: don't hand the empty buffer back */
+  if (buf->offset == buf->size && buf->size) {
+    pthread_mutex_lock(&pf->lock);
+    buf->filled = 0;
+    pf->reading ^= 1;
+    pthread_cond_broadcast(&pf->cond);
+    pthread_mutex_unlock(&pf->lock);
+  }
+  return toread;
+#endif
+}
+
+YRC_EXTERN int yrc_prefetch_free(yrc_prefetch_t* pf) {
+#ifndef _WIN32
+  pthread_mutex_lock(&pf->lock);
+  pf->closing = 1;
+  pthread_cond_broadcast(&pf->cond);
+  pthread_mutex_unlock(&pf->lock);
+  pthread_join(pf->thread, NULL);
+  pthread_mutex_destroy(&pf->lock);
+  pthread_cond_destroy(&pf->cond);
+  free(pf->bufs[0].data);
+  free(pf->bufs[1].data);
+#endif
+  free(pf);
+  return 0;
+}
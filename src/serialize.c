@@ -0,0 +1,826 @@
+#include "yrc-common.h"
+#include "parser.h"
+#include "str.h"
+#include <stddef.h> /* offsetof */
+#include <string.h> /* memcpy + memset */
+
+/**
+  binary AST blobs. a blob holds no pointers: nodes, tokens and lists
+  refer to each other by index, so it can be written to disk and used
+  straight out of a read-only mapping at any address.
+
+  +--------+-------------+--------------+-------------+-------------+---------+
+  | header | node[nodes] | token[tokens]| list[lists] | item[items] | strings |
+  +--------+-------------+--------------+-------------+-------------+---------+
+
+  every section starts on an 8-byte boundary. node slots and list items
+  hold index + 1, with 0 meaning NULL. nodes are numbered in pre-order, so
+  a node's children always have larger indices than it does; that's what
+  lets yrc_ast_deserialize reject cyclic (corrupt) blobs cheaply. strings
+  are NUL-terminated, and long ones are referenced in place rather than
+  copied, which is why a blob has to outlive the responses built from it.
+**/
+
+enum {
+  kBlobVersion=3,
+  kBlobByteOrder=0x01020304,
+  kMaxSlots=4
+};
+
+typedef enum {
+  kSlotNone=0,
+  kSlotNode,
+  kSlotList,
+  kSlotToken,
+  kSlotInt
+} slot_type_t;
+
+typedef struct slot_s {
+  uint_fast8_t type;
+  size_t offset;
+} slot_t;
+
+typedef struct blob_header_s {
+  char      magic[4];
+  uint32_t  version;
+  uint32_t  byte_order;
+  uint32_t  root;
+  uint32_t  nodes;
+  uint32_t  tokens;
+  uint32_t  lists;
+  uint32_t  items;
+  uint64_t  strings;
+  uint64_t  size;
+} blob_header_t;
+
+typedef struct blob_node_s {
+  uint8_t   kind;
+  uint8_t   has_parens;
+  uint16_t  reserved;
+  uint32_t  first;      /* token index + 1, like token slots */
+  uint32_t  last;
+  uint32_t  slots[kMaxSlots];
+} blob_node_t;
+
+typedef struct blob_token_s {
+  uint8_t   type;
+  uint8_t   sub;        /* string + comment delim, number repr */
+  uint16_t  reserved;
+  uint32_t  value;      /* keyword, operator, regexp flags, has_newline, has_escapes */
+  uint64_t  number;
+  uint64_t  str;        /* offset into the string section */
+  uint64_t  str_len;
+  uint64_t  start_fpos;
+  uint64_t  end_fpos;
+  uint64_t  start_line;
+  uint64_t  start_col;
+  uint64_t  end_line;
+  uint64_t  end_col;
+} blob_token_t;
+
+typedef struct blob_list_s {
+  uint32_t  first;
+  uint32_t  count;
+} blob_list_t;
+
+typedef struct blob_sections_s {
+  uint64_t nodes;
+  uint64_t tokens;
+  uint64_t lists;
+  uint64_t items;
+  uint64_t strings;
+  uint64_t size;
+} blob_sections_t;
+
+#define ALIGN8(N) (((N) + 7) & ~(uint64_t)7)
+
+/* byte offsets of each section, given the header's counts */
+static void sections(blob_sections_t* out, uint64_t nodes, uint64_t tokens,
+    uint64_t lists, uint64_t items, uint64_t strings) {
+  out->nodes = ALIGN8(sizeof(blob_header_t));
+  out->tokens = out->nodes + ALIGN8(nodes * sizeof(blob_node_t));
+  out->lists = out->tokens + ALIGN8(tokens * sizeof(blob_token_t));
+  out->items = out->lists + ALIGN8(lists * sizeof(blob_list_t));
+  out->strings = out->items + ALIGN8(items * sizeof(uint32_t));
+  out->size = out->strings + strings;
+}
+
+#define NODE(FIELD) {kSlotNode, offsetof(yrc_ast_node_t, data.FIELD)}
+#define LIST(FIELD) {kSlotList, offsetof(yrc_ast_node_t, data.FIELD)}
+#define TOKEN(FIELD) {kSlotToken, offsetof(yrc_ast_node_t, data.FIELD)}
+#define INT(FIELD) {kSlotInt, offsetof(yrc_ast_node_t, data.FIELD)}
+#define NONE {kSlotNone, 0}
+#define SLOT_PTR(NODE, SLOT) ((void**)((char*)(NODE) + (SLOT)->offset))
+#define SLOT_INT(NODE, SLOT) ((int*)((char*)(NODE) + (SLOT)->offset))
+
+/**
+  which parts of each node's union are live. this is the union as the
+  parser actually fills it in, which isn't always what the member names
+  suggest: catch clauses keep a trailing finally block in as_try.finalizer.
+**/
+static const slot_t* layout(yrc_ast_node_type kind) {
+  static const slot_t none[kMaxSlots] = {NONE, NONE, NONE, NONE};
+  static const slot_t block[kMaxSlots] = {LIST(as_block.body), NONE, NONE, NONE};
+  static const slot_t exprstmt[kMaxSlots] = {NODE(as_exprstmt.expression), NONE, NONE, NONE};
+  static const slot_t conditional[kMaxSlots] = {
+    NODE(as_if.test), NODE(as_if.consequent), NODE(as_if.alternate), NONE
+  };
+  static const slot_t jump[kMaxSlots] = {TOKEN(as_break.label), NONE, NONE, NONE};
+  static const slot_t kase[kMaxSlots] = {NODE(as_case.test), LIST(as_case.consequent), NONE, NONE};
+  static const slot_t swtch[kMaxSlots] = {
+    NODE(as_switch.discriminant), LIST(as_switch.cases), NONE, NONE
+  };
+  static const slot_t ret[kMaxSlots] = {NODE(as_return.argument), NONE, NONE, NONE};
+  static const slot_t try[kMaxSlots] = {
+    NODE(as_try.block), NODE(as_try.handler), NODE(as_try.finalizer), NONE
+  };
+  static const slot_t catch[kMaxSlots] = {
+    NODE(as_catch.param), NODE(as_catch.body), NODE(as_try.finalizer), NONE
+  };
+  static const slot_t vardecl[kMaxSlots] = {NODE(as_vardecl.id), NODE(as_vardecl.init), NONE, NONE};
+  static const slot_t loop[kMaxSlots] = {NODE(as_while.test), NODE(as_while.body), NONE, NONE};
+  static const slot_t forloop[kMaxSlots] = {
+    NODE(as_for.init), NODE(as_for.test), NODE(as_for.update), NODE(as_for.body)
+  };
+  static const slot_t forin[kMaxSlots] = {
+    NODE(as_for_in.left), NODE(as_for_in.right), NODE(as_for_in.body), NONE
+  };
+  static const slot_t function[kMaxSlots] = {
+    TOKEN(as_function.id), LIST(as_function.params),
+    LIST(as_function.defaults), NODE(as_function.body)
+  };
+  static const slot_t var[kMaxSlots] = {LIST(as_var.declarations), INT(as_var.type), NONE, NONE};
+  static const slot_t ident[kMaxSlots] = {TOKEN(as_ident.name), NONE, NONE, NONE};
+  static const slot_t literal[kMaxSlots] = {TOKEN(as_literal.value), NONE, NONE, NONE};
+  static const slot_t array[kMaxSlots] = {LIST(as_array.elements), NONE, NONE, NONE};
+  static const slot_t object[kMaxSlots] = {LIST(as_object.properties), NONE, NONE, NONE};
+  static const slot_t property[kMaxSlots] = {
+    NODE(as_property.key), NODE(as_property.expression), INT(as_property.type), NONE
+  };
+  static const slot_t sequence[kMaxSlots] = {
+    NODE(as_sequence.left), NODE(as_sequence.right), NONE, NONE
+  };
+  static const slot_t unary[kMaxSlots] = {NODE(as_unary.argument), INT(as_unary.op), NONE, NONE};
+  static const slot_t update[kMaxSlots] = {
+    NODE(as_update.argument), INT(as_update.op), INT(as_update.prefix), NONE
+  };
+  static const slot_t binary[kMaxSlots] = {
+    NODE(as_binary.left), NODE(as_binary.right), INT(as_binary.op), NONE
+  };
+  static const slot_t call[kMaxSlots] = {NODE(as_call.callee), LIST(as_call.arguments), NONE, NONE};
+  static const slot_t member[kMaxSlots] = {
+    NODE(as_member.object), NODE(as_member.property), INT(as_member.computed), NONE
+  };
+
+  switch (kind) {
+    case YRC_AST_PROGRAM:
+    case YRC_AST_STMT_BLOCK: return block;
+    case YRC_AST_STMT_EXPR: return exprstmt;
+    case YRC_AST_EXPR_CONDITIONAL:
+    case YRC_AST_STMT_IF: return conditional;
+    case YRC_AST_STMT_BREAK:
+    case YRC_AST_STMT_CONTINUE: return jump;
+    case YRC_AST_CLSE_CASE: return kase;
+    case YRC_AST_STMT_SWITCH: return swtch;
+    case YRC_AST_STMT_THROW:
+    case YRC_AST_STMT_RETURN: return ret;
+    case YRC_AST_STMT_TRY: return try;
+    case YRC_AST_CLSE_CATCH: return catch;
+    case YRC_AST_CLSE_VAR: return vardecl;
+    case YRC_AST_STMT_DOWHILE:
+    case YRC_AST_STMT_WHILE: return loop;
+    case YRC_AST_STMT_FOR: return forloop;
+    case YRC_AST_STMT_FOROF:
+    case YRC_AST_STMT_FORIN: return forin;
+    case YRC_AST_DECL_FUNCTION:
+    case YRC_AST_EXPR_FUNCTION: return function;
+    case YRC_AST_DECL_VAR: return var;
+    case YRC_AST_EXPR_IDENTIFIER: return ident;
+    case YRC_AST_EXPR_LITERAL: return literal;
+    case YRC_AST_EXPR_ARRAY: return array;
+    case YRC_AST_EXPR_OBJECT: return object;
+    case YRC_AST_EXPR_PROPERTY: return property;
+    case YRC_AST_EXPR_SEQUENCE: return sequence;
+    case YRC_AST_EXPR_UNARY: return unary;
+    case YRC_AST_EXPR_UPDATE: return update;
+    case YRC_AST_EXPR_BINARY:
+    case YRC_AST_EXPR_LOGICAL:
+    case YRC_AST_EXPR_ASSIGNMENT: return binary;
+    case YRC_AST_EXPR_CALL: return call;
+    case YRC_AST_EXPR_MEMBER: return member;
+    default: return none;
+  }
+}
+
+#undef NODE
+#undef LIST
+#undef TOKEN
+#undef INT
+#undef NONE
+
+/* open-addressed pointer -> index map, for numbering shared nodes once */
+typedef struct ptrmap_s {
+  void** keys;
+  uint32_t* values;
+  size_t mask;
+  size_t count;
+} ptrmap_t;
+
+static int ptrmap_init(ptrmap_t* map, size_t capacity) {
+  capacity = npot(capacity < 16 ? 16 : capacity);
+  map->keys = calloc(capacity, sizeof(*map->keys));
+  map->values = malloc(capacity * sizeof(*map->values));
+  map->mask = capacity - 1;
+  map->count = 0;
+  return map->keys == NULL || map->values == NULL;
+}
+
+static void ptrmap_free(ptrmap_t* map) {
+  free(map->keys);
+  free(map->values);
+}
+
+static inline size_t ptrmap_slot(ptrmap_t* map, void* key) {
+  size_t hash = (size_t)key;
+  size_t pos;
+  hash ^= hash >> 17;
+  hash *= 0x9E3779B1;
+  pos = hash & map->mask;
+  while (map->keys[pos] && map->keys[pos] != key) {
+    pos = (pos + 1) & map->mask;
+  }
+  return pos;
+}
+
+static int ptrmap_grow(ptrmap_t* map) {
+  ptrmap_t next;
+  size_t i;
+  size_t pos;
+  if (ptrmap_init(&next, (map->mask + 1) << 1)) {
+    ptrmap_free(&next);
+    return 1;
+  }
+  for (i = 0; i <= map->mask; ++i) {
+    if (map->keys[i]) {
+      pos = ptrmap_slot(&next, map->keys[i]);
+      next.keys[pos] = map->keys[i];
+      next.values[pos] = map->values[i];
+    }
+  }
+  next.count = map->count;
+  ptrmap_free(map);
+  *map = next;
+  return 0;
+}
+
+/* 1 if `key` was already present; its index is written to `out` either way */
+static int ptrmap_insert(ptrmap_t* map, void* key, uint32_t* out, int* failed) {
+  size_t pos;
+  if ((map->count + 1) * 2 > map->mask + 1 && ptrmap_grow(map)) {
+    *failed = 1;
+    return 0;
+  }
+  pos = ptrmap_slot(map, key);
+  if (map->keys[pos]) {
+    *out = map->values[pos];
+    return 1;
+  }
+  map->keys[pos] = key;
+  map->values[pos] = *out = (uint32_t)map->count++;
+  return 0;
+}
+
+static uint32_t ptrmap_get(ptrmap_t* map, void* key) {
+  return key ? map->values[ptrmap_slot(map, key)] + 1 : 0;
+}
+
+/* growable array of pointers, used both as the dfs stack and index -> ptr */
+typedef struct ptrvec_s {
+  void** items;
+  size_t size;
+  size_t avail;
+} ptrvec_t;
+
+static int ptrvec_push(ptrvec_t* vec, void* item) {
+  void** items;
+  if (vec->size == vec->avail) {
+    vec->avail = vec->avail ? vec->avail << 1 : 256;
+    items = realloc(vec->items, vec->avail * sizeof(*items));
+    if (items == NULL) {
+      return 1;
+    }
+    vec->items = items;
+  }
+  vec->items[vec->size++] = item;
+  return 0;
+}
+
+typedef struct serializer_s {
+  ptrmap_t node_ids;
+  ptrmap_t token_ids;
+  ptrvec_t nodes;
+  ptrvec_t tokens;
+  ptrvec_t stack;
+  size_t lists;
+  size_t items;
+  size_t strings;
+} serializer_t;
+
+static yrc_str_t* token_str(yrc_token_t* token) {
+  switch (token->type) {
+    case YRC_TOKEN_STRING: return &token->info.as_string.str;
+    case YRC_TOKEN_REGEXP: return &token->info.as_regexp.str;
+    case YRC_TOKEN_IDENT: return &token->info.as_ident.str;
+    case YRC_TOKEN_COMMENT: return &token->info.as_comment.str;
+    default: return NULL;
+  }
+}
+
+static int number_token(serializer_t* ser, yrc_token_t* token) {
+  yrc_str_t* str;
+  uint32_t id;
+  int failed = 0;
+  if (token == NULL || ptrmap_insert(&ser->token_ids, token, &id, &failed)) {
+    return failed;
+  }
+  if (failed || ptrvec_push(&ser->tokens, token)) {
+    return 1;
+  }
+  str = token_str(token);
+  if (str) {
+    ser->strings += ALIGN8(yrc_str_len(str) + 1);
+  }
+  return 0;
+}
+
+/* pass one: number nodes in pre-order and tokens in first-seen order */
+static int number_nodes(serializer_t* ser, yrc_ast_node_t* root) {
+  const slot_t* slots;
+  yrc_ast_node_t* node;
+  yrc_ast_node_t* child;
+  yrc_llist_t* list;
+  yrc_llist_iter_t iterator;
+  size_t base;
+  size_t count;
+  uint32_t id;
+  int failed = 0;
+  int i;
+
+  if (ptrvec_push(&ser->stack, root)) {
+    return 1;
+  }
+  while (ser->stack.size) {
+    node = ser->stack.items[--ser->stack.size];
+    if (ptrmap_insert(&ser->node_ids, node, &id, &failed)) {
+      continue;
+    }
+    if (failed || ptrvec_push(&ser->nodes, node) ||
+        number_token(ser, node->first) || number_token(ser, node->last)) {
+      return 1;
+    }
+    slots = layout(node->kind);
+    base = ser->stack.size;
+    for (i = 0; i < kMaxSlots; ++i) {
+      switch (slots[i].type) {
+        case kSlotNode:
+          if (*SLOT_PTR(node, &slots[i]) &&
+              ptrvec_push(&ser->stack, *SLOT_PTR(node, &slots[i]))) {
+            return 1;
+          }
+        break;
+        case kSlotList:
+          list = *SLOT_PTR(node, &slots[i]);
+          if (list == NULL) {
+            break;
+          }
+          ++ser->lists;
+          count = yrc_llist_len(list);
+          ser->items += count;
+          iterator = yrc_llist_iter_start(list);
+          while (count--) {
+            child = yrc_llist_iter_next(&iterator);
+            if (child && ptrvec_push(&ser->stack, child)) {
+              return 1;
+            }
+          }
+        break;
+        case kSlotToken:
+          if (number_token(ser, *SLOT_PTR(node, &slots[i]))) {
+            return 1;
+          }
+        break;
+        default: break;
+      }
+    }
+    /* children were pushed in source order; flip them so they pop that way */
+    for (count = ser->stack.size; base + 1 < count; ++base, --count) {
+      child = ser->stack.items[base];
+      ser->stack.items[base] = ser->stack.items[count - 1];
+      ser->stack.items[count - 1] = child;
+    }
+  }
+  return ser->nodes.size > UINT32_MAX - 1 || ser->tokens.size > UINT32_MAX - 1;
+}
+
+static int write_token(blob_token_t* out, yrc_token_t* token, char* strings, size_t* strpos) {
+  yrc_str_t* str = token_str(token);
+  size_t len;
+  memset(out, 0, sizeof(*out));
+  out->type = token->type;
+  switch (token->type) {
+    case YRC_TOKEN_STRING:
+      out->sub = token->info.as_string.delim;
+      out->value = token->info.as_string.has_escapes;
+    break;
+    case YRC_TOKEN_COMMENT: out->sub = token->info.as_comment.delim; break;
+    case YRC_TOKEN_NUMBER:
+      out->sub = token->info.as_number.repr;
+      memcpy(&out->number, &token->info.as_number.data, sizeof(out->number));
+    break;
+    case YRC_TOKEN_REGEXP: out->value = token->info.as_regexp.flags; break;
+    case YRC_TOKEN_KEYWORD: out->value = token->info.as_keyword; break;
+    case YRC_TOKEN_OPERATOR: out->value = token->info.as_operator; break;
+    case YRC_TOKEN_WHITESPACE: out->value = token->info.as_whitespace.has_newline; break;
+    default: break;
+  }
+  if (str) {
+    len = yrc_str_len(str);
+    out->str = *strpos;
+    out->str_len = len;
+    memcpy(strings + *strpos, yrc_str_ptr(str), len);
+    memset(strings + *strpos + len, 0, ALIGN8(len + 1) - len);
+    *strpos += ALIGN8(len + 1);
+  }
+  out->start_fpos = token->start.fpos;
+  out->start_line = token->start.line;
+  out->start_col = token->start.col;
+  out->end_fpos = token->end.fpos;
+  out->end_line = token->end.line;
+  out->end_col = token->end.col;
+  return 0;
+}
+
+/* pass two: everything has an index now, so records can be written in order */
+static int write_blob(serializer_t* ser, char* blob, blob_sections_t* offsets) {
+  blob_header_t* header = (blob_header_t*)blob;
+  blob_node_t* nodes = (blob_node_t*)(blob + offsets->nodes);
+  blob_token_t* tokens = (blob_token_t*)(blob + offsets->tokens);
+  blob_list_t* lists = (blob_list_t*)(blob + offsets->lists);
+  uint32_t* items = (uint32_t*)(blob + offsets->items);
+  char* strings = blob + offsets->strings;
+  const slot_t* slots;
+  yrc_ast_node_t* node;
+  yrc_llist_iter_t iterator;
+  yrc_llist_t* list;
+  size_t list_id = 0;
+  size_t item_id = 0;
+  size_t strpos = 0;
+  size_t count;
+  size_t n;
+  int i;
+
+  for (n = 0; n < ser->nodes.size; ++n) {
+    node = ser->nodes.items[n];
+    slots = layout(node->kind);
+    nodes[n].kind = node->kind;
+    nodes[n].has_parens = node->has_parens ? 1 : 0;
+    nodes[n].reserved = 0;
+    nodes[n].first = ptrmap_get(&ser->token_ids, node->first);
+    nodes[n].last = ptrmap_get(&ser->token_ids, node->last);
+    for (i = 0; i < kMaxSlots; ++i) {
+      switch (slots[i].type) {
+        case kSlotNode:
+          nodes[n].slots[i] = ptrmap_get(&ser->node_ids, *SLOT_PTR(node, &slots[i]));
+        break;
+        case kSlotToken:
+          nodes[n].slots[i] = ptrmap_get(&ser->token_ids, *SLOT_PTR(node, &slots[i]));
+        break;
+        case kSlotInt:
+          nodes[n].slots[i] = (uint32_t)*SLOT_INT(node, &slots[i]);
+        break;
+        case kSlotList:
+          list = *SLOT_PTR(node, &slots[i]);
+          if (list == NULL) {
+            nodes[n].slots[i] = 0;
+            break;
+          }
+          count = yrc_llist_len(list);
+          lists[list_id].first = (uint32_t)item_id;
+          lists[list_id].count = (uint32_t)count;
+          iterator = yrc_llist_iter_start(list);
+          while (count--) {
+            items[item_id++] = ptrmap_get(&ser->node_ids, yrc_llist_iter_next(&iterator));
+          }
+          nodes[n].slots[i] = (uint32_t)++list_id;
+        break;
+        default:
+          nodes[n].slots[i] = 0;
+        break;
+      }
+    }
+  }
+
+  for (n = 0; n < ser->tokens.size; ++n) {
+    if (write_token(&tokens[n], ser->tokens.items[n], strings, &strpos)) {
+      return 1;
+    }
+  }
+
+  memcpy(header->magic, "YRCA", 4);
+  header->version = kBlobVersion;
+  header->byte_order = kBlobByteOrder;
+  header->root = 0;
+  header->nodes = (uint32_t)ser->nodes.size;
+  header->tokens = (uint32_t)ser->tokens.size;
+  header->lists = (uint32_t)ser->lists;
+  header->items = (uint32_t)ser->items;
+  header->strings = strpos;
+  header->size = offsets->size;
+  /* padding between sections */
+  memset((char*)(nodes + ser->nodes.size), 0, offsets->tokens - offsets->nodes - ser->nodes.size * sizeof(*nodes));
+  memset((char*)(lists + ser->lists), 0, offsets->items - offsets->lists - ser->lists * sizeof(*lists));
+  memset((char*)(items + ser->items), 0, offsets->strings - offsets->items - ser->items * sizeof(*items));
+  return 0;
+}
+
+YRC_EXTERN int yrc_ast_serialize(yrc_ast_node_t* root, void** out, size_t* outsize) {
+  serializer_t ser;
+  blob_sections_t offsets;
+  char* blob = NULL;
+  int rc = 1;
+
+  memset(&ser, 0, sizeof(ser));
+  if (ptrmap_init(&ser.node_ids, 1024) || ptrmap_init(&ser.token_ids, 1024)) {
+    goto cleanup;
+  }
+  if (number_nodes(&ser, root)) {
+    goto cleanup;
+  }
+  sections(&offsets, ser.nodes.size, ser.tokens.size, ser.lists, ser.items, ser.strings);
+  if (offsets.size > (size_t)-1) {
+    goto cleanup;
+  }
+  blob = malloc((size_t)offsets.size);
+  if (blob == NULL || write_blob(&ser, blob, &offsets)) {
+    free(blob);
+    goto cleanup;
+  }
+  *out = blob;
+  *outsize = (size_t)offsets.size;
+  rc = 0;
+
+cleanup:
+  ptrmap_free(&ser.node_ids);
+  ptrmap_free(&ser.token_ids);
+  free(ser.nodes.items);
+  free(ser.tokens.items);
+  free(ser.stack.items);
+  return rc;
+}
+
+/**
+  everything in the header is checked against the blob's real size before
+  any record is touched, and every index is checked as it's followed, so a
+  truncated or corrupt cache file fails to load instead of crashing.
+**/
+static int check_header(const blob_header_t* header, size_t size, blob_sections_t* offsets) {
+  if (size < sizeof(*header) ||
+      memcmp(header->magic, "YRCA", 4) ||
+      header->version != kBlobVersion ||
+      header->byte_order != kBlobByteOrder ||
+      header->size > size ||
+      header->nodes == 0 ||
+      header->root >= header->nodes) {
+    return 1;
+  }
+  sections(offsets, header->nodes, header->tokens, header->lists, header->items, header->strings);
+  return offsets->size != header->size;
+}
+
+typedef struct reader_s {
+  const blob_header_t* header;
+  const blob_node_t* nodes_in;
+  const blob_token_t* tokens_in;
+  const blob_list_t* lists;
+  const uint32_t* items;
+  const char* strings;
+  yrc_ast_node_t* nodes;
+  yrc_token_t* tokens;
+  uint8_t* claimed;
+} reader_t;
+
+static int read_token(reader_t* reader, size_t n) {
+  const blob_token_t* in = &reader->tokens_in[n];
+  yrc_token_t* token = &reader->tokens[n];
+  uint64_t strsize = reader->header->strings;
+  yrc_str_t* str;
+  if (in->type >= YRC_TOKEN_EOF) {
+    return 1;
+  }
+  token->type = in->type;
+  switch (token->type) {
+    case YRC_TOKEN_STRING:
+      token->info.as_string.delim = in->sub;
+      token->info.as_string.has_escapes = in->value != 0;
+    break;
+    case YRC_TOKEN_COMMENT: token->info.as_comment.delim = in->sub; break;
+    case YRC_TOKEN_NUMBER:
+      token->info.as_number.repr = in->sub;
+      memcpy(&token->info.as_number.data, &in->number, sizeof(in->number));
+    break;
+    case YRC_TOKEN_REGEXP: token->info.as_regexp.flags = in->value; break;
+    case YRC_TOKEN_KEYWORD: token->info.as_keyword = in->value; break;
+    case YRC_TOKEN_OPERATOR: token->info.as_operator = in->value; break;
+    case YRC_TOKEN_WHITESPACE: token->info.as_whitespace.has_newline = in->value; break;
+    default: break;
+  }
+  str = token_str(token);
+  if (str) {
+    /* the writer starts every string on an 8-byte boundary; see yrc_str_wrap */
+    if ((in->str & 7) || in->str > strsize || in->str_len >= strsize - in->str) {
+      return 1;
+    }
+    yrc_str_wrap(str, reader->strings + in->str, (size_t)in->str_len);
+  }
+  token->start.fpos = in->start_fpos;
+  token->start.line = in->start_line;
+  token->start.col = in->start_col;
+  token->end.fpos = in->end_fpos;
+  token->end.line = in->end_line;
+  token->end.col = in->end_col;
+  return 0;
+}
+
+/**
+  resolve a reference from node `owner` to node `id` (index + 1). every
+  node has exactly one parent and sits after it in the blob; the only
+  sharing the parser produces is a shorthand property's key + expression,
+  which `shared` allows. anything else would be freed twice.
+**/
+static int claim(reader_t* reader, size_t owner, uint32_t id, int shared, yrc_ast_node_t** out) {
+  if (id == 0) {
+    *out = NULL;
+    return 0;
+  }
+  if (id - 1 <= owner || id > reader->header->nodes ||
+      (reader->claimed[id - 1] && !shared)) {
+    return 1;
+  }
+  reader->claimed[id - 1] = 1;
+  *out = &reader->nodes[id - 1];
+  return 0;
+}
+
+static int read_list(reader_t* reader, size_t owner, uint32_t id, yrc_llist_t** out) {
+  const blob_list_t* list;
+  yrc_ast_node_t* item;
+  size_t i;
+  *out = NULL;
+  if (id == 0) {
+    return 0;
+  }
+  if (id > reader->header->lists) {
+    return 1;
+  }
+  list = &reader->lists[id - 1];
+  if (list->first > reader->header->items ||
+      list->count > reader->header->items - list->first) {
+    return 1;
+  }
+  if (yrc_llist_init(out)) {
+    return 1;
+  }
+  for (i = 0; i < list->count; ++i) {
+    /* array holes are NULL entries */
+    if (claim(reader, owner, reader->items[list->first + i], 0, &item) ||
+        yrc_llist_push(*out, item)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int read_node(reader_t* reader, size_t n) {
+  const blob_node_t* in = &reader->nodes_in[n];
+  yrc_ast_node_t* node = &reader->nodes[n];
+  const slot_t* slots;
+  uint32_t value;
+  int shared;
+  int i;
+
+  if (in->kind == YRC_AST_NULL || in->kind >= YRC_AST_LAST) {
+    return 1;
+  }
+  if (in->first > reader->header->tokens || in->last > reader->header->tokens) {
+    return 1;
+  }
+  node->kind = in->kind;
+  node->has_parens = in->has_parens;
+  node->first = in->first ? &reader->tokens[in->first - 1] : NULL;
+  node->last = in->last ? &reader->tokens[in->last - 1] : NULL;
+  slots = layout(node->kind);
+  for (i = 0; i < kMaxSlots; ++i) {
+    value = in->slots[i];
+    switch (slots[i].type) {
+      case kSlotNode:
+        shared = node->kind == YRC_AST_EXPR_PROPERTY && i == 1 && value == in->slots[0];
+        if (claim(reader, n, value, shared, (yrc_ast_node_t**)SLOT_PTR(node, &slots[i]))) {
+          return 1;
+        }
+      break;
+      case kSlotToken:
+        if (value > reader->header->tokens) {
+          return 1;
+        }
+        *SLOT_PTR(node, &slots[i]) = value ? &reader->tokens[value - 1] : NULL;
+      break;
+      case kSlotInt:
+        *SLOT_INT(node, &slots[i]) = (int)value;
+      break;
+      case kSlotList:
+        if (read_list(reader, n, value, (yrc_llist_t**)SLOT_PTR(node, &slots[i]))) {
+          return 1;
+        }
+      break;
+      default: break;
+    }
+  }
+  return 0;
+}
+
+/* nodes that were never read are zeroed, so this is safe after a failed load */
+void yrc_ast_free_lists(yrc_ast_node_t* nodes, size_t count) {
+  const slot_t* slots;
+  yrc_llist_t* list;
+  size_t n;
+  int i;
+  for (n = 0; n < count; ++n) {
+    slots = layout(nodes[n].kind);
+    for (i = 0; i < kMaxSlots; ++i) {
+      if (slots[i].type != kSlotList) {
+        continue;
+      }
+      list = *SLOT_PTR(&nodes[n], &slots[i]);
+      if (list) {
+        yrc_llist_free(list);
+      }
+    }
+  }
+}
+
+YRC_EXTERN int yrc_ast_deserialize(const void* blob, size_t size, yrc_parse_response_t** out) {
+  const char* base = blob;
+  yrc_parse_response_priv_t* resp;
+  blob_sections_t offsets;
+  reader_t reader;
+  char* arena;
+  size_t n;
+  int failed = 0;
+
+  reader.header = blob;
+  if (((size_t)blob & 7) || check_header(reader.header, size, &offsets)) {
+    return 1;
+  }
+  reader.nodes_in = (const blob_node_t*)(base + offsets.nodes);
+  reader.tokens_in = (const blob_token_t*)(base + offsets.tokens);
+  reader.lists = (const blob_list_t*)(base + offsets.lists);
+  reader.items = (const uint32_t*)(base + offsets.items);
+  reader.strings = base + offsets.strings;
+
+  resp = malloc(sizeof(*resp));
+  /* zeroed, so a failed load can free lists up to wherever it stopped */
+  arena = calloc(1, reader.header->nodes * sizeof(yrc_ast_node_t) +
+                    reader.header->tokens * sizeof(yrc_token_t));
+  reader.claimed = calloc(reader.header->nodes, 1);
+  if (resp == NULL || arena == NULL || reader.claimed == NULL) {
+    free(resp);
+    free(arena);
+    free(reader.claimed);
+    return 1;
+  }
+  reader.nodes = (yrc_ast_node_t*)arena;
+  reader.tokens = (yrc_token_t*)(reader.nodes + reader.header->nodes);
+
+  for (n = 0; !failed && n < reader.header->tokens; ++n) {
+    failed = read_token(&reader, n);
+  }
+  /* the root is claimed up front so nothing can point back at it */
+  reader.claimed[reader.header->root] = 1;
+  for (n = reader.header->root; !failed && n < reader.header->nodes; ++n) {
+    failed = read_node(&reader, n);
+  }
+  free(reader.claimed);
+  if (failed) {
+    yrc_ast_free_lists(reader.nodes, reader.header->nodes);
+    free(arena);
+    free(resp);
+    return 1;
+  }
+
+  memset(resp, 0, sizeof(*resp));
+  resp->response.root = &reader.nodes[reader.header->root];
+  resp->arena = arena;
+  resp->arena_nodes = reader.header->nodes;
+  *out = (yrc_parse_response_t*)resp;
+  return 0;
+}
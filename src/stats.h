@@ -0,0 +1,44 @@
+#ifndef _YRC_STATS_H
+#define _YRC_STATS_H
+
+/**
+  parse instrumentation. everything here is keyed off YRC_STATS: without
+  it the struct member and every macro expand to nothing, so the counters
+  cost nothing in a normal build. OWNER is anything with a `stats` pointer
+  (the parser state, the tokenizer); a NULL pointer counts nothing.
+  YRC_STATS_MEMBER and YRC_STAT_TIMER take no trailing semicolon, and the
+  timer should be the last declaration in its block.
+**/
+#ifdef YRC_STATS
+#include <time.h>
+
+#define YRC_STATS_MEMBER yrc_parse_stats_t* stats;
+#define YRC_STAT_ADD(OWNER, FIELD, N) \
+  do { if ((OWNER)->stats) { (OWNER)->stats->FIELD += (N); } } while (0)
+#define YRC_STAT_INC(OWNER, FIELD) YRC_STAT_ADD(OWNER, FIELD, 1)
+#define YRC_STAT_SET(OWNER, FIELD, N) \
+  do { if ((OWNER)->stats) { (OWNER)->stats->FIELD = (N); } } while (0)
+#define YRC_STAT_MAX(OWNER, FIELD, N) \
+  do { if ((OWNER)->stats && (OWNER)->stats->FIELD < (N)) { (OWNER)->stats->FIELD = (N); } } while (0)
+#define YRC_STAT_TIMER(NAME) uint64_t NAME;
+#define YRC_STAT_TIMER_START(NAME) NAME = yrc_stats_now()
+#define YRC_STAT_TIMER_STOP(OWNER, FIELD, NAME) \
+  YRC_STAT_ADD(OWNER, FIELD, yrc_stats_now() - NAME)
+
+static inline uint64_t yrc_stats_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#else
+#define YRC_STATS_MEMBER
+#define YRC_STAT_ADD(OWNER, FIELD, N)
+#define YRC_STAT_INC(OWNER, FIELD)
+#define YRC_STAT_SET(OWNER, FIELD, N)
+#define YRC_STAT_MAX(OWNER, FIELD, N)
+#define YRC_STAT_TIMER(NAME)
+#define YRC_STAT_TIMER_START(NAME)
+#define YRC_STAT_TIMER_STOP(OWNER, FIELD, NAME)
+#endif
+
+#endif
@@ -1,6 +1,7 @@
 #include "yrc-common.h"
 #include "str.h"
 #include <string.h>
+#include <assert.h>
 
 enum {
   kInternedSize=sizeof(struct yrc_extern_str) - 1
@@ -70,15 +71,14 @@ static int externalize(yrc_str_t* str, const char* data, size_t cur, size_t sz)
 
 static int do_interned_pushv(yrc_str_t* str, const char* data, size_t sz) {
   size_t current;
-  int i, j;
-  int newsz;
+  size_t newsz;
   current = interned_size(str);
   newsz = current + sz;
   if (newsz >= kInternedSize) {
     return externalize(str, data, current, sz);
   }
   str->interned.flag = 1 | (newsz << 1);
-  memcpy(str->interned.data, data, sz);
+  memcpy(str->interned.data + current, data, sz);
   return 0;
 }
 
@@ -92,11 +92,10 @@ static int do_externed_pushv(struct yrc_extern_str* exstr, const char* data, siz
     return 0;
   }
   newsz = npot(newsz);
-  ptr = malloc(newsz);
+  ptr = realloc(exstr->data, newsz);
   if (ptr == NULL) {
     return 1;
   }
-  memcpy(ptr, exstr->data, exstr->size);
   memcpy(ptr + exstr->size, data, sz);
   exstr->avail = newsz;
   exstr->data = ptr;
@@ -132,6 +131,56 @@ int yrc_str_free(yrc_str_t* str) {
   return 0;
 }
 
+/* empty the string but hold on to any external buffer so it can be reused */
+void yrc_str_clear(yrc_str_t* str) {
+  if (is_interned(str)) {
+    str->interned.flag = 1;
+    return;
+  }
+  str->externed.size = 0;
+}
+
+/* copy src into dst, interning if it fits, otherwise into an exact-fit buffer */
+int yrc_str_copy(yrc_str_t* src, yrc_str_t* dst) {
+  size_t size;
+  char* ptr;
+  size = yrc_str_len(src);
+  yrc_str_init(dst);
+  if (size < kInternedSize) {
+    memcpy(dst->interned.data, yrc_str_ptr(src), size);
+    dst->interned.flag = 1 | (size << 1);
+    return 0;
+  }
+  ptr = malloc(size);
+  if (ptr == NULL) {
+    return 1;
+  }
+  memcpy(ptr, yrc_str_ptr(src), size);
+  dst->externed.data = ptr;
+  dst->externed.size = size;
+  dst->externed.avail = size;
+  return 0;
+}
+
+/**
+  make dst refer to `size` bytes at `data`, interning them if they fit.
+  otherwise dst points at `data` itself: it must outlive dst, and dst must
+  never be pushed to or freed. `data` must then be 8-byte aligned, since
+  the low bit of the pointer is what marks a string as interned.
+**/
+void yrc_str_wrap(yrc_str_t* dst, const char* data, size_t size) {
+  yrc_str_init(dst);
+  if (size < kInternedSize) {
+    memcpy(dst->interned.data, data, size);
+    dst->interned.flag = 1 | (size << 1);
+    return;
+  }
+  assert(((uintptr_t)data & 7) == 0);
+  dst->externed.data = (char*)data;
+  dst->externed.size = size;
+  dst->externed.avail = size;
+}
+
 int yrc_str_xfer(yrc_str_t* src, yrc_str_t* dst) {
   if (dst) {
     dst->externed.avail = src->externed.avail;
@@ -7,5 +7,8 @@ int yrc_str_push(yrc_str_t*, char);
 void yrc_str_init(yrc_str_t*);
 int yrc_str_free(yrc_str_t*);
 int yrc_str_xfer(yrc_str_t*, yrc_str_t*);
+int yrc_str_copy(yrc_str_t*, yrc_str_t*);
+void yrc_str_clear(yrc_str_t*);
+void yrc_str_wrap(yrc_str_t*, const char*, size_t);
 
 #endif
@@ -0,0 +1,464 @@
+#include "yrc-common.h"
+#include "tokenizer.h"
+#include <string.h> /* memchr, memcpy, memset */
+
+#ifdef _WIN32
+/* no threads on windows yet: the chunks are scanned one after another */
+# define YRC_NO_THREADS 1
+#else
+# include <pthread.h>
+# include <unistd.h> /* sysconf */
+#endif
+
+/**
+  tokenizing one large buffer on several cores. the buffer is cut into
+  chunks at line starts and each chunk is tokenized on its own, as though
+  it began a file. that's a guess at where a sequential scan would be,
+  and at a line start it's nearly always right: strings and regexps end
+  with their line, so only a block comment carries over one, and only a
+  `/` opening a chunk needs the token before it to be read.
+
+  the calling thread stitches the chunks together in order, checking each
+  guess as it goes. a chunk that failed or read its first `/` the wrong
+  way is scanned again from its start, knowing the previous token; if
+  that runs off the end inside a comment, the next chunk is taken in
+  too, and so on. every other chunk is kept as it is, its lines moved
+  down, and whitespace running across a cut is handed over as the one
+  token a sequential scan would have made of it.
+**/
+
+enum {
+  kChunkMin=16 << 10,     /* smaller than this isn't worth a thread */
+  kChunksPerThread=4,     /* so one slow chunk doesn't hold up the rest */
+  kChunkRead=64 << 10
+};
+
+typedef enum {
+  CHUNK_OK,
+  CHUNK_FAILED,
+  CHUNK_RAN_OFF           /* hit the end mid-token: a comment goes on */
+} chunk_status;
+
+typedef struct chunk_s {
+  size_t            start;
+  size_t            end;
+  size_t            lines;      /* newlines in [start, end) */
+  yrc_position_t    from;       /* where scanning starts */
+  yrc_tokenizer_t*  tokenizer;
+  yrc_token_t**     tokens;     /* in source order */
+  size_t            ntokens;
+  size_t            avail;
+  yrc_token_t*      first;      /* first significant, before any regexp rescan */
+  yrc_token_t*      last;       /* last significant */
+  chunk_status      status;
+  int               done;
+} chunk_t;
+
+typedef struct reader_s {
+  const char* data;
+  size_t      offset;
+  size_t      end;
+} reader_t;
+
+typedef struct tokenize_state_s {
+  const char* data;
+  chunk_t*    chunks;
+  size_t      nchunks;
+  size_t      next;       /* next chunk to hand a worker */
+  volatile int stopped;
+#ifndef YRC_NO_THREADS
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+#endif
+} tokenize_state_t;
+
+/* what's been handed over so far */
+typedef struct stitch_s {
+  const char*   data;
+  yrc_tokencb   cb;
+  void*         ctx;
+  size_t        line;         /* of the next range's first line */
+  yrc_token_t   gap;          /* whitespace the last range ended on */
+  int           has_gap;
+  yrc_token_t   prev;         /* a copy of the last significant token */
+  int           has_prev;
+} stitch_t;
+
+#ifdef YRC_NO_THREADS
+# define LOCK(state)
+# define UNLOCK(state)
+# define WAIT(state)
+# define BROADCAST(state)
+#else
+# define LOCK(state) pthread_mutex_lock(&(state)->lock)
+# define UNLOCK(state) pthread_mutex_unlock(&(state)->lock)
+# define WAIT(state) pthread_cond_wait(&(state)->cond, &(state)->lock)
+# define BROADCAST(state) pthread_cond_broadcast(&(state)->cond)
+#endif
+
+#define TO_CASE(a) case a:
+static inline int is_ws(char ch) {
+  switch(ch) {
+    WHITESPACE_MAP(TO_CASE)
+      return 1;
+  }
+  return 0;
+}
+#undef TO_CASE
+
+static size_t read_chunk(char* data, size_t desired, void* ctx) {
+  reader_t* reader = ctx;
+  size_t toread = reader->end - reader->offset;
+  if (toread > desired) {
+    toread = desired;
+  }
+  memcpy(data, reader->data + reader->offset, toread);
+  reader->offset += toread;
+  return toread;
+}
+
+static int push(chunk_t* chunk, yrc_token_t* token) {
+  yrc_token_t** grown;
+  if (chunk->ntokens == chunk->avail) {
+    chunk->avail = chunk->avail ? chunk->avail * 2 : 256;
+    grown = realloc(chunk->tokens, chunk->avail * sizeof(*grown));
+    if (grown == NULL) {
+      return 1;
+    }
+    chunk->tokens = grown;
+  }
+  chunk->tokens[chunk->ntokens++] = token;
+  return 0;
+}
+
+static void release(chunk_t* chunk) {
+  if (chunk->tokenizer) {
+    yrc_tokenizer_free(chunk->tokenizer);
+  }
+  chunk->tokenizer = NULL;
+  chunk->ntokens = 0;
+  chunk->first = NULL;
+  chunk->last = NULL;
+}
+
+/* tokenize from chunk->from up to `end`, with `prev` the token before */
+static void scan(chunk_t* chunk, const char* data, size_t end, yrc_token_t* prev) {
+  yrc_scan_allow_regexp mode;
+  yrc_token_t* token;
+  reader_t reader;
+
+  release(chunk);
+  chunk->status = CHUNK_FAILED;
+  reader.data = data;
+  reader.offset = chunk->from.fpos;
+  reader.end = end;
+  if (yrc_tokenizer_init(&chunk->tokenizer, kChunkRead, &reader)) {
+    chunk->tokenizer = NULL;
+    return;
+  }
+  yrc_tokenizer_set_position(chunk->tokenizer, &chunk->from);
+  for (;;) {
+    if (yrc_tokenizer_scan(chunk->tokenizer, read_chunk, &token, YRC_ISNT_REGEXP)) {
+      if (yrc_tokenizer_eof(chunk->tokenizer)) {
+        chunk->status = CHUNK_RAN_OFF;
+      }
+      return;
+    }
+    if (token == NULL) {
+      break;
+    }
+    if (push(chunk, token)) {
+      return;
+    }
+    if (token->type == YRC_TOKEN_WHITESPACE || token->type == YRC_TOKEN_COMMENT) {
+      continue;
+    }
+    if (chunk->first == NULL) {
+      chunk->first = token;
+    }
+    mode = yrc_tokenizer_regexp_mode(prev, token);
+    if (mode != YRC_ISNT_REGEXP) {
+      if (yrc_tokenizer_scan(chunk->tokenizer, read_chunk, &token, mode)) {
+        if (yrc_tokenizer_eof(chunk->tokenizer)) {
+          chunk->status = CHUNK_RAN_OFF;
+        }
+        return;
+      }
+      if (push(chunk, token)) {
+        return;
+      }
+    }
+    prev = chunk->last = token;
+  }
+  chunk->status = CHUNK_OK;
+}
+
+static void* work(void* arg) {
+  tokenize_state_t* state = arg;
+  chunk_t* chunk;
+  size_t last;
+
+  LOCK(state);
+  while (!state->stopped && state->next < state->nchunks) {
+    chunk = &state->chunks[state->next++];
+    UNLOCK(state);
+    chunk->lines = yrc_count_newlines(state->data + chunk->start,
+                                      chunk->end - chunk->start, &last);
+    /**
+      a guess: that the chunk starts a file, but for its offset and the
+      columns on its first line. lines are counted from 1 until it's
+      known how many came before.
+    **/
+    chunk->from.fpos = chunk->start;
+    chunk->from.line = 1;
+    chunk->from.col = chunk->start ? 1 : 0;
+    scan(chunk, state->data, chunk->end, NULL);
+    LOCK(state);
+    chunk->done = 1;
+    BROADCAST(state);
+  }
+  UNLOCK(state);
+  return NULL;
+}
+
+static size_t online_cpus(void) {
+#ifdef YRC_NO_THREADS
+  return 1;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (size_t)n : 1;
+#endif
+}
+
+/* cut at the first line start past each even share */
+static size_t split(tokenize_state_t* state, size_t size, size_t nchunks) {
+  const char* nl;
+  size_t start = 0;
+  size_t target;
+  size_t n = 0;
+  size_t i;
+
+  for (i = 1; i <= nchunks && start < size; ++i) {
+    target = i == nchunks ? size : size / nchunks * i;
+    if (target < start) {
+      target = start;
+    }
+    nl = target < size ? memchr(state->data + target, '\n', size - target) : NULL;
+    state->chunks[n].start = start;
+    state->chunks[n].end = nl ? (size_t)(nl - state->data) + 1 : size;
+    start = state->chunks[n++].end;
+  }
+  return n;
+}
+
+/**
+  hand a scanned range's tokens over, their lines moved down by `shift`.
+  with `keep_gap`, pick up the whitespace it ends on, to go with the next.
+**/
+static int deliver(stitch_t* stitch, chunk_t* range, size_t shift, int keep_gap) {
+  yrc_token_t merged;
+  size_t i;
+
+  for (i = 0; i < range->ntokens; ++i) {
+    range->tokens[i]->start.line += shift;
+    range->tokens[i]->end.line += shift;
+  }
+  i = 0;
+
+  /**
+    whitespace running over the cut is one token. anything else ends it:
+    a character the tokenizer skips joins the token after, as usual.
+  **/
+  if (stitch->has_gap) {
+    merged = stitch->gap;
+    if (!is_ws(stitch->data[range->from.fpos])) {
+      merged.end = range->from;
+      merged.end.line += shift;
+    } else if (range->ntokens) {
+      merged.end = range->tokens[i++]->end;
+    } else if (keep_gap) {
+      return 0;   /* nothing but whitespace: it runs on into the next */
+    } else {
+      stitch->has_gap = 0;
+      return 0;   /* and at the end of the input, isn't a token at all */
+    }
+    stitch->has_gap = 0;
+    if (stitch->cb(&merged, stitch->ctx)) {
+      return 1;
+    }
+  }
+  for (; i < range->ntokens; ++i) {
+    if (stitch->cb(range->tokens[i], stitch->ctx)) {
+      return 1;
+    }
+  }
+  if (range->last) {
+    stitch->prev = *range->last;
+    stitch->has_prev = 1;
+  }
+
+  /**
+    a tokenizer drops the whitespace it ends its input on, with anything
+    skipped before it, so the next token would have started right after
+    the last one.
+  **/
+  if (keep_gap) {
+    memset(&stitch->gap, 0, sizeof(stitch->gap));
+    stitch->gap.type = YRC_TOKEN_WHITESPACE;
+    stitch->gap.info.as_whitespace.has_newline = 1;
+    if (range->ntokens) {
+      stitch->gap.start = range->tokens[range->ntokens - 1]->end;
+    } else {
+      stitch->gap.start = range->from;
+      stitch->gap.start.line += shift;
+    }
+    stitch->has_gap = stitch->gap.start.fpos < range->end;
+  }
+  return 0;
+}
+
+static void wait_for(tokenize_state_t* state, chunk_t* chunk) {
+  LOCK(state);
+  while (!chunk->done) {
+    WAIT(state);
+  }
+  UNLOCK(state);
+}
+
+/* check each chunk's guess in order, scanning again where it was wrong */
+static int stitch_chunks(tokenize_state_t* state, stitch_t* stitch) {
+  chunk_t* chunk;
+  chunk_t range;
+  size_t lines;
+  size_t i = 0;
+  size_t j;
+  int rc = 0;
+
+  memset(&range, 0, sizeof(range));
+  while (i < state->nchunks) {
+    chunk = &state->chunks[i];
+    wait_for(state, chunk);
+    if (chunk->status == CHUNK_OK &&
+        (chunk->first == NULL ||
+         yrc_tokenizer_regexp_mode(stitch->has_prev ? &stitch->prev : NULL, chunk->first) ==
+         yrc_tokenizer_regexp_mode(NULL, chunk->first))) {
+      rc = deliver(stitch, chunk, stitch->line - 1, i + 1 < state->nchunks);
+      stitch->line += chunk->lines;
+      release(chunk);
+      ++i;
+      if (rc) {
+        break;
+      }
+      continue;
+    }
+
+    range.from.fpos = chunk->start;
+    range.from.line = stitch->line;
+    range.from.col = chunk->start ? 1 : 0;
+    lines = 0;
+    for (j = i; ; ++j) {
+      wait_for(state, &state->chunks[j]);
+      release(&state->chunks[j]);
+      lines += state->chunks[j].lines;
+      range.end = state->chunks[j].end;
+      scan(&range, state->data, range.end, stitch->has_prev ? &stitch->prev : NULL);
+      if (range.status != CHUNK_RAN_OFF || j + 1 == state->nchunks) {
+        break;
+      }
+      /**
+        a comment runs on into the next chunk. what came before it is
+        settled, so carry on from its start rather than from the top.
+      **/
+      rc = deliver(stitch, &range, 0, 0);
+      yrc_tokenizer_position(range.tokenizer, &range.from);
+      if (rc) {
+        break;
+      }
+    }
+    if (rc == 0 && range.status == CHUNK_OK) {
+      rc = deliver(stitch, &range, 0, j + 1 < state->nchunks);
+    } else {
+      rc = 1;
+    }
+    stitch->line += lines;
+    release(&range);
+    i = j + 1;
+    if (rc) {
+      break;
+    }
+  }
+  free(range.tokens);
+  return rc;
+}
+
+YRC_EXTERN int yrc_tokenize_parallel(const char* data, size_t size, size_t nthreads, yrc_tokencb cb, void* ctx) {
+  tokenize_state_t state;
+  stitch_t stitch;
+#ifndef YRC_NO_THREADS
+  pthread_t* threads = NULL;
+#endif
+  size_t spawned = 0;
+  size_t nchunks;
+  size_t i;
+  int rc;
+
+  nthreads = nthreads ? nthreads : online_cpus();
+#ifdef YRC_NO_THREADS
+  nthreads = 1;
+#endif
+  nchunks = nthreads > 1 ? nthreads * kChunksPerThread : 1;
+  if (nchunks > size / kChunkMin) {
+    nchunks = size / kChunkMin ? size / kChunkMin : 1;
+  }
+  memset(&state, 0, sizeof(state));
+  memset(&stitch, 0, sizeof(stitch));
+  state.data = data;
+  state.chunks = calloc(nchunks, sizeof(*state.chunks));
+  if (state.chunks == NULL) {
+    return 1;
+  }
+  state.nchunks = split(&state, size, nchunks);
+  stitch.data = data;
+  stitch.cb = cb;
+  stitch.ctx = ctx;
+  stitch.line = 1;
+  if (nthreads > state.nchunks) {
+    nthreads = state.nchunks;
+  }
+
+#ifndef YRC_NO_THREADS
+  pthread_mutex_init(&state.lock, NULL);
+  pthread_cond_init(&state.cond, NULL);
+  if (nthreads > 1) {
+    threads = calloc(nthreads, sizeof(*threads));
+  }
+  for (; threads && spawned < nthreads; ++spawned) {
+    if (pthread_create(&threads[spawned], NULL, work, &state)) {
+      break;
+    }
+  }
+#endif
+  if (spawned == 0) {
+    work(&state);
+  }
+
+  rc = stitch_chunks(&state, &stitch);
+
+  LOCK(&state);
+  state.stopped = 1;
+  UNLOCK(&state);
+#ifndef YRC_NO_THREADS
+  for (i = 0; i < spawned; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+  pthread_mutex_destroy(&state.lock);
+  pthread_cond_destroy(&state.cond);
+#endif
+  for (i = 0; i < state.nchunks; ++i) {
+    release(&state.chunks[i]);
+    free(state.chunks[i].tokens);
+  }
+  free(state.chunks);
+  return rc;
+}
@@ -1,12 +1,21 @@
 #include "yrc-common.h"
 #include "tokenizer.h"
 #include "pool.h"
+#include "stats.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
-#include <ctype.h>
 #include "str.h"
+#include "utf8.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define YRC_TOKENIZER_SSE2 1
+# include <emmintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+# endif
+#endif
 
 /* extends yrc_error_t */
 typedef struct yrc_tokenizer_error_s {
@@ -25,8 +34,6 @@ typedef enum {
   YRC_TKS_WHITESPACE,
   YRC_TKS_STRING,
   YRC_TKS_STRING_ESCAPE,
-  YRC_TKS_STRING_UNICODE,
-  YRC_TKS_STRING_HEX,
   YRC_TKS_NUMBER,
   YRC_TKS_IDENTIFIER,
   YRC_TKS_OPERATOR,
@@ -38,6 +45,10 @@ typedef enum {
   YRC_TKS_DONE
 } yrc_tokenizer_state;
 
+enum {
+  kHeldMax=3    /* the most of a code point that a read can leave over */
+};
+
 struct yrc_tokenizer_s {
   yrc_pool_t* token_pool;
   yrc_llist_t* tokens;
@@ -47,6 +58,8 @@ struct yrc_tokenizer_s {
   size_t offset;
   size_t start;
   size_t size;
+  size_t held;      /* bytes past `size`: a code point the last read cut */
+  uint_fast8_t invalid;   /* the input is bad UTF-8 just past `size` */
   size_t last_nl;
 
   uint_fast8_t eof;
@@ -55,6 +68,7 @@ struct yrc_tokenizer_s {
   size_t chunksz;
   void* readctx;
   yrc_str_t current;
+  YRC_STATS_MEMBER
 };
 
 const char* TOKEN_TYPES_MAP[] = {
@@ -208,9 +222,13 @@ int yrc_tokenizer_init(yrc_tokenizer_t** state, size_t chunksz, void* ctx) {
 
   obj->last_nl = 0;
   obj->eof = 0;
+  obj->invalid = 0;
   obj->chunksz = chunksz;
-  obj->data = malloc(chunksz);
+  obj->data = malloc(chunksz + kHeldMax);
   obj->readctx = ctx;
+#ifdef YRC_STATS
+  obj->stats = NULL;
+#endif
   if (obj->data == NULL) {
     free(obj);
     return 1;
@@ -223,7 +241,8 @@ int yrc_tokenizer_init(yrc_tokenizer_t** state, size_t chunksz, void* ctx) {
     return 1;
   }
 
-  if (yrc_llist_init(&obj->tokens)) {
+  /* a list of its own, since a tokenizer may run on any thread */
+  if (yrc_llist_init_local(&obj->tokens)) {
     yrc_pool_free(obj->token_pool);
     free(obj->data);
     free(obj);
@@ -236,7 +255,8 @@ int yrc_tokenizer_init(yrc_tokenizer_t** state, size_t chunksz, void* ctx) {
 
   obj->offset =
   obj->start =
-  obj->size = 0;
+  obj->size =
+  obj->held = 0;
   *state = obj;
   return 0;
 }
@@ -257,6 +277,10 @@ int _free_tokens(void* raw, size_t idx, void* ctx, int* stop) {
       yrc_str_free(&token->info.as_comment.str);
       break;
 
+    case YRC_TOKEN_REGEXP:
+      yrc_str_free(&token->info.as_regexp.str);
+      break;
+
     case YRC_TOKEN_WHITESPACE:
       break;
 
@@ -270,6 +294,7 @@ int _free_tokens(void* raw, size_t idx, void* ctx, int* stop) {
 
 int yrc_tokenizer_free(yrc_tokenizer_t* state) {
   free(state->data);
+  yrc_str_free(&state->current);
   yrc_llist_foreach(state->tokens, _free_tokens, NULL);
   yrc_llist_free(state->tokens);
   yrc_pool_free(state->token_pool);
@@ -329,28 +354,233 @@ void _advance_op(yrc_op_t** op_current, yrc_op_t** op_last, char ch) {
 }
 
 
-#define TO_CASE(a) case a:
-
-static inline int is_ws(char ch) {
-  switch(ch) {
-    WHITESPACE_MAP(TO_CASE)
-      return 1;
+/* hand the scratch contents to a token, keeping the scratch buffer for reuse */
+static inline int _take_current(yrc_tokenizer_t* tokenizer, yrc_str_t* dst) {
+  if (yrc_str_copy(&tokenizer->current, dst)) {
+    return 1;
   }
+  YRC_STAT_ADD(tokenizer, externalized, !(dst->interned.flag & 0x1));
+  yrc_str_clear(&tokenizer->current);
   return 0;
 }
 
-static inline int is_op(char ch) {
-  switch(ch) {
-    OPERATOR_MAP(TO_CASE)
-      return 1;
+
+#ifdef YRC_TOKENIZER_SSE2
+static inline size_t popcount16(unsigned int mask) {
+# ifdef _MSC_VER
+  size_t count = 0;
+  for (; mask; mask &= mask - 1) {
+    ++count;
   }
-  return 0;
+  return count;
+# else
+  return __builtin_popcount(mask);
+# endif
+}
+
+static inline size_t lowest_bit(unsigned int mask) {
+# ifdef _MSC_VER
+  unsigned long bit;
+  _BitScanForward(&bit, mask);
+  return bit;
+# else
+  return __builtin_ctz(mask);
+# endif
+}
+
+static inline size_t highest_bit(unsigned int mask) {
+# ifdef _MSC_VER
+  unsigned long bit;
+  _BitScanReverse(&bit, mask);
+  return bit;
+# else
+  return 31 - __builtin_clz(mask);
+# endif
+}
+#endif
+
+/**
+  count the newlines in a span the scan has consumed, setting `last` to
+  the offset of the final one if there are any. sixteen bytes at a time
+  where SSE2 is around: compare, movemask, popcount.
+**/
+static inline size_t count_newlines(const char* data, size_t size, size_t* last) {
+  const unsigned char* str = (const unsigned char*)data;
+  size_t count = 0;
+  size_t i = 0;
+#ifdef YRC_TOKENIZER_SSE2
+  const __m128i newline = _mm_set1_epi8('\n');
+  unsigned int mask;
+
+  for (; i + 16 <= size; i += 16) {
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128((const __m128i*)(str + i)), newline));
+    if (mask) {
+      count += popcount16(mask);
+      *last = i + highest_bit(mask);
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (str[i] == '\n') {
+      ++count;
+      *last = i;
+    }
+  }
+  return count;
+}
+
+size_t yrc_count_newlines(const char* data, size_t size, size_t* last) {
+  return count_newlines(data, size, last);
+}
+
+/**
+  what each byte can start or continue, so that the default state makes
+  one indexed load and one jump per token instead of a compare chain, and
+  the inner loops test membership the same way. it follows the maps in
+  yrc-common.h. bytes past 0x7f are CC_OTHER: the default state decodes
+  them, taking ID_Start characters for identifiers and skipping the rest
+  like any other stray byte. keep CC_DIGIT and CC_ALPHA last: is_alnum
+  leans on that.
+**/
+typedef enum {
+  CC_OTHER,
+  CC_SPACE,
+  CC_QUOTE,
+  CC_FASTOP,    /* always a token of its own */
+  CC_OP,        /* may run on into a longer operator or a comment */
+  CC_DIGIT,
+  CC_ALPHA
+} yrc_charclass;
+
+#define OT CC_OTHER
+#define SP CC_SPACE
+#define QU CC_QUOTE
+#define FO CC_FASTOP
+#define OP CC_OP
+#define DI CC_DIGIT
+#define AL CC_ALPHA
+static const uint8_t charclass[256] = {
+  /* 00 */ OT, OT, OT, OT, OT, OT, OT, OT, OT, SP, SP, SP, SP, SP, OT, OT,
+  /* 10 */ OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,
+  /* 20 */ SP, OP, QU, OT, AL, OP, OP, QU, FO, FO, OP, OP, FO, OP, FO, OP,
+  /* 30 */ DI, DI, DI, DI, DI, DI, DI, DI, DI, DI, FO, FO, OP, OP, OP, FO,
+  /* 40 */ OT, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,
+  /* 50 */ AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, FO, OT, FO, OP, AL,
+  /* 60 */ OT, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL,
+  /* 70 */ AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, FO, OP, FO, FO, OT,
+};
+#undef OT
+#undef SP
+#undef QU
+#undef FO
+#undef OP
+#undef DI
+#undef AL
+
+#define CHARCLASS(ch) charclass[(uint8_t)(ch)]
+
+static inline int is_ws(char ch) {
+  return CHARCLASS(ch) == CC_SPACE;
+}
+
+static inline int is_op(char ch) {
+  return CHARCLASS(ch) == CC_OP;
 }
 
 static inline int is_alnum(char ch) {
-  return isalnum((int)ch) || ch == '$' || ch == '_';
+  return CHARCLASS(ch) >= CC_DIGIT;
+}
+
+/**
+  where a string's text stops being plain: the next quote of its kind,
+  backslash or newline at or after `offset`, or `size`. sixteen bytes at
+  a time with SSE2.
+**/
+static inline size_t string_run(const char* data, size_t offset, size_t size, char delim) {
+#ifdef YRC_TOKENIZER_SSE2
+  const __m128i quote = _mm_set1_epi8(delim);
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i newline = _mm_set1_epi8('\n');
+  __m128i chunk;
+  unsigned int mask;
+
+  for (; offset + 16 <= size; offset += 16) {
+    chunk = _mm_loadu_si128((const __m128i*)(data + offset));
+    mask = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmpeq_epi8(chunk, quote),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, backslash), _mm_cmpeq_epi8(chunk, newline))));
+    if (mask) {
+      return offset + lowest_bit(mask);
+    }
+  }
+#endif
+  for (; offset < size; ++offset) {
+    if (data[offset] == delim || data[offset] == '\\' || data[offset] == '\n') {
+      break;
+    }
+  }
+  return offset;
 }
 
+/* the bytes in a sequence, given its (valid) lead byte */
+static inline size_t utf8_length(char lead) {
+  uint8_t ch = (uint8_t)lead;
+  return ch < 0xe0 ? 2 : ch < 0xf0 ? 3 : 4;
+}
+
+/**
+  read the next chunk, checking that it's UTF-8. a code point the read
+  cut short is held back until the rest of it arrives, so that the scan
+  only ever sees whole ones. bad input ends the chunk early, and the
+  refill after fails, so the error lands on the token that reached it.
+**/
+static int refill(yrc_tokenizer_t* tokenizer, yrc_readcb read) {
+  char* data = tokenizer->data;
+  size_t have = tokenizer->held;
+  size_t got;
+  if (tokenizer->invalid) {
+    return 1;
+  }
+  memmove(data, data + tokenizer->size, have);
+  do {
+    got = read(data + have, tokenizer->chunksz, tokenizer->readctx);
+    YRC_STAT_INC(tokenizer, read_calls);
+    YRC_STAT_ADD(tokenizer, read_bytes, got);
+    if (got == 0) {
+      /* the input ended partway through a code point */
+      tokenizer->size = tokenizer->held = 0;
+      return have != 0;
+    }
+    have += got;
+    if (yrc_utf8_check(data, have, &tokenizer->size)) {
+      tokenizer->invalid = 1;
+      return tokenizer->size == 0;
+    }
+  } while (tokenizer->size == 0);
+  tokenizer->held = have - tokenizer->size;
+  return 0;
+}
+
+/**
+  the scan's states are threaded: a state that hands over to another
+  without wanting more input jumps straight to that state's code through
+  a table of label addresses, rather than going back round the switch,
+  so each hand-over is a branch of its own for the predictor to learn.
+  label addresses are a gcc extension (clang has them too); elsewhere,
+  or with YRC_NO_COMPUTED_GOTO defined, DISPATCH takes the switch.
+**/
+#if defined(__GNUC__) && !defined(YRC_NO_COMPUTED_GOTO)
+# define YRC_COMPUTED_GOTO
+/* `&&label` and `goto *` are what -pedantic would have us avoid */
+# pragma GCC diagnostic ignored "-Wpedantic"
+# define STATE(s) case s: state_##s
+# define DISPATCH() do { start = offset; goto *states[state]; } while (0)
+#else
+# define STATE(s) case s
+# define DISPATCH() goto restart
+#endif
+
 int yrc_tokenizer_scan(
     yrc_tokenizer_t* tokenizer, 
     yrc_readcb read, 
@@ -358,7 +588,7 @@ int yrc_tokenizer_scan(
     yrc_scan_allow_regexp regexp_mode) {
   size_t last_fpos, last_line, last_col, fpos, line;
   yrc_tokenizer_state state = YRC_TKS_DEFAULT;
-  size_t offset, start, diff;
+  size_t offset, start, diff, lines, nl = 0;
   yrc_op_t *op_current, *op_last;
   char last = '\0';
   char* data;
@@ -366,7 +596,27 @@ int yrc_tokenizer_scan(
   char should_break = 0;
   yrc_token_t* tk;
   char delim;
+  int escapes = 0;
+  size_t continued = (size_t)-1;  /* where an escaped CR's LF would be */
   int pending_read = 0;
+#ifdef YRC_COMPUTED_GOTO
+  /* in yrc_tokenizer_state order */
+  static const void* const states[] = {
+    &&state_YRC_TKS_DEFAULT,
+    &&state_YRC_TKS_WHITESPACE,
+    &&state_YRC_TKS_STRING,
+    &&state_YRC_TKS_STRING_ESCAPE,
+    &&state_YRC_TKS_NUMBER,
+    &&state_YRC_TKS_IDENTIFIER,
+    &&state_YRC_TKS_OPERATOR,
+    &&state_YRC_TKS_COMMENT_LINE,
+    &&state_YRC_TKS_COMMENT_BLOCK,
+    &&state_YRC_TKS_REGEXP_HEAD,
+    &&state_YRC_TKS_REGEXP_TAIL,
+    &&state_YRC_TKS_ERROR,
+    &&state_YRC_TKS_DONE
+  };
+#endif
 
   start = tokenizer->start;
   data = tokenizer->data;
@@ -389,7 +639,9 @@ int yrc_tokenizer_scan(
   }
   while (!tokenizer->eof) {
     if (offset == tokenizer->size) {
-      tokenizer->size = read(tokenizer->data, tokenizer->chunksz, tokenizer->readctx);
+      if (refill(tokenizer, read)) {
+        return 1;
+      }
       offset = 0;
     }
 
@@ -397,32 +649,29 @@ int yrc_tokenizer_scan(
       tokenizer->eof = 1;
     }
 
+#ifndef YRC_COMPUTED_GOTO
 restart:
+#endif
     do {
       start = offset;
       switch (state) {
-        case YRC_TKS_DEFAULT: {
+        STATE(YRC_TKS_DEFAULT): {
             if (tokenizer->eof) {
               state = YRC_TKS_DONE;
               break;
             }
-            switch (data[offset]) {
-              case '"':
+            switch (CHARCLASS(data[offset])) {
+              case CC_QUOTE:
                 state = YRC_TKS_STRING;
-                delim = '"';
+                delim = data[offset];
+                escapes = 0;
                 ++offset;
                 ++fpos;
-                goto restart;
-              case '\'':
-                state = YRC_TKS_STRING;
-                delim = '\'';
-                ++offset;
-                ++fpos;
-                goto restart;
-              WHITESPACE_MAP(TO_CASE)
+                DISPATCH();
+              case CC_SPACE:
                 state = YRC_TKS_WHITESPACE;
-                goto restart;
-              FASTOP_MAP(TO_CASE)
+                DISPATCH();
+              case CC_FASTOP:
                 tk = yrc_pool_attain(tokenizer->token_pool);
                 if (tk == NULL) {
                   return 1;
@@ -437,44 +686,52 @@ restart:
                 ++offset;
                 ++fpos;
                 goto export;
-              NUMERIC_MAP(TO_CASE)
+              case CC_DIGIT:
                 last = 0;
                 tokenizer->flags = 0;
                 state = YRC_TKS_NUMBER;
-                break;
+                DISPATCH();
 
-              OPERATOR_MAP(TO_CASE)
+              case CC_OP:
                 op_last = op_current = &OP_ROOT;
                 state = YRC_TKS_OPERATOR;
-                break;
+                DISPATCH();
 
-              ALPHA_MAP(TO_CASE)
+              case CC_ALPHA:
                 state = YRC_TKS_IDENTIFIER;
-                break;
+                DISPATCH();
 
               default:
-                ++offset;
-                ++fpos;
+                diff = 1;
+                if ((uint8_t)data[offset] >= 0x80) {
+                  if (yrc_utf8_id_char(data + offset, 1)) {
+                    state = YRC_TKS_IDENTIFIER;
+                    DISPATCH();
+                  }
+                  diff = utf8_length(data[offset]);
+                }
+                offset += diff;
+                fpos += diff;
                 break;
             }
           };
           break;
 
-        case YRC_TKS_WHITESPACE: {
+        STATE(YRC_TKS_WHITESPACE): {
             while(offset < tokenizer->size) {
               if (tokenizer->eof || !is_ws(data[offset])) {
                 state = YRC_TKS_DEFAULT;
                 break;
 
               }
-              if (data[offset] == '\n') {
-                ++line;
-                tokenizer->last_nl = offset;
-              }
               last = data[offset];
               ++offset;
             }
             diff = offset - start;
+            if ((lines = count_newlines(data + start, diff, &nl)) != 0) {
+              line += lines;
+              tokenizer->last_nl = fpos + nl;
+            }
             fpos += diff;
             start = offset;
             if (offset == tokenizer->size) {
@@ -491,32 +748,49 @@ restart:
           };
           break;
 
-        case YRC_TKS_STRING: {
+        STATE(YRC_TKS_STRING): {
             while(1) {
               if (offset == tokenizer->size && !tokenizer->eof) {
                 pending_read = 1;
                 break;
 
-              } {
-                if (tokenizer->eof || data[offset] == '\n') {
-                  return 1;
-                }
-                if (data[offset] == delim) {
-                  state = YRC_TKS_DEFAULT;
+              }
+              if (tokenizer->eof) {
+                return 1;
+              }
+              offset = string_run(data, offset, tokenizer->size, delim);
+              if (offset == tokenizer->size) {
+                continue;
+              }
+              if (data[offset] == delim) {
+                state = YRC_TKS_DEFAULT;
+                break;
+
+              }
+              if (data[offset] == '\\') {
+                escapes = 1;
+                if (++offset == tokenizer->size) {
+                  /* the escaped character is in the next read */
+                  state = YRC_TKS_STRING_ESCAPE;
                   break;
 
                 }
-                if (data[offset] == '\\') {
-                  state = YRC_TKS_STRING_ESCAPE;
-                  if (yrc_str_pushv(&tokenizer->current, data + start, offset - start)) {
-                    return 1;
-                  }
-                  ++fpos;
-                  ++offset;
-                  goto restart;
+                /* a line continuation: `\` then LF, CR or CRLF */
+                if (data[offset] == '\n') {
+                  ++line;
+                  tokenizer->last_nl = fpos + offset - start;
+                } else if (data[offset] == '\r') {
+                  continued = fpos + offset - start + 1;
                 }
+                ++offset;
+                continue;
               }
-              last = data[offset];
+              /* a newline: only allowed as the LF of an escaped CRLF */
+              if (fpos + offset - start != continued) {
+                return 1;
+              }
+              ++line;
+              tokenizer->last_nl = continued;
               ++offset;
             }
             diff = offset - start;
@@ -525,11 +799,16 @@ restart:
               return 1;
             }
             start = offset;
-            if (pending_read) {
+            if (pending_read || state == YRC_TKS_STRING_ESCAPE) {
               pending_read = 0;
               break;
 
             }
+            /* escapes are decoded on demand, but must be well-formed now */
+            if (escapes && yrc_unescape(yrc_str_ptr(&tokenizer->current),
+                                        yrc_str_len(&tokenizer->current), NULL, 0, &diff)) {
+              return 1;
+            }
             tk = yrc_pool_attain(tokenizer->token_pool);
             if (tk == NULL) {
               return 1;
@@ -538,139 +817,37 @@ restart:
             ++fpos;
             ++offset;
             tk->info.as_string.delim = delim == '\'' ? YRC_STRING_DELIM_SINGLE : YRC_STRING_DELIM_DOUBLE;
-            yrc_str_xfer(&tokenizer->current, &tk->info.as_string.str);
-            goto export;
-          };
-          break;
-
-        case YRC_TKS_STRING_ESCAPE: {
-            ++fpos;
-            ++offset;
-            switch (data[offset - 1]) {
-              case 'u':
-              case 'U':
-                state = YRC_TKS_STRING_UNICODE;
-                tokenizer->flags = 0;
-                goto restart;
-              case 'x':
-              case 'X':
-                state = YRC_TKS_STRING_HEX;
-                tokenizer->flags = 0;
-                goto restart;
-              default:
-                return 1;
-              case '\\':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\\');
-                break;
-
-              case '"':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '"');
-                break;
-
-              case '\'':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\'');
-                break;
-
-              case 'n':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\n');
-                break;
-
-              case 't':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\t');
-                break;
-
-              case 'r':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\r');
-                break;
-
-              case 'v':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\v');
-                break;
-
-              case 'b':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\b');
-                break;
-
-              case 'f':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\f');
-                break;
-
-              case '0':
-                state = YRC_TKS_STRING;
-                yrc_str_push(&tokenizer->current, '\0');
-                break;
-
+            tk->info.as_string.has_escapes = escapes;
+            if (_take_current(tokenizer, &tk->info.as_string.str)) {
+              return 1;
             }
+            goto export;
           };
           break;
 
-        case YRC_TKS_STRING_UNICODE: {
-            while(1) {
-              if (tokenizer->eof) return 1;
-              if (tokenizer->flags) {
-                state = YRC_TKS_STRING;
-                tokenizer->flags = 0;
-                break;
-
-              }
-              switch (data[offset]) {
-                case 'a':
-                case 'A':
-                case 'b':
-                case 'B':
-                case 'c':
-                case 'C':
-                case 'd':
-                case 'D':
-                case 'f':
-                case 'F':
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                  break;
-
-                default:
-                  return 1;
-              } ++tokenizer->flags;
-              last = data[offset];
-              ++offset;
-            }
-            diff = offset - start;
-            fpos += diff;
-            if (yrc_str_pushv(&tokenizer->current, data + start, diff)) {
+        STATE(YRC_TKS_STRING_ESCAPE): {
+            if (tokenizer->eof) {
               return 1;
             }
-            start = offset;
-            if (pending_read) {
-              pending_read = 0;
+            if (offset == tokenizer->size) {
               break;
-
             }
+            if (data[offset] == '\n') {
+              ++line;
+              tokenizer->last_nl = fpos;
+            } else if (data[offset] == '\r') {
+              continued = fpos + 1;
+            }
+            if (yrc_str_push(&tokenizer->current, data[offset])) {
+              return 1;
+            }
+            ++offset;
+            ++fpos;
             state = YRC_TKS_STRING;
           };
           break;
 
-        case YRC_TKS_STRING_HEX:
-          UNREACHABLE();
-          break;
-
-        case YRC_TKS_NUMBER: {
+        STATE(YRC_TKS_NUMBER): {
             while(1) {
               if (offset == tokenizer->size && !tokenizer->eof) {
                 pending_read = 1;
@@ -767,31 +944,42 @@ restart:
             }
             tk->type = YRC_TOKEN_NUMBER;
             tk->info.as_number.repr = tokenizer->flags;
+            /* the scratch buffer is reused, so terminate it for strtod/strtoll */
+            if (yrc_str_push(&tokenizer->current, '\0')) {
+              return 1;
+            }
             if (tokenizer->flags & (REPR_SEEN_DOT | REPR_SEEN_EXP)) {
               tk->info.as_number.repr |= REPR_IS_FLOAT;
               tk->info.as_number.data.as_double = strtod(yrc_str_ptr(&tokenizer->current), NULL);
             } else {
               tk->info.as_number.data.as_int = strtoll(yrc_str_ptr(&tokenizer->current) + (tokenizer->flags & REPR_SEEN_HEX ? 2 : 0), NULL, tokenizer->flags & REPR_SEEN_HEX ? 16 : 10 );
             }
-            if (yrc_str_xfer(&tokenizer->current, NULL)) {
-              return 1;
-            }
+            yrc_str_clear(&tokenizer->current);
             goto export;
           };
           break;
 
-        case YRC_TKS_IDENTIFIER: {
+        STATE(YRC_TKS_IDENTIFIER): {
             while(1) {
               if (offset == tokenizer->size && !tokenizer->eof) {
                 pending_read = 1;
                 break;
 
               } {
-                if (tokenizer->eof || !is_alnum(data[offset])) {
+                if (tokenizer->eof) {
                   state = YRC_TKS_DEFAULT;
                   break;
 
                 }
+                if (!is_alnum(data[offset])) {
+                  if ((uint8_t)data[offset] < 0x80 ||
+                      (diff = yrc_utf8_id_char(data + offset, 0)) == 0) {
+                    state = YRC_TKS_DEFAULT;
+                    break;
+
+                  }
+                  offset += diff - 1;
+                }
               }
               last = data[offset];
               ++offset;
@@ -816,15 +1004,15 @@ restart:
             if (kw != 0) {
               tk->type = YRC_TOKEN_KEYWORD;
               tk->info.as_keyword = kw;
-              yrc_str_xfer(&tokenizer->current, NULL);
-            } else {
-              yrc_str_xfer(&tokenizer->current, &tk->info.as_ident.str);
+              yrc_str_clear(&tokenizer->current);
+            } else if (_take_current(tokenizer, &tk->info.as_ident.str)) {
+              return 1;
             }
             goto export;
           };
           break;
 
-        case YRC_TKS_OPERATOR: {
+        STATE(YRC_TKS_OPERATOR): {
             while(1) {
               if (offset == tokenizer->size && !tokenizer->eof) {
                 pending_read = 1;
@@ -846,17 +1034,18 @@ restart:
                   if (op_current == &STAR_NUL) {
                     state = YRC_TKS_COMMENT_BLOCK;
                     last = '\0';
-                    yrc_str_xfer(&tokenizer->current, NULL);
+                    yrc_str_clear(&tokenizer->current);
                     ++offset;
-                    ++fpos;
-                    goto restart;
+                    /* the opening slash too, unless a read split the two */
+                    fpos += offset - start;
+                    DISPATCH();
                   }
                   if (op_current == &SOLIDUS_NUL) {
                     state = YRC_TKS_COMMENT_LINE;
-                    yrc_str_xfer(&tokenizer->current, NULL);
+                    yrc_str_clear(&tokenizer->current);
                     ++offset;
-                    ++fpos;
-                    goto restart;
+                    fpos += offset - start;
+                    DISPATCH();
                   }
                 }
                 if (!op_current && (op_last->next[0] == &OP_TERM || op_last->next[1] == &OP_TERM || op_last->next[2] == &OP_TERM || op_last->next[3] == &OP_TERM)) {
@@ -886,14 +1075,12 @@ restart:
             }
             tk->type = YRC_TOKEN_OPERATOR;
             tk->info.as_operator = _string_to_operator(&tokenizer->current);
-            if (yrc_str_xfer(&tokenizer->current, NULL)) {
-              return 1;
-            }
+            yrc_str_clear(&tokenizer->current);
             goto export;
           };
           break;
 
-        case YRC_TKS_COMMENT_LINE: {
+        STATE(YRC_TKS_COMMENT_LINE): {
             while(1) {
               if (offset == tokenizer->size && !tokenizer->eof) {
                 pending_read = 1;
@@ -926,12 +1113,14 @@ restart:
             }
             tk->type = YRC_TOKEN_COMMENT;
             tk->info.as_comment.delim = 0;
-            yrc_str_xfer(&tokenizer->current, &tk->info.as_comment.str);
+            if (_take_current(tokenizer, &tk->info.as_comment.str)) {
+              return 1;
+            }
             goto export;
           };
           break;
 
-        case YRC_TKS_COMMENT_BLOCK: {
+        STATE(YRC_TKS_COMMENT_BLOCK): {
             while(1) {
               if (offset == tokenizer->size && !tokenizer->eof) {
                 pending_read = 1;
@@ -939,10 +1128,6 @@ restart:
 
               } {
                 if (tokenizer->eof) return 1;
-                if (data[offset] == '\n') {
-                  ++line;
-                  tokenizer->last_nl = offset;
-                }
                 if (data[offset] == '/' && last == '*') {
                   state = YRC_TKS_DEFAULT;
                   ++offset;
@@ -954,6 +1139,10 @@ restart:
               ++offset;
             }
             diff = offset - start;
+            if ((lines = count_newlines(data + start, diff, &nl)) != 0) {
+              line += lines;
+              tokenizer->last_nl = fpos + nl;
+            }
             fpos += diff;
             if (yrc_str_pushv(&tokenizer->current, data + start, diff)) {
               return 1;
@@ -970,12 +1159,14 @@ restart:
             }
             tk->type = YRC_TOKEN_COMMENT;
             tk->info.as_comment.delim = 1;
-            yrc_str_xfer(&tokenizer->current, &tk->info.as_comment.str);
+            if (_take_current(tokenizer, &tk->info.as_comment.str)) {
+              return 1;
+            }
             goto export;
           };
           break;
 
-        case YRC_TKS_REGEXP_HEAD: {
+        STATE(YRC_TKS_REGEXP_HEAD): {
             while(1) {
               if (offset == tokenizer->size && !tokenizer->eof) {
                 pending_read = 1;
@@ -1007,11 +1198,12 @@ restart:
               break;
 
             } ++offset;
+            ++fpos;
             tokenizer->flags = 0;
           };
           break;
 
-        case YRC_TKS_REGEXP_TAIL: {
+        STATE(YRC_TKS_REGEXP_TAIL): {
             while(1) {
               if (offset == tokenizer->size && !tokenizer->eof) {
                 pending_read = 1;
@@ -1067,12 +1259,16 @@ restart:
               return 1;
             }
             tk->type = YRC_TOKEN_REGEXP;
-            yrc_str_xfer(&tokenizer->current, &tk->info.as_regexp.str);
+            if (_take_current(tokenizer, &tk->info.as_regexp.str)) {
+              return 1;
+            }
             tk->info.as_regexp.flags = tokenizer->flags;
             goto export;
           };
           break;
 
+        STATE(YRC_TKS_ERROR):
+        STATE(YRC_TKS_DONE):
         default:
           printf("in weird state %d", state);
           UNREACHABLE();
@@ -1101,6 +1297,8 @@ export:
   if (yrc_llist_push(tokenizer->tokens, tk)) {
     return 1;
   }
+  YRC_STAT_INC(tokenizer, tokens[tk->type]);
+  YRC_STAT_SET(tokenizer, token_arenas, yrc_pool_arena_count(tokenizer->token_pool));
   *out = tk;
   tokenizer->start = start;
   tokenizer->fpos = fpos;
@@ -1180,6 +1378,110 @@ int yrc_tokenizer_promote_keyword(yrc_tokenizer_t* tokenizer, yrc_token_t* token
   return 0;
 }
 
+/**
+  for a tokenizer that picks up partway through a text (yrc_reparse):
+  tokens are positioned as though scanning had started at the top.
+**/
+void yrc_tokenizer_set_position(yrc_tokenizer_t* tokenizer, yrc_position_t* pos) {
+  tokenizer->fpos = pos->fpos;
+  tokenizer->line = pos->line;
+  tokenizer->col = pos->col;
+  tokenizer->last_nl = pos->fpos - pos->col;
+}
+
+/* where the next token will start (or the one that just failed did) */
+void yrc_tokenizer_position(yrc_tokenizer_t* tokenizer, yrc_position_t* pos) {
+  pos->fpos = tokenizer->fpos;
+  pos->line = tokenizer->line;
+  pos->col = tokenizer->col;
+}
+
+static inline void shift_position(yrc_position_t* pos, yrc_position_t* from, yrc_position_t* to) {
+  if (pos->line == from->line) {
+    pos->col = pos->col - from->col + to->col;
+  }
+  pos->fpos = pos->fpos - from->fpos + to->fpos;
+  pos->line = pos->line - from->line + to->line;
+}
+
+/* moves every token at or after `from` so that `from` lands on `to` */
+void yrc_tokenizer_shift(yrc_tokenizer_t* tokenizer, yrc_position_t* from, yrc_position_t* to) {
+  yrc_llist_iter_t iter = yrc_llist_iter_start(tokenizer->tokens);
+  yrc_token_t* token;
+  while ((token = yrc_llist_iter_next(&iter)) != NULL) {
+    if (token->start.fpos < from->fpos) {
+      continue;
+    }
+    shift_position(&token->start, from, to);
+    shift_position(&token->end, from, to);
+  }
+}
+
+/* frees every token scanned before `keep`, for callers that are done with them */
+int yrc_tokenizer_release(yrc_tokenizer_t* tokenizer, yrc_token_t* keep) {
+  yrc_llist_iter_t iterator;
+  yrc_token_t* token;
+  while (1) {
+    iterator = yrc_llist_iter_start(tokenizer->tokens);
+    token = yrc_llist_iter_next(&iterator);
+    if (token == NULL || token == keep) {
+      break;
+    }
+    yrc_llist_shift(tokenizer->tokens);
+    _free_tokens(token, 0, NULL, NULL);
+    if (yrc_pool_release(tokenizer->token_pool, token)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+  for scans that run without the parser: decides whether the `/` or `/=`
+  just scanned (`token`) opens a regexp, based on the last significant
+  token before it (`prev`, NULL at the start of input). a regexp can only
+  appear where an expression may start, so anything that ends an operand
+  means division. `)` and `}` are ambiguous; `)` almost always closes a
+  call or grouping, and `}` almost always closes a block.
+**/
+yrc_scan_allow_regexp yrc_tokenizer_regexp_mode(yrc_token_t* prev, yrc_token_t* token) {
+  yrc_scan_allow_regexp mode;
+  if (token->type != YRC_TOKEN_OPERATOR) {
+    return YRC_ISNT_REGEXP;
+  }
+  switch (token->info.as_operator) {
+    case YRC_OP_DIV: mode = YRC_IS_REGEXP; break;
+    case YRC_OP_DIVEQ: mode = YRC_IS_REGEXP_EQ; break;
+    default: return YRC_ISNT_REGEXP;
+  }
+  if (prev == NULL) {
+    return mode;
+  }
+  switch (prev->type) {
+    case YRC_TOKEN_KEYWORD:
+      return prev->info.as_keyword == YRC_KW_THIS ||
+             prev->info.as_keyword == YRC_KW_SUPER ? YRC_ISNT_REGEXP : mode;
+    case YRC_TOKEN_OPERATOR:
+      switch (prev->info.as_operator) {
+        case YRC_OP_RPAREN:
+        case YRC_OP_RBRACK:
+        case YRC_OP_INCR:
+        case YRC_OP_DECR:
+          return YRC_ISNT_REGEXP;
+        default:
+          return mode;
+      }
+    default:
+      return YRC_ISNT_REGEXP;
+  }
+}
+
+#ifdef YRC_STATS
+void yrc_tokenizer_set_stats(yrc_tokenizer_t* tokenizer, yrc_parse_stats_t* stats) {
+  tokenizer->stats = stats;
+}
+#endif
+
 int yrc_tokenizer_eof(yrc_tokenizer_t* state) {
   return state->eof;
 }
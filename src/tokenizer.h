@@ -10,10 +10,23 @@ typedef enum {
   YRC_NEXT_ADVANCE_FLAG=4
 } yrc_scan_allow_regexp;
 
+/* operator and keyword spellings, indexed by yrc_operator_t / yrc_keyword_t */
+extern const char* TOKEN_OPERATOR_MAP[];
+
 void yrc_token_repr(yrc_token_t*);
 int yrc_tokenizer_init(yrc_tokenizer_t**, size_t, void*);
 int yrc_tokenizer_scan(yrc_tokenizer_t*, yrc_readcb, yrc_token_t**, yrc_scan_allow_regexp);
 int yrc_tokenizer_free(yrc_tokenizer_t*);
 int yrc_tokenizer_eof(yrc_tokenizer_t*);
 int yrc_tokenizer_promote_keyword(yrc_tokenizer_t*, yrc_token_t*);
+int yrc_tokenizer_release(yrc_tokenizer_t*, yrc_token_t*);
+yrc_scan_allow_regexp yrc_tokenizer_regexp_mode(yrc_token_t*, yrc_token_t*);
+void yrc_tokenizer_position(yrc_tokenizer_t*, yrc_position_t*);
+void yrc_tokenizer_set_position(yrc_tokenizer_t*, yrc_position_t*);
+void yrc_tokenizer_shift(yrc_tokenizer_t*, yrc_position_t*, yrc_position_t*);
+size_t yrc_count_newlines(const char*, size_t, size_t*);
+int yrc_unescape(const char*, size_t, char*, size_t, size_t*);
+#ifdef YRC_STATS
+void yrc_tokenizer_set_stats(yrc_tokenizer_t*, yrc_parse_stats_t*);
+#endif
 #endif
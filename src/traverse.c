@@ -1,10 +1,99 @@
 #include "traverse.h"
+#include <string.h> /* memcpy */
+
+/**
+  traversal is iterative: a frame is pushed for every node we've yet to
+  enter, and a second "exiting" frame is left beneath its children so exit
+  fires once they've all been popped. children are pushed in source order
+  and the pushed run is reversed, so they pop in source order too.
+
+  yrc_traverse_stack walks using only the frames the caller hands it;
+  yrc_traverse starts on the C stack and grows onto the heap as needed.
+**/
+
+enum {
+  kInlineFrames=128
+};
+
+typedef struct traverse_stack_s {
+  yrc_traverse_frame_t* frames;
+  size_t size;
+  size_t top;
+  uint_fast8_t growable;
+  uint_fast8_t owned;
+} traverse_stack_t;
+
+#define FIRES(visitor, node) \
+  (!(visitor)->mask || ((visitor)->mask & ((uint64_t)1 << (node)->kind)))
+
+static int grow(traverse_stack_t* stack) {
+  yrc_traverse_frame_t* frames;
+  size_t size;
+  if (!stack->growable) {
+    return 1;
+  }
+  size = stack->size << 1;
+  if (stack->owned) {
+    frames = realloc(stack->frames, size * sizeof(*frames));
+    if (frames == NULL) {
+      return 1;
+    }
+  } else {
+    frames = malloc(size * sizeof(*frames));
+    if (frames == NULL) {
+      return 1;
+    }
+    memcpy(frames, stack->frames, stack->top * sizeof(*frames));
+    stack->owned = 1;
+  }
+  stack->frames = frames;
+  stack->size = size;
+  return 0;
+}
+
+static inline int push(traverse_stack_t* stack, yrc_ast_node_t* node, yrc_ast_node_t* parent, yrc_rel rel, uint_fast8_t exiting) {
+  yrc_traverse_frame_t* frame;
+  if (stack->top == stack->size && grow(stack)) {
+    return 1;
+  }
+  frame = stack->frames + stack->top++;
+  frame->node = node;
+  frame->parent = parent;
+  frame->rel = rel;
+  frame->exiting = exiting;
+  return 0;
+}
 
-static void _traverse(yrc_ast_node_t* node, yrc_visitor_t* visitor, yrc_ast_node_t* parent, yrc_rel rel) {
-  visitor->enter(node, rel, parent, visitor);
+static int push_list(traverse_stack_t* stack, yrc_llist_t* list, yrc_ast_node_t* parent, yrc_rel rel) {
   yrc_llist_iter_t iterator;
   yrc_ast_node_t* child;
+  if (list == NULL) {
+    return 0;
+  }
+  iterator = yrc_llist_iter_start(list);
+  while ((child = yrc_llist_iter_next(&iterator))) {
+    if (push(stack, child, parent, rel, 0)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void reverse(yrc_traverse_frame_t* lhs, yrc_traverse_frame_t* rhs) {
+  yrc_traverse_frame_t tmp;
+  while (lhs < rhs) {
+    tmp = *lhs;
+    *lhs++ = *rhs;
+    *rhs-- = tmp;
+  }
+}
 
+#define CHILD(PTR, REL) \
+  if ((PTR) && push(stack, (PTR), node, REL, 0)) return 1;
+#define CHILDREN(LIST, REL) \
+  if (push_list(stack, (LIST), node, REL)) return 1;
+
+static int push_children(traverse_stack_t* stack, yrc_ast_node_t* node) {
   switch (node->kind) {
     case YRC_AST_NULL:
     case YRC_AST_LAST:
@@ -12,44 +101,22 @@ static void _traverse(yrc_ast_node_t* node, yrc_visitor_t* visitor, yrc_ast_node
     break;
 
     case YRC_AST_PROGRAM:
-      iterator = yrc_llist_iter_start(node->data.as_program.body);
-      while ((child = yrc_llist_iter_next(&iterator))) {
-        _traverse(child, visitor, node, REL_BODY);
-      }
+      CHILDREN(node->data.as_program.body, REL_BODY);
     break;
 
     case YRC_AST_STMT_BLOCK:
-      iterator = yrc_llist_iter_start(node->data.as_block.body);
-      while ((child = yrc_llist_iter_next(&iterator))) {
-        _traverse(child, visitor, node, REL_BODY);
-      }
-    break;
-
-    case YRC_AST_STMT_EMPTY:
+      CHILDREN(node->data.as_block.body, REL_BODY);
     break;
 
     case YRC_AST_STMT_EXPR:
-      _traverse(node->data.as_exprstmt.expression,
-                visitor,
-                node,
-                REL_EXPRESSION);
+      CHILD(node->data.as_exprstmt.expression, REL_EXPRESSION);
     break;
 
     case YRC_AST_EXPR_CONDITIONAL:
     case YRC_AST_STMT_IF:
-      _traverse(node->data.as_if.test,
-                visitor,
-                node,
-                REL_TEST);
-      _traverse(node->data.as_if.consequent,
-                visitor,
-                node,
-                REL_CONSEQUENT);
-      if (node->data.as_if.alternate)
-      _traverse(node->data.as_if.alternate,
-                visitor,
-                node,
-                REL_ALTERNATE);
+      CHILD(node->data.as_if.test, REL_TEST);
+      CHILD(node->data.as_if.consequent, REL_CONSEQUENT);
+      CHILD(node->data.as_if.alternate, REL_ALTERNATE);
     break;
 
     case YRC_AST_STMT_LABEL:
@@ -61,132 +128,59 @@ static void _traverse(yrc_ast_node_t* node, yrc_visitor_t* visitor, yrc_ast_node
     break;
 
     case YRC_AST_CLSE_CASE:
-      if(node->data.as_case.test)
-      _traverse(node->data.as_case.test,
-                visitor,
-                node,
-                REL_TEST);
-
-      iterator = yrc_llist_iter_start(node->data.as_case.consequent);
-      while ((child = yrc_llist_iter_next(&iterator))) {
-        _traverse(child, visitor, node, REL_CONSEQUENT);
-      }
+      CHILD(node->data.as_case.test, REL_TEST);
+      CHILDREN(node->data.as_case.consequent, REL_CONSEQUENT);
     break;
 
     case YRC_AST_STMT_SWITCH:
-      _traverse(node->data.as_switch.discriminant,
-                visitor,
-                node,
-                REL_DISCRIMINANT);
-      iterator = yrc_llist_iter_start(node->data.as_switch.cases);
-      while ((child = yrc_llist_iter_next(&iterator))) {
-        _traverse(child, visitor, node, REL_CASES);
-      }
+      CHILD(node->data.as_switch.discriminant, REL_DISCRIMINANT);
+      CHILDREN(node->data.as_switch.cases, REL_CASES);
     break;
 
     case YRC_AST_STMT_THROW:
     case YRC_AST_STMT_RETURN:
-      if (node->data.as_return.argument) {
-        _traverse(node->data.as_return.argument,
-                  visitor,
-                  node,
-                  REL_ARGUMENT);
-      }
+      CHILD(node->data.as_return.argument, REL_ARGUMENT);
     break;
 
     case YRC_AST_STMT_TRY:
-      _traverse(node->data.as_try.block,
-                visitor,
-                node,
-                REL_BLOCK);
-      if (node->data.as_try.handler) {
-        _traverse(node->data.as_try.handler,
-                  visitor,
-                  node,
-                  REL_HANDLER);
-      }
-      if (node->data.as_try.finalizer) {
-        _traverse(node->data.as_try.finalizer,
-                  visitor,
-                  node,
-                  REL_FINALIZER);
-      }
+      CHILD(node->data.as_try.block, REL_BLOCK);
+      CHILD(node->data.as_try.handler, REL_HANDLER);
+      CHILD(node->data.as_try.finalizer, REL_FINALIZER);
     break;
 
+    /* the parser keeps a trailing finally on the catch clause */
     case YRC_AST_CLSE_CATCH:
-      _traverse(node->data.as_catch.param,
-                visitor,
-                node,
-                REL_PARAM);
-
-      _traverse(node->data.as_catch.body,
-                visitor,
-                node,
-                REL_BODY);
+      CHILD(node->data.as_catch.param, REL_PARAM);
+      CHILD(node->data.as_catch.body, REL_BODY);
+      CHILD(node->data.as_try.finalizer, REL_FINALIZER);
     break;
 
     case YRC_AST_CLSE_VAR:
-      _traverse(node->data.as_vardecl.id,
-                visitor,
-                node,
-                REL_ID);
-      if (node->data.as_vardecl.init)
-      _traverse(node->data.as_vardecl.init,
-                visitor,
-                node,
-                REL_INIT);
+      CHILD(node->data.as_vardecl.id, REL_ID);
+      CHILD(node->data.as_vardecl.init, REL_INIT);
     break;
 
     case YRC_AST_STMT_DOWHILE:
     case YRC_AST_STMT_WHILE:
-      _traverse(node->data.as_while.test,
-                visitor,
-                node,
-                REL_TEST);
-      _traverse(node->data.as_while.body,
-                visitor,
-                node,
-                REL_BODY);
+      CHILD(node->data.as_while.test, REL_TEST);
+      CHILD(node->data.as_while.body, REL_BODY);
     break;
 
     case YRC_AST_STMT_FOR:
-      if (node->data.as_for.init)
-      _traverse(node->data.as_for.init,
-                visitor,
-                node,
-                REL_INIT);
-      if (node->data.as_for.test)
-      _traverse(node->data.as_for.test,
-                visitor,
-                node,
-                REL_TEST);
-      if (node->data.as_for.update)
-      _traverse(node->data.as_for.update,
-                visitor,
-                node,
-                REL_UPDATE);
-      _traverse(node->data.as_for.body,
-                visitor,
-                node,
-                REL_BODY);
+      CHILD(node->data.as_for.init, REL_INIT);
+      CHILD(node->data.as_for.test, REL_TEST);
+      CHILD(node->data.as_for.update, REL_UPDATE);
+      CHILD(node->data.as_for.body, REL_BODY);
     break;
 
     case YRC_AST_STMT_FOROF:
     case YRC_AST_STMT_FORIN:
-      _traverse(node->data.as_for_in.left,
-                visitor,
-                node,
-                REL_LEFT);
-      _traverse(node->data.as_for_in.right,
-                visitor,
-                node,
-                REL_RIGHT);
-      _traverse(node->data.as_for_in.body,
-                visitor,
-                node,
-                REL_BODY);
+      CHILD(node->data.as_for_in.left, REL_LEFT);
+      CHILD(node->data.as_for_in.right, REL_RIGHT);
+      CHILD(node->data.as_for_in.body, REL_BODY);
     break;
 
+    case YRC_AST_STMT_EMPTY:
     case YRC_AST_EXPR_LITERAL:
     case YRC_AST_STMT_BREAK:
     case YRC_AST_STMT_CONTINUE:
@@ -195,49 +189,27 @@ static void _traverse(yrc_ast_node_t* node, yrc_visitor_t* visitor, yrc_ast_node
     break;
 
     case YRC_AST_DECL_VAR:
-      iterator = yrc_llist_iter_start(node->data.as_var.declarations);
-      while ((child = yrc_llist_iter_next(&iterator))) {
-        _traverse(child, visitor, node, REL_DECLARATIONS);
-      }
+      CHILDREN(node->data.as_var.declarations, REL_DECLARATIONS);
     break;
 
     case YRC_AST_EXPR_ARRAY:
-      if (node->data.as_array.elements) {
-        iterator = yrc_llist_iter_start(node->data.as_array.elements);
-        while ((child = yrc_llist_iter_next(&iterator))) {
-          _traverse(child, visitor, node, REL_ELEMENTS);
-        }
-      }
+      CHILDREN(node->data.as_array.elements, REL_ELEMENTS);
     break;
 
     case YRC_AST_EXPR_OBJECT:
-      if (node->data.as_object.properties) {
-        iterator = yrc_llist_iter_start(node->data.as_object.properties);
-        while ((child = yrc_llist_iter_next(&iterator))) {
-          _traverse(child, visitor, node, REL_PROPERTIES);
-        }
-      }
+      CHILDREN(node->data.as_object.properties, REL_PROPERTIES);
     break;
 
     case YRC_AST_EXPR_PROPERTY:
-      _traverse(node->data.as_property.key,
-                visitor, node, REL_KEY);
-      _traverse(node->data.as_property.expression,
-                visitor, node, REL_EXPRESSION);
+      CHILD(node->data.as_property.key, REL_KEY);
+      CHILD(node->data.as_property.expression, REL_EXPRESSION);
     break;
 
     case YRC_AST_DECL_FUNCTION:
     case YRC_AST_EXPR_FUNCTION:
-      iterator = yrc_llist_iter_start(node->data.as_function.params);
-      while ((child = yrc_llist_iter_next(&iterator))) {
-        _traverse(child, visitor, node, REL_PARAMS);
-      }
-      iterator = yrc_llist_iter_start(node->data.as_function.defaults);
-      while ((child = yrc_llist_iter_next(&iterator))) {
-        if (child)
-        _traverse(child, visitor, node, REL_DEFAULTS);
-      }
-      _traverse(node->data.as_function.body, visitor, node, REL_BODY);
+      CHILDREN(node->data.as_function.params, REL_PARAMS);
+      CHILDREN(node->data.as_function.defaults, REL_DEFAULTS);
+      CHILD(node->data.as_function.body, REL_BODY);
     break;
 
     case YRC_AST_EXPR_ARROW:
@@ -245,27 +217,20 @@ static void _traverse(yrc_ast_node_t* node, yrc_visitor_t* visitor, yrc_ast_node
     break;
 
     case YRC_AST_EXPR_SEQUENCE:
-      child = node;
-      do {
-        _traverse(child->data.as_sequence.left, visitor, node, REL_EXPRESSION);
-        child = node->data.as_sequence.right;
-      } while(child->kind == YRC_AST_EXPR_SEQUENCE);
-      _traverse(child, visitor, node, REL_EXPRESSION);
+      CHILD(node->data.as_sequence.left, REL_EXPRESSION);
+      CHILD(node->data.as_sequence.right, REL_EXPRESSION);
     break;
 
+    case YRC_AST_EXPR_UPDATE:
     case YRC_AST_EXPR_UNARY:
-      _traverse(node->data.as_unary.argument, visitor, node, REL_ARGUMENT);
+      CHILD(node->data.as_unary.argument, REL_ARGUMENT);
     break;
 
     case YRC_AST_EXPR_BINARY:
     case YRC_AST_EXPR_LOGICAL:
     case YRC_AST_EXPR_ASSIGNMENT:
-      _traverse(node->data.as_binary.left, visitor, node, REL_LEFT);
-      _traverse(node->data.as_binary.right, visitor, node, REL_RIGHT);
-    break;
-
-    case YRC_AST_EXPR_UPDATE:
-      _traverse(node->data.as_unary.argument, visitor, node, REL_ARGUMENT);
+      CHILD(node->data.as_binary.left, REL_LEFT);
+      CHILD(node->data.as_binary.right, REL_RIGHT);
     break;
 
     /* erk */
@@ -273,31 +238,86 @@ static void _traverse(yrc_ast_node_t* node, yrc_visitor_t* visitor, yrc_ast_node
     break;
 
     case YRC_AST_EXPR_CALL:
-      _traverse(node->data.as_call.callee, visitor, node, REL_CALLEE);
-      iterator = yrc_llist_iter_start(node->data.as_call.arguments);
-      while ((child = yrc_llist_iter_next(&iterator))) {
-        _traverse(child, visitor, node, REL_ARGUMENTS);
-      }
+      CHILD(node->data.as_call.callee, REL_CALLEE);
+      CHILDREN(node->data.as_call.arguments, REL_ARGUMENTS);
     break;
 
     case YRC_AST_EXPR_MEMBER:
-      _traverse(node->data.as_member.object, visitor, node, REL_OBJECT);
-      _traverse(node->data.as_member.property, visitor, node, REL_PROPERTY);
+      CHILD(node->data.as_member.object, REL_OBJECT);
+      CHILD(node->data.as_member.property, REL_PROPERTY);
     break;
 
     case YRC_AST_EXPR_YIELD:
     break;
 
   }
-  visitor->exit(node, rel, parent, visitor);
+  return 0;
+}
+
+#undef CHILD
+#undef CHILDREN
+
+static int run(traverse_stack_t* stack, yrc_visitor_t* visitor) {
+  yrc_traverse_frame_t frame;
+  yrc_visitor_mode mode;
+  size_t base;
+
+  while (stack->top) {
+    frame = stack->frames[--stack->top];
+    if (frame.exiting) {
+      if (visitor->exit && FIRES(visitor, frame.node) &&
+          visitor->exit(frame.node, frame.rel, frame.parent, visitor) == kYrcTraverseStop) {
+        return 0;
+      }
+      continue;
+    }
+
+    mode = kYrcTraverseContinue;
+    if (visitor->enter && FIRES(visitor, frame.node)) {
+      mode = visitor->enter(frame.node, frame.rel, frame.parent, visitor);
+    }
+    if (mode == kYrcTraverseStop) {
+      return 0;
+    }
+    if (push(stack, frame.node, frame.parent, frame.rel, 1)) {
+      return 1;
+    }
+    if (mode == kYrcTraverseSkip) {
+      continue;
+    }
+    base = stack->top;
+    if (push_children(stack, frame.node)) {
+      return 1;
+    }
+    if (stack->top > base) {
+      reverse(stack->frames + base, stack->frames + stack->top - 1);
+    }
+  }
+  return 0;
+}
+
+int yrc_traverse_from(yrc_ast_node_t* node, yrc_ast_node_t* parent, yrc_rel rel, yrc_visitor_t* visitor, yrc_traverse_frame_t* frames, size_t size) {
+  yrc_traverse_frame_t inline_frames[kInlineFrames];
+  traverse_stack_t stack;
+  int r;
+
+  stack.top = 0;
+  stack.owned = 0;
+  stack.growable = frames == NULL;
+  stack.frames = frames ? frames : inline_frames;
+  stack.size = frames ? size : kInlineFrames;
+
+  r = push(&stack, node, parent, rel, 0) || run(&stack, visitor);
+  if (stack.owned) {
+    free(stack.frames);
+  }
+  return r;
 }
 
-static yrc_visitor_mode nop(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
-  return kYrcTraverseContinue;
+YRC_EXTERN int yrc_traverse(yrc_ast_node_t* node, yrc_visitor_t* visitor) {
+  return yrc_traverse_from(node, NULL, REL_NONE, visitor, NULL, 0);
 }
 
-void yrc_traverse(yrc_ast_node_t* node, yrc_visitor_t* visitor) {
-  if (visitor->enter == NULL) visitor->enter = nop;
-  if (visitor->exit == NULL) visitor->exit = nop;
-  _traverse(node, visitor, NULL, REL_NONE);
+YRC_EXTERN int yrc_traverse_stack(yrc_ast_node_t* node, yrc_visitor_t* visitor, yrc_traverse_frame_t* frames, size_t size) {
+  return yrc_traverse_from(node, NULL, REL_NONE, visitor, frames, size);
 }
@@ -0,0 +1,302 @@
+#include "traverse.h"
+#include <string.h> /* memset */
+
+#ifdef _WIN32
+/* no thread pool on windows yet: everything runs on the calling thread */
+# define YRC_NO_THREADS 1
+#else
+# include <pthread.h>
+# include <unistd.h> /* sysconf */
+#endif
+
+typedef struct parallel_task_s {
+  yrc_ast_node_t* node;
+  yrc_ast_node_t* parent;
+  yrc_rel rel;
+} parallel_task_t;
+
+typedef struct parallel_state_s parallel_state_t;
+
+/* wraps the user's visitor so workers can hand off large function bodies */
+typedef struct parallel_worker_s {
+  yrc_visitor_t wrapper;  /* wrapper *must* come first! */
+  yrc_visitor_t* inner;
+  parallel_state_t* state;
+  int err;
+#ifndef YRC_NO_THREADS
+  pthread_t thread;
+#endif
+} parallel_worker_t;
+
+struct parallel_state_s {
+  parallel_task_t* tasks;
+  size_t ntasks;
+  size_t avail;
+  size_t pending;  /* queued + running */
+  size_t split_threshold;
+  int stopped;     /* read and written under the lock */
+#ifndef YRC_NO_THREADS
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+#endif
+};
+
+#ifdef YRC_NO_THREADS
+# define LOCK(state)
+# define UNLOCK(state)
+# define WAIT(state)
+# define BROADCAST(state)
+#else
+# define LOCK(state) pthread_mutex_lock(&(state)->lock)
+# define UNLOCK(state) pthread_mutex_unlock(&(state)->lock)
+# define WAIT(state) pthread_cond_wait(&(state)->cond, &(state)->lock)
+# define BROADCAST(state) pthread_cond_broadcast(&(state)->cond)
+#endif
+
+#define FIRES(visitor, node) \
+  (!(visitor)->mask || ((visitor)->mask & ((uint64_t)1 << (node)->kind)))
+
+/* call with the lock held */
+static int enqueue(parallel_state_t* state, yrc_ast_node_t* node, yrc_ast_node_t* parent, yrc_rel rel) {
+  parallel_task_t* tasks;
+  size_t avail;
+  if (state->ntasks == state->avail) {
+    avail = state->avail ? state->avail << 1 : 64;
+    tasks = realloc(state->tasks, avail * sizeof(*tasks));
+    if (tasks == NULL) {
+      return 1;
+    }
+    state->tasks = tasks;
+    state->avail = avail;
+  }
+  state->tasks[state->ntasks].node = node;
+  state->tasks[state->ntasks].parent = parent;
+  state->tasks[state->ntasks].rel = rel;
+  ++state->ntasks;
+  ++state->pending;
+  return 0;
+}
+
+/**
+  a worker whose visitor stops ends its own walk there; the others finish
+  the task they're on, and nothing more is queued or handed out.
+**/
+static void stop(parallel_state_t* state) {
+  LOCK(state);
+  state->stopped = 1;
+  UNLOCK(state);
+}
+
+static int enqueue_list(parallel_state_t* state, yrc_llist_t* list, yrc_ast_node_t* parent, yrc_rel rel) {
+  yrc_llist_iter_t iterator;
+  yrc_ast_node_t* child;
+  int r = 0;
+  LOCK(state);
+  iterator = yrc_llist_iter_start(list);
+  while (!r && !state->stopped && (child = yrc_llist_iter_next(&iterator))) {
+    r = enqueue(state, child, parent, rel);
+  }
+  BROADCAST(state);
+  UNLOCK(state);
+  return r;
+}
+
+static int is_split_point(parallel_state_t* state, yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent) {
+  return state->split_threshold &&
+         node->kind == YRC_AST_STMT_BLOCK &&
+         rel == REL_BODY &&
+         parent &&
+         (parent->kind == YRC_AST_EXPR_FUNCTION || parent->kind == YRC_AST_DECL_FUNCTION) &&
+         yrc_llist_len(node->data.as_block.body) >= state->split_threshold;
+}
+
+static yrc_visitor_mode wrap_enter(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  parallel_worker_t* worker = ctx;
+  yrc_visitor_t* inner = worker->inner;
+  yrc_visitor_mode mode = kYrcTraverseContinue;
+
+  if (inner->enter && FIRES(inner, node)) {
+    mode = inner->enter(node, rel, parent, inner);
+  }
+  if (mode == kYrcTraverseStop) {
+    stop(worker->state);
+    return mode;
+  }
+  if (mode == kYrcTraverseContinue && is_split_point(worker->state, node, rel, parent)) {
+    if (enqueue_list(worker->state, node->data.as_block.body, node, REL_BODY)) {
+      worker->err = 1;
+      stop(worker->state);
+      return kYrcTraverseStop;
+    }
+    return kYrcTraverseSkip;
+  }
+  return mode;
+}
+
+static yrc_visitor_mode wrap_exit(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  parallel_worker_t* worker = ctx;
+  yrc_visitor_t* inner = worker->inner;
+  if (inner->exit && FIRES(inner, node) &&
+      inner->exit(node, rel, parent, inner) == kYrcTraverseStop) {
+    stop(worker->state);
+    return kYrcTraverseStop;
+  }
+  return kYrcTraverseContinue;
+}
+
+static void* work(void* ctx) {
+  parallel_worker_t* worker = ctx;
+  parallel_state_t* state = worker->state;
+  parallel_task_t task;
+  int stopped;
+
+  LOCK(state);
+  while (1) {
+    while (!state->ntasks && state->pending) {
+      WAIT(state);
+    }
+    if (!state->ntasks) {
+      break;
+    }
+    task = state->tasks[--state->ntasks];
+    stopped = state->stopped;
+    UNLOCK(state);
+
+    if (!stopped &&
+        yrc_traverse_from(task.node, task.parent, task.rel, &worker->wrapper, NULL, 0)) {
+      worker->err = 1;
+      stop(state);
+    }
+
+    LOCK(state);
+    if (!--state->pending) {
+      BROADCAST(state);
+    }
+  }
+  UNLOCK(state);
+  return NULL;
+}
+
+static size_t online_cpus(void) {
+#ifdef YRC_NO_THREADS
+  return 1;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (size_t)n : 1;
+#endif
+}
+
+YRC_EXTERN int yrc_traverse_parallel(yrc_ast_node_t* root, yrc_parallel_visitor_t* pvisitor, void* init, void** out) {
+  parallel_worker_t* workers;
+  parallel_state_t state;
+  yrc_visitor_t* inner;
+  yrc_visitor_mode mode = kYrcTraverseContinue;
+  void* acc = init;
+  size_t nthreads;
+  size_t spawned = 0;
+  size_t i;
+  int err = 0;
+
+  nthreads = pvisitor->nthreads ? pvisitor->nthreads : online_cpus();
+#ifdef YRC_NO_THREADS
+  nthreads = 1;
+#endif
+  workers = calloc(nthreads, sizeof(*workers));
+  if (workers == NULL) {
+    return 1;
+  }
+  memset(&state, 0, sizeof(state));
+  state.split_threshold = pvisitor->split_threshold;
+#ifndef YRC_NO_THREADS
+  pthread_mutex_init(&state.lock, NULL);
+  pthread_cond_init(&state.cond, NULL);
+#endif
+
+  for (i = 0; i < nthreads; ++i) {
+    if (pvisitor->create(&workers[i].inner, pvisitor->ctx)) {
+      nthreads = i;
+      err = 1;
+      goto cleanup;
+    }
+    inner = workers[i].inner;
+    workers[i].state = &state;
+    workers[i].wrapper.enter = wrap_enter;
+    workers[i].wrapper.exit = wrap_exit;
+    /* the wrapper has to see blocks it might split, whatever the mask */
+    workers[i].wrapper.mask = inner->mask && state.split_threshold ?
+      inner->mask | YRC_TRAVERSE_KIND(STMT_BLOCK) :
+      inner->mask;
+  }
+
+  /* the root itself is visited by the first worker, around everything else */
+  inner = workers[0].inner;
+  if (root->kind == YRC_AST_PROGRAM) {
+    if (inner->enter && FIRES(inner, root)) {
+      mode = inner->enter(root, REL_NONE, NULL, inner);
+    }
+    if (mode == kYrcTraverseStop) {
+      goto reduce;
+    }
+    if (mode == kYrcTraverseContinue &&
+        enqueue_list(&state, root->data.as_program.body, root, REL_BODY)) {
+      err = 1;
+      goto cleanup;
+    }
+  } else {
+    LOCK(&state);
+    err = enqueue(&state, root, NULL, REL_NONE);
+    UNLOCK(&state);
+    if (err) {
+      goto cleanup;
+    }
+  }
+
+#ifndef YRC_NO_THREADS
+  for (spawned = 1; spawned < nthreads; ++spawned) {
+    if (pthread_create(&workers[spawned].thread, NULL, work, &workers[spawned])) {
+      break;
+    }
+  }
+#endif
+  work(&workers[0]);
+#ifndef YRC_NO_THREADS
+  for (i = 1; i < spawned; ++i) {
+    pthread_join(workers[i].thread, NULL);
+  }
+#endif
+
+  for (i = 0; i < nthreads; ++i) {
+    err |= workers[i].err;
+  }
+  if (err) {
+    goto cleanup;
+  }
+
+  if (root->kind == YRC_AST_PROGRAM && !state.stopped &&
+      inner->exit && FIRES(inner, root)) {
+    inner->exit(root, REL_NONE, NULL, inner);
+  }
+
+reduce:
+  for (i = 0; i < nthreads; ++i) {
+    if (pvisitor->reduce(acc, workers[i].inner, &acc, i, pvisitor->ctx)) {
+      err = 1;
+      goto cleanup;
+    }
+  }
+  *out = acc;
+
+cleanup:
+  for (i = 0; i < nthreads; ++i) {
+    if (pvisitor->destroy) {
+      pvisitor->destroy(workers[i].inner, pvisitor->ctx);
+    }
+  }
+#ifndef YRC_NO_THREADS
+  pthread_mutex_destroy(&state.lock);
+  pthread_cond_destroy(&state.cond);
+#endif
+  free(state.tasks);
+  free(workers);
+  return err;
+}
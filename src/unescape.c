@@ -0,0 +1,219 @@
+#include "yrc-common.h"
+#include "tokenizer.h"
+#include <string.h> /* memchr, memcpy */
+
+/**
+  string escapes, decoded on demand. the tokenizer keeps a string's text
+  as written and only notes whether it has a backslash in it, so the
+  great many strings that don't are never copied twice; the rest are
+  checked here once as they're scanned, and decoded here again whenever
+  someone asks for the value.
+
+  the escapes are ES2015's: the single characters, \xHH, \uHHHH (a pair
+  of them naming a surrogate pair makes one character), \u{H...}, legacy
+  octal, and a backslash before a line break continuing the line. any
+  other character after a backslash stands for itself.
+**/
+
+typedef struct sink_s {
+  char*   out;
+  size_t  size;
+  size_t  len;
+} sink_t;
+
+static void putv(sink_t* sink, const char* data, size_t size) {
+  size_t fits = 0;
+  if (sink->len < sink->size) {
+    fits = sink->size - sink->len < size ? sink->size - sink->len : size;
+    memcpy(sink->out + sink->len, data, fits);
+  }
+  sink->len += size;
+}
+
+/* lone surrogates are written as if they were characters (WTF-8) */
+static void put_utf8(sink_t* sink, uint32_t cp) {
+  char buf[4];
+  size_t len;
+  if (cp < 0x80) {
+    buf[0] = (char)cp;
+    len = 1;
+  } else if (cp < 0x800) {
+    buf[0] = (char)(0xc0 | cp >> 6);
+    buf[1] = (char)(0x80 | (cp & 0x3f));
+    len = 2;
+  } else if (cp < 0x10000) {
+    buf[0] = (char)(0xe0 | cp >> 12);
+    buf[1] = (char)(0x80 | (cp >> 6 & 0x3f));
+    buf[2] = (char)(0x80 | (cp & 0x3f));
+    len = 3;
+  } else {
+    buf[0] = (char)(0xf0 | cp >> 18);
+    buf[1] = (char)(0x80 | (cp >> 12 & 0x3f));
+    buf[2] = (char)(0x80 | (cp >> 6 & 0x3f));
+    buf[3] = (char)(0x80 | (cp & 0x3f));
+    len = 4;
+  }
+  putv(sink, buf, len);
+}
+
+static int hex_digit(char ch) {
+  if (ch >= '0' && ch <= '9') {
+    return ch - '0';
+  }
+  if (ch >= 'a' && ch <= 'f') {
+    return ch - 'a' + 10;
+  }
+  if (ch >= 'A' && ch <= 'F') {
+    return ch - 'A' + 10;
+  }
+  return -1;
+}
+
+/* exactly `count` hex digits at raw[*at] */
+static int read_hex(const char* raw, size_t size, size_t* at, size_t count, uint32_t* out) {
+  size_t i = *at;
+  int digit;
+  *out = 0;
+  if (size - i < count) {
+    return 1;
+  }
+  for (; count; --count, ++i) {
+    if ((digit = hex_digit(raw[i])) < 0) {
+      return 1;
+    }
+    *out = *out << 4 | digit;
+  }
+  *at = i;
+  return 0;
+}
+
+/* after `\u`: four digits, or any number in braces */
+static int read_unicode(const char* raw, size_t size, size_t* at, uint32_t* out) {
+  size_t i = *at;
+  size_t digits = 0;
+  uint32_t low;
+  int digit;
+
+  if (i < size && raw[i] == '{') {
+    *out = 0;
+    for (++i; i < size && (digit = hex_digit(raw[i])) >= 0; ++i, ++digits) {
+      *out = *out << 4 | digit;
+      if (*out > 0x10ffff) {
+        return 1;
+      }
+    }
+    if (digits == 0 || i == size || raw[i] != '}') {
+      return 1;
+    }
+    *at = i + 1;
+    return 0;
+  }
+  if (read_hex(raw, size, &i, 4, out)) {
+    return 1;
+  }
+  /* a high surrogate escaped right before a low one is a single character */
+  if (*out >= 0xd800 && *out <= 0xdbff && size - i >= 6 &&
+      raw[i] == '\\' && raw[i + 1] == 'u') {
+    *at = i + 2;
+    if (read_hex(raw, size, at, 4, &low) == 0 && low >= 0xdc00 && low <= 0xdfff) {
+      *out = 0x10000 + ((*out - 0xd800) << 10) + (low - 0xdc00);
+      return 0;
+    }
+  }
+  *at = i;
+  return 0;
+}
+
+/**
+  decode the text of a string, writing what fits of the value to `out`
+  and its whole length to `len`. returns 1 on a malformed escape. the
+  value is never longer than the text.
+**/
+int yrc_unescape(const char* raw, size_t size, char* out, size_t outsize, size_t* len) {
+  sink_t sink;
+  const char* slash;
+  size_t i = 0;
+  uint32_t cp;
+  size_t more;
+  char ch;
+
+  sink.out = out;
+  sink.size = outsize;
+  sink.len = 0;
+  while (i < size) {
+    slash = memchr(raw + i, '\\', size - i);
+    if (slash == NULL) {
+      putv(&sink, raw + i, size - i);
+      break;
+    }
+    putv(&sink, raw + i, slash - raw - i);
+    i = slash - raw + 1;
+    if (i == size) {
+      return 1;
+    }
+    ch = raw[i++];
+    switch (ch) {
+      case 'b': putv(&sink, "\b", 1); break;
+      case 'f': putv(&sink, "\f", 1); break;
+      case 'n': putv(&sink, "\n", 1); break;
+      case 'r': putv(&sink, "\r", 1); break;
+      case 't': putv(&sink, "\t", 1); break;
+      case 'v': putv(&sink, "\v", 1); break;
+      case '\n':
+        break;
+      case '\r':
+        if (i < size && raw[i] == '\n') {
+          ++i;
+        }
+        break;
+      case 'x':
+        if (read_hex(raw, size, &i, 2, &cp)) {
+          return 1;
+        }
+        put_utf8(&sink, cp);
+        break;
+      case 'u':
+        if (read_unicode(raw, size, &i, &cp)) {
+          return 1;
+        }
+        put_utf8(&sink, cp);
+        break;
+      case '0': case '1': case '2': case '3':
+      case '4': case '5': case '6': case '7':
+        /* up to \377 */
+        cp = ch - '0';
+        for (more = ch <= '3' ? 2 : 1; more && i < size && raw[i] >= '0' && raw[i] <= '7'; --more) {
+          cp = cp * 8 + (raw[i++] - '0');
+        }
+        put_utf8(&sink, cp);
+        break;
+      default:
+        /* U+2028 and U+2029 continue a line too */
+        if ((unsigned char)ch == 0xe2 && size - i >= 2 &&
+            (unsigned char)raw[i] == 0x80 && ((unsigned char)raw[i + 1] & 0xfe) == 0xa8) {
+          i += 2;
+          break;
+        }
+        putv(&sink, &ch, 1);
+        break;
+    }
+  }
+  *len = sink.len;
+  return 0;
+}
+
+YRC_EXTERN int yrc_token_string_value(yrc_token_t* token, char* buf, size_t bufsize, size_t* len) {
+  yrc_str_t* str;
+  if (token->type != YRC_TOKEN_STRING) {
+    return 1;
+  }
+  str = &token->info.as_string.str;
+  if (!token->info.as_string.has_escapes) {
+    *len = yrc_str_len(str);
+    if (bufsize) {
+      memcpy(buf, yrc_str_ptr(str), *len < bufsize ? *len : bufsize);
+    }
+    return 0;
+  }
+  return yrc_unescape(yrc_str_ptr(str), yrc_str_len(str), buf, bufsize, len);
+}
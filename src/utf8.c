@@ -0,0 +1,140 @@
+#include "utf8.h"
+#include "unicode-id.h"
+#include <string.h> /* memcpy */
+
+/**
+  input is UTF-8, checked as it's read. nearly all of it is ASCII, which
+  is passed over 32 bytes at a time with a test of the high bits; only
+  the rest is decoded, against the well-formed sequences of the Unicode
+  standard's table 3-7 (no overlongs, no surrogates, nothing past
+  U+10FFFF).
+**/
+
+enum {
+  kAsciiRun=32
+};
+
+/* spelled out in halves, C90 having no long long literals */
+static const uint64_t kHighBits = ((uint64_t)0x80808080 << 32) | 0x80808080;
+
+/* the length of the sequence a lead byte starts, or 0 if it can't */
+static size_t sequence_length(unsigned char lead) {
+  if (lead < 0x80) {
+    return 1;
+  }
+  if (lead < 0xc2) {
+    return 0;
+  }
+  if (lead < 0xe0) {
+    return 2;
+  }
+  if (lead < 0xf0) {
+    return 3;
+  }
+  return lead < 0xf5 ? 4 : 0;
+}
+
+/* the range the byte after `lead` must fall in */
+static int second_ok(unsigned char lead, unsigned char second) {
+  switch (lead) {
+    case 0xe0: return second >= 0xa0 && second <= 0xbf;
+    case 0xed: return second >= 0x80 && second <= 0x9f;
+    case 0xf0: return second >= 0x90 && second <= 0xbf;
+    case 0xf4: return second >= 0x80 && second <= 0x8f;
+    default: return (second & 0xc0) == 0x80;
+  }
+}
+
+/**
+  `whole` gets how much of `data` is whole, valid sequences: all of it,
+  or up to the start of one the end of `data` cuts short, or up to the
+  first that's invalid -- in which case the return is 1.
+**/
+int yrc_utf8_check(const char* data, size_t size, size_t* whole) {
+  const unsigned char* str = (const unsigned char*)data;
+  uint64_t words[kAsciiRun / 8];
+  size_t len;
+  size_t i = 0;
+  size_t j;
+
+  while (i < size) {
+    if (i + kAsciiRun <= size) {
+      memcpy(words, str + i, kAsciiRun);
+      if (((words[0] | words[1] | words[2] | words[3]) & kHighBits) == 0) {
+        i += kAsciiRun;
+        continue;
+      }
+    }
+    if (str[i] < 0x80) {
+      ++i;
+      continue;
+    }
+    len = sequence_length(str[i]);
+    for (j = 1; len && j < len && i + j < size; ++j) {
+      if (j == 1 ? !second_ok(str[i], str[i + 1]) : (str[i + j] & 0xc0) != 0x80) {
+        len = 0;
+      }
+    }
+    if (len == 0) {
+      *whole = i;
+      return 1;
+    }
+    if (i + len > size) {
+      break;
+    }
+    i += len;
+  }
+  *whole = i;
+  return 0;
+}
+
+static int in_table(const uint32_t* table, size_t size, uint32_t cp) {
+  size_t lo = 0;
+  size_t hi = size;
+  size_t mid;
+  uint32_t start;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    start = table[mid] >> YRC_ID_LENGTH_BITS;
+    if (cp < start) {
+      hi = mid;
+    } else if (cp - start > (table[mid] & ((1 << YRC_ID_LENGTH_BITS) - 1))) {
+      lo = mid + 1;
+    } else {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+  for a non-ASCII character at `data`, in input that has passed
+  yrc_utf8_check: its length in bytes if it can start an identifier (or,
+  with `start` 0, continue one -- ZWNJ and ZWJ included), else 0.
+**/
+size_t yrc_utf8_id_char(const char* data, int start) {
+  const unsigned char* str = (const unsigned char*)data;
+  size_t len = sequence_length(str[0]);
+  uint32_t cp;
+  switch (len) {
+    case 2:
+      cp = (str[0] & 0x1f) << 6 | (str[1] & 0x3f);
+      break;
+    case 3:
+      cp = (str[0] & 0x0f) << 12 | (str[1] & 0x3f) << 6 | (str[2] & 0x3f);
+      break;
+    case 4:
+      cp = (uint32_t)(str[0] & 0x07) << 18 | (str[1] & 0x3f) << 12 |
+           (str[2] & 0x3f) << 6 | (str[3] & 0x3f);
+      break;
+    default:
+      return 0;
+  }
+  if (start) {
+    return in_table(ID_START, sizeof(ID_START) / sizeof(ID_START[0]), cp) ? len : 0;
+  }
+  if (cp == 0x200c || cp == 0x200d) {
+    return len;
+  }
+  return in_table(ID_CONTINUE, sizeof(ID_CONTINUE) / sizeof(ID_CONTINUE[0]), cp) ? len : 0;
+}
@@ -0,0 +1,8 @@
+#ifndef _YRC_UTF8_H
+#define _YRC_UTF8_H
+#include "yrc-common.h"
+
+int yrc_utf8_check(const char*, size_t, size_t*);
+size_t yrc_utf8_id_char(const char*, int);
+
+#endif
@@ -1,6 +1,14 @@
 #include "yrc.h"
+#include "pool.h"
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+# include <dirent.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
 const char* msg = "try { x++ * y; x--; var abba = {get x: 3, [y]: 3, n}; } catch(err) { }; function hey() {}";
 
 size_t readmsg(char* data, size_t desired, void* ctx) {
@@ -21,15 +29,7 @@ size_t readmsg(char* data, size_t desired, void* ctx) {
 }
 
 size_t readstdin(char* data, size_t desired, void* ctx) {
-  static int cnt = 0;
   FILE* inp = (FILE*)ctx;
-  if (feof(inp)) {
-    if (cnt++ < 10) {
-      fseek(inp, 0, SEEK_SET);
-    } else {
-      return 0;
-    }
-  }
   return fread(data, 1, desired, inp);
 }
 
@@ -51,18 +51,1280 @@ size_t readstr(char* data, size_t desired, void* ctx) {
   return read;
 }
 
+/* serialize -> deserialize -> serialize must reproduce the same blob */
+int roundtrip(yrc_parse_response_t* resp) {
+  yrc_parse_response_t* loaded;
+  void* first;
+  void* second;
+  size_t first_size;
+  size_t second_size;
+  int ok;
+  if (yrc_ast_serialize(resp->root, &first, &first_size)) {
+    return 0;
+  }
+  if (yrc_ast_deserialize(first, first_size, &loaded)) {
+    free(first);
+    return 0;
+  }
+  if (yrc_ast_serialize(loaded->root, &second, &second_size)) {
+    yrc_parse_free(loaded);
+    free(first);
+    return 0;
+  }
+  ok = first_size == second_size && memcmp(first, second, first_size) == 0;
+  /* a truncated blob has to be rejected, not read past */
+  if (yrc_ast_deserialize(first, first_size - 8, &resp) == 0) {
+    ok = 0;
+    yrc_parse_free(resp);
+  }
+  yrc_parse_free(loaded);
+  free(first);
+  free(second);
+  return ok;
+}
+
+typedef struct text_s {
+  const char* data;
+  size_t size;
+  size_t pos;
+} text_t;
+
+size_t readtext(char* data, size_t desired, void* ctx) {
+  text_t* text = ctx;
+  size_t read = desired < text->size - text->pos ? desired : text->size - text->pos;
+  memcpy(data, text->data + text->pos, read);
+  text->pos += read;
+  return read;
+}
+
+int parsetext(const char* data, yrc_parse_response_t** out) {
+  text_t text = {data, strlen(data), 0};
+  yrc_parse_request_t req = {
+    .read=readtext,
+    .readsize=16384,
+    .readctx=&text,
+    .incremental=1
+  };
+  return yrc_parse(&req, out);
+}
+
+int same_tree(yrc_ast_node_t* lhs, yrc_ast_node_t* rhs) {
+  void* first;
+  void* second;
+  size_t first_size;
+  size_t second_size;
+  int ok = 0;
+  if (yrc_ast_serialize(lhs, &first, &first_size)) {
+    return 0;
+  }
+  if (yrc_ast_serialize(rhs, &second, &second_size) == 0) {
+    ok = first_size == second_size && memcmp(first, second, first_size) == 0;
+    free(second);
+  }
+  free(first);
+  return ok;
+}
+
+/* an edited-and-reparsed tree must match a fresh parse of the new text */
+int reparse(void) {
+  const char* before = "a = 1;\nif (a) {\n  b = 2;\n  c = 3;\n}\nd = 4;\n";
+  const char* after = "a = 1;\nif (a) {\n  b = 20 + x\n  y;\n  c = 3;\n}\nd = 4;\n";
+  const char* broken = "a = 1;\nif (a) {\n  b = 20 + x\n  y;\n  c = 3;\n\nd = 4;\n";
+  yrc_edit_t edit = {22, 23, 32};
+  yrc_edit_t unbrace = {43, 44, 43};
+  yrc_parse_response_t* resp;
+  yrc_parse_response_t* fresh;
+  int ok;
+  if (parsetext(before, &resp)) {
+    return 0;
+  }
+  if (yrc_reparse(resp, &edit, after, strlen(after)) || parsetext(after, &fresh)) {
+    yrc_parse_free(resp);
+    return 0;
+  }
+  ok = same_tree(resp->root, fresh->root);
+  /* a failed reparse leaves the response as it was */
+  ok = ok && yrc_reparse(resp, &unbrace, broken, strlen(broken)) &&
+       same_tree(resp->root, fresh->root);
+  yrc_parse_free(fresh);
+  yrc_parse_free(resp);
+  return ok;
+}
+
+typedef struct sink_s {
+  char data[4096];
+  size_t size;
+} sink_t;
+
+int writesink(const char* data, size_t size, void* ctx) {
+  sink_t* sink = ctx;
+  if (size >= sizeof(sink->data) - sink->size) {
+    return 1;
+  }
+  memcpy(sink->data + sink->size, data, size);
+  sink->size += size;
+  sink->data[sink->size] = 0;
+  return 0;
+}
+
+/* ESTree output, through a buffer small enough to flush mid-token */
+int json(void) {
+  const char* text = "x = new A(1).b;\nif (x) { y--; }";
+  const char* expected = "{\"type\":\"Program\",\"body\":["
+    "{\"type\":\"ExpressionStatement\",\"expression\":{\"type\":\"AssignmentExpression\","
+    "\"operator\":\"=\",\"left\":{\"type\":\"Identifier\",\"name\":\"x\"},"
+    "\"right\":{\"type\":\"MemberExpression\",\"computed\":false,"
+    "\"object\":{\"type\":\"NewExpression\",\"callee\":{\"type\":\"Identifier\",\"name\":\"A\"},"
+    "\"arguments\":[{\"type\":\"Literal\",\"value\":1}]},"
+    "\"property\":{\"type\":\"Identifier\",\"name\":\"b\"}}}},"
+    "{\"type\":\"IfStatement\",\"test\":{\"type\":\"Identifier\",\"name\":\"x\"},"
+    "\"consequent\":{\"type\":\"BlockStatement\",\"body\":["
+    "{\"type\":\"ExpressionStatement\",\"expression\":{\"type\":\"UpdateExpression\","
+    "\"operator\":\"--\",\"argument\":{\"type\":\"Identifier\",\"name\":\"y\"},\"prefix\":false}}]},"
+    "\"alternate\":null}],\"sourceType\":\"script\"}";
+  /* the if statement starts the second line and ends with the text */
+  const char* position = "\"range\":[16,31],\"loc\":{\"start\":{\"line\":2,\"column\":0},"
+    "\"end\":{\"line\":2,\"column\":15}}}],";
+  yrc_parse_response_t* resp;
+  char buffer[7];
+  sink_t sink = {{0}, 0};
+  yrc_output_t out = {writesink, &sink, buffer, sizeof(buffer)};
+  int ok;
+  if (parsetext(text, &resp)) {
+    return 0;
+  }
+  ok = yrc_ast_to_json(resp->root, &out, YRC_JSON_COMPACT | YRC_JSON_NO_POSITIONS) == 0 &&
+       strcmp(sink.data, expected) == 0;
+  sink.size = 0;
+  ok = ok && yrc_ast_to_json(resp->root, &out, YRC_JSON_COMPACT) == 0 &&
+       strstr(sink.data, position) != NULL;
+  yrc_parse_free(resp);
+  /* lone surrogates can't be written as UTF-8, so they stay escaped */
+  if (!ok || parsetext("'\\uD800x\\udfff\\uD83D\\uDE00'", &resp)) {
+    return 0;
+  }
+  sink.size = 0;
+  ok = yrc_ast_to_json(resp->root, &out, YRC_JSON_COMPACT | YRC_JSON_NO_POSITIONS) == 0 &&
+       strstr(sink.data, "\"value\":\"\\ud800x\\udfff\xf0\x9f\x98\x80\"") != NULL;
+  yrc_parse_free(resp);
+  return ok;
+}
+
+/* the same tree, judged by its ESTree output without positions */
+int same_json(yrc_ast_node_t* lhs, yrc_ast_node_t* rhs) {
+  static sink_t first;
+  static sink_t second;
+  yrc_output_t out = {writesink, NULL, NULL, 0};
+  first.size = second.size = 0;
+  out.writectx = &first;
+  if (yrc_ast_to_json(lhs, &out, YRC_JSON_COMPACT | YRC_JSON_NO_POSITIONS)) {
+    return 0;
+  }
+  out.writectx = &second;
+  if (yrc_ast_to_json(rhs, &out, YRC_JSON_COMPACT | YRC_JSON_NO_POSITIONS)) {
+    return 0;
+  }
+  return first.size == second.size && memcmp(first.data, second.data, first.size) == 0;
+}
+
+/* generated source must parse back to the tree it came from, in either mode */
+int codegen(void) {
+  const char* text = "x = new (a().b)(1 in y, -(-z));\n"
+    "if (a) { if (b) c(); } else d();\n"
+    "for (var i = (k in o); i < 0.5; i++) {}\n"
+    "({}).v = typeof /re/g;";
+  const char* expected = "x=new(a().b)(1 in y,- -z);if(a){if(b)c()}else d();"
+    "for(var i=(k in o);i<0.5;i++){}({}.v=typeof /re/g);";
+  yrc_parse_response_t* resp;
+  yrc_parse_response_t* again;
+  sink_t sink = {{0}, 0};
+  yrc_output_t out = {writesink, &sink, NULL, 0};
+  int flags;
+  int ok = 1;
+  if (parsetext(text, &resp)) {
+    return 0;
+  }
+  for (flags = YRC_CODEGEN_MINIFY; ok && flags >= 0; --flags) {
+    sink.size = 0;
+    ok = yrc_codegen(resp->root, &out, flags) == 0;
+    ok = ok && (flags == 0 || strcmp(sink.data, expected) == 0);
+    if (ok && parsetext(sink.data, &again) == 0) {
+      ok = same_json(resp->root, again->root);
+      yrc_parse_free(again);
+    } else {
+      ok = 0;
+    }
+  }
+  yrc_parse_free(resp);
+  return ok;
+}
+
+/* each name and literal maps back to where it started in the source */
+int sourcemap(void) {
+  const char* text = "a = 1;\nb(c);";
+  const char* expected = "{\"version\":3,\"sources\":[\"t.js\"],\"names\":[],"
+    "\"mappings\":\"AAAA,EAAI,EACJ,EAAE\"}";
+  yrc_parse_response_t* resp;
+  sink_t code = {{0}, 0};
+  sink_t map = {{0}, 0};
+  yrc_output_t code_out = {writesink, &code, NULL, 0};
+  yrc_output_t map_out = {writesink, &map, NULL, 0};
+  int ok;
+  if (parsetext(text, &resp)) {
+    return 0;
+  }
+  ok = yrc_codegen_map(resp->root, &code_out, &map_out, "t.js", YRC_CODEGEN_MINIFY) == 0 &&
+       strcmp(code.data, "a=1;b(c);") == 0 &&
+       strcmp(map.data, expected) == 0;
+  yrc_parse_free(resp);
+  return ok;
+}
+
+int collect_dependency(yrc_dependency_kind kind, yrc_token_t* specifier, void* ctx) {
+  sink_t* sink = ctx;
+  char prefix = "rieD"[kind];
+  return writesink(&prefix, 1, sink) ||
+         writesink(yrc_str_ptr(&specifier->info.as_string.str),
+                   yrc_str_len(&specifier->info.as_string.str), sink) ||
+         writesink(" ", 1, sink);
+}
+
+/* specifiers only: not from comments, strings, regexps or other objects */
+int dependencies(void) {
+  const char* data = "var a = require(\"a\"), b = x.require(\"no\");\n"
+    "/* require(\"no\") */ var s = \"require('no')\";\n"
+    "if (x) /require(\"no\")/.test(y);\n"
+    "c = d / require(\"c\") / 2; require(y + \"no\");\n"
+    "import \"e\"; import f, {g as h, default as i} from \"f\";\n"
+    "export * from \"g\"; export {j};\n"
+    "import(\"h\");";
+  text_t text = {data, strlen(data), 0};
+  yrc_parse_request_t req = {
+    .read=readtext,
+    .readsize=16,
+    .readctx=&text
+  };
+  sink_t sink = {{0}, 0};
+  return yrc_scan_dependencies(&req, collect_dependency, &sink) == 0 &&
+         strcmp(sink.data, "ra rc ie if eg Dh ") == 0;
+}
+
+/* accepts what yrc_parse does; points at the token that broke the parse */
+int validate(const char* filename) {
+  const char* good = "var a = 1 + function () { if (b) { c(); } return d; }(), e = /f/g;\n"
+    "switch (a) { case 1: a = -function () { for (;;) break; }; }";
+  const char* bad = "var a = 1;\nb(function () { return c + ; });";
+  text_t text = {good, strlen(good), 0};
+  yrc_parse_request_t req = {
+    .read=readtext,
+    .readsize=16,
+    .readctx=&text
+  };
+  yrc_error_t* error = NULL;
+  const char* token;
+  char message[64];
+  size_t line, col, fpos;
+  FILE* inp;
+  int ok;
+  if (yrc_validate(&req, &error) || error != NULL) {
+    return 0;
+  }
+  text.data = bad;
+  text.size = strlen(bad);
+  text.pos = 0;
+  if (yrc_validate(&req, &error) == 0 || error == NULL) {
+    return 0;
+  }
+  ok = yrc_error_position(error, &line, &col, &fpos) == 0 &&
+       line == 2 && col == 27 && fpos == 38 &&
+       yrc_error_token(error, &token) == 0 && strcmp(token, ";") == 0 &&
+       yrc_error(error, message, sizeof(message)) == 0 &&
+       strcmp(message, "2:28: unexpected `;`") == 0;
+  free(error);
+  if (!ok) {
+    return 0;
+  }
+
+  /* whatever yrc_parse takes, so does yrc_validate */
+  inp = fopen(filename, "r");
+  if (inp == NULL) {
+    return 0;
+  }
+  req.read = readstdin;
+  req.readsize = 16384;
+  req.readctx = inp;
+  ok = yrc_validate(&req, &error) == 0 && error == NULL;
+  free(error);
+  fclose(inp);
+  return ok;
+}
+
+/* fed a few bytes at a time, the parse comes out as yrc_parse's does */
+int feed(void) {
+  const char* data = "var a = function (b) { return b * 2; };\n"
+    "if (a(1)) { c = [a, /d/g, 'e f']; }";
+  size_t size = strlen(data);
+  size_t i;
+  yrc_parse_request_t req = {
+    .readsize=16
+  };
+  yrc_parser_t* parser;
+  yrc_parse_response_t* resp;
+  yrc_parse_response_t* expected;
+  char message[64];
+  int ok = 1;
+  if (yrc_parser_init(&parser, &req, 0)) {
+    return 0;
+  }
+  for (i = 0; i < size; i += 5) {
+    if (yrc_parser_feed(parser, data + i, size - i < 5 ? size - i : 5) != YRC_FEED_NEED_MORE) {
+      ok = 0;
+    }
+  }
+  ok = ok && yrc_parser_feed(parser, NULL, 0) == YRC_FEED_DONE &&
+       yrc_parser_response(parser, &resp) == 0;
+  yrc_parser_free(parser);
+  if (!ok || parsetext(data, &expected)) {
+    return 0;
+  }
+  ok = same_json(resp->root, expected->root);
+  yrc_parse_free(resp);
+  yrc_parse_free(expected);
+
+  /* freeing a parse that still wants input ends it first */
+  if (yrc_parser_init(&parser, &req, 0)) {
+    return 0;
+  }
+  ok = ok && yrc_parser_feed(parser, data, 20) == YRC_FEED_NEED_MORE;
+  yrc_parser_free(parser);
+
+  /* a fed parse that fails still says where */
+  if (!ok || yrc_parser_init(&parser, &req, 0)) {
+    return 0;
+  }
+  resp = NULL;
+  ok = yrc_parser_feed(parser, "var a = 1;\nb(c + );", 19) == YRC_FEED_ERROR &&
+       yrc_parser_response(parser, &resp) == 1 && resp && resp->root == NULL &&
+       yrc_error(resp->error, message, sizeof(message)) == 0 &&
+       strcmp(message, "2:7: unexpected `)`") == 0;
+  yrc_parse_free(resp);
+  yrc_parser_free(parser);
+  return ok;
+}
+
+/* a spent budget fails a parse, or pauses a fed one until it's resumed */
+int budget(void) {
+  const char* data = "var a = [1, 2, 3];\nfunction b(c) { return c + a[0]; }";
+  text_t text = {data, strlen(data), 0};
+  yrc_parse_request_t req = {
+    .read=readtext,
+    .readsize=16,
+    .readctx=&text,
+    .budget=8
+  };
+  yrc_parser_t* parser;
+  yrc_parse_response_t* resp;
+  yrc_parse_response_t* expected;
+  yrc_error_t* error = NULL;
+  char message[64];
+  char many[4096];
+  size_t yields = 0;
+  size_t i;
+  int status;
+  int ok;
+  /* a failed parse still says why */
+  ok = yrc_parse(&req, &resp) == 1 && resp != NULL && resp->root == NULL &&
+       yrc_error(resp->error, message, sizeof(message)) == 0 &&
+       strcmp(message, "1:9: out of time or tokens") == 0;
+  yrc_parse_free(resp);
+  text.pos = 0;
+  ok = ok && yrc_validate(&req, &error) == 1 && error != NULL &&
+       yrc_error(error, message, sizeof(message)) == 0 &&
+       strcmp(message, "1:9: out of time or tokens") == 0;
+  free(error);
+  /* the clock is only looked at every thousand tokens or so */
+  for (i = 0; i < sizeof(many) - 1; ++i) {
+    many[i] = i & 1 ? ';' : 'a';
+  }
+  many[i] = 0;
+  text.data = many;
+  text.size = i;
+  text.pos = 0;
+  req.budget = 0;
+  req.deadline = 1;
+  ok = ok && yrc_parse(&req, &resp) == 1 && resp != NULL &&
+       yrc_error(resp->error, message, sizeof(message)) == 0 &&
+       strstr(message, "out of time or tokens") != NULL;
+  yrc_parse_free(resp);
+  if (!ok) {
+    return 0;
+  }
+
+  req.budget = 8;
+  req.deadline = 0;
+  if (yrc_parser_init(&parser, &req, 0)) {
+    return 0;
+  }
+  status = yrc_parser_feed(parser, data, strlen(data));
+  while (status == YRC_FEED_YIELD) {
+    ++yields;
+    status = yrc_parser_resume(parser);
+  }
+  ok = status == YRC_FEED_NEED_MORE && yields > 2;
+  status = yrc_parser_feed(parser, NULL, 0);
+  while (status == YRC_FEED_YIELD) {
+    status = yrc_parser_resume(parser);
+  }
+  ok = ok && status == YRC_FEED_DONE && yrc_parser_response(parser, &resp) == 0;
+  yrc_parser_free(parser);
+  if (!ok || parsetext(data, &expected)) {
+    return 0;
+  }
+  ok = same_json(resp->root, expected->root);
+  yrc_parse_free(resp);
+  yrc_parse_free(expected);
+  return ok;
+}
+
+typedef struct tokens_s {
+  yrc_token_t* items;
+  size_t size;
+  size_t avail;
+} tokens_t;
+
+int collect_token(yrc_token_t* token, void* ctx) {
+  tokens_t* tokens = ctx;
+  yrc_token_t* grown;
+  if (tokens->size == tokens->avail) {
+    tokens->avail = tokens->avail ? tokens->avail * 2 : 1024;
+    grown = realloc(tokens->items, tokens->avail * sizeof(*grown));
+    if (grown == NULL) {
+      return 1;
+    }
+    tokens->items = grown;
+  }
+  tokens->items[tokens->size++] = *token;
+  return 0;
+}
+
+/* split across threads or not, the same tokens in the same places */
+int tokenize_parallel(void) {
+  const char* lines[] = {
+    "var a = b\n", "/ c / d;\n", "x = (\n", "/e+/g.test(f))\n", "\n\t \n", "@ g\n"
+  };
+  tokens_t one = {NULL, 0, 0};
+  tokens_t many = {NULL, 0, 0};
+  size_t size = 0;
+  size_t i;
+  size_t j;
+  char* text = malloc(1 << 20);
+  int ok = text != NULL;
+
+  for (i = 0; ok && size < (1 << 19); ++i) {
+    for (j = 0; j < sizeof(lines) / sizeof(lines[0]); ++j) {
+      size += sprintf(text + size, "%s", lines[j]);
+    }
+    /* now and then, a comment long enough to cross a cut */
+    if (i % 500 == 0) {
+      size += sprintf(text + size, "/* a comment\n");
+      for (j = 0; j < 1000; ++j) {
+        size += sprintf(text + size, "  that runs on\n");
+      }
+      size += sprintf(text + size, "*/  \n");
+    }
+  }
+  ok = ok &&
+       yrc_tokenize_parallel(text, size, 1, collect_token, &one) == 0 &&
+       yrc_tokenize_parallel(text, size, 4, collect_token, &many) == 0 &&
+       one.size == many.size && one.size > 0;
+  for (i = 0; ok && i < one.size; ++i) {
+    ok = one.items[i].type == many.items[i].type &&
+         memcmp(&one.items[i].start, &many.items[i].start, sizeof(yrc_position_t)) == 0 &&
+         memcmp(&one.items[i].end, &many.items[i].end, sizeof(yrc_position_t)) == 0;
+  }
+  free(one.items);
+  free(many.items);
+  free(text);
+  return ok;
+}
+
+/* where yrc puts a byte: columns count from 0 on the first line, 1 after */
+static void locate(const char* text, size_t fpos, yrc_position_t* pos) {
+  size_t i;
+  pos->fpos = fpos;
+  pos->line = 1;
+  pos->col = fpos;
+  for (i = 0; i < fpos; ++i) {
+    if (text[i] == '\n') {
+      ++pos->line;
+      pos->col = fpos - i;
+    }
+  }
+}
+
+/* lines and columns stay right through long comments and runs of blank lines */
+int positions(void) {
+  const char* text =
+    "a /* one\ntwo three four five six seven eight\n\n  nine */\n\n\n"
+    "            \n  \n b /**/ c /*****************\n*/ d\n\n\n\n\n\n\n\n"
+    "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n e // f\ng"
+    " 'a line\\\ncontinued' \"and\\\r\nanother\" h";
+  tokens_t tokens = {NULL, 0, 0};
+  yrc_position_t pos;
+  size_t i;
+  int ok = yrc_tokenize_parallel(text, strlen(text), 1, collect_token, &tokens) == 0 &&
+           tokens.size > 10;
+  for (i = 0; ok && i < tokens.size; ++i) {
+    locate(text, tokens.items[i].start.fpos, &pos);
+    ok = memcmp(&pos, &tokens.items[i].start, sizeof(pos)) == 0;
+    locate(text, tokens.items[i].end.fpos, &pos);
+    ok = ok && memcmp(&pos, &tokens.items[i].end, sizeof(pos)) == 0;
+  }
+  free(tokens.items);
+  return ok;
+}
+
+/* non-ASCII identifiers are whole tokens; input that isn't UTF-8 fails */
+int unicode(void) {
+  const char* text = "caf\xc3\xa9 = \xe5\x90\x8d + x\xe2\x80\x8c\xcc\x81 // \xf0\x9f\x98\x80\n";
+  const char* names[] = {"caf\xc3\xa9", "\xe5\x90\x8d", "x\xe2\x80\x8c\xcc\x81"};
+  const char* bad = "a = \"\xc0\xaf\"";
+  tokens_t tokens = {NULL, 0, 0};
+  yrc_str_t* str;
+  size_t found = 0;
+  size_t i;
+  int ok = yrc_tokenize_parallel(text, strlen(text), 1, collect_token, &tokens) == 0;
+  for (i = 0; ok && i < tokens.size; ++i) {
+    if (tokens.items[i].type != YRC_TOKEN_IDENT) {
+      continue;
+    }
+    str = &tokens.items[i].info.as_ident.str;
+    ok = found < 3 && yrc_str_len(str) == strlen(names[found]) &&
+         memcmp(yrc_str_ptr(str), names[found], yrc_str_len(str)) == 0;
+    ++found;
+  }
+  ok = ok && found == 3;
+  free(tokens.items);
+  tokens.items = NULL;
+  tokens.size = tokens.avail = 0;
+  ok = ok && yrc_tokenize_parallel(bad, strlen(bad), 1, collect_token, &tokens) != 0;
+  free(tokens.items);
+  return ok;
+}
+
+typedef struct {
+  char buf[64];
+  size_t sizes[4];
+  size_t count;
+  size_t used;
+} values_t;
+
+/* string payloads only live as long as the callback, so decode them here */
+int collect_value(yrc_token_t* token, void* ctx) {
+  values_t* values = ctx;
+  size_t len;
+  if (token->type != YRC_TOKEN_STRING) {
+    return 0;
+  }
+  if (values->count == 4 ||
+      yrc_token_string_value(token, values->buf + values->used,
+                             sizeof(values->buf) - values->used, &len) ||
+      len > yrc_str_len(&token->info.as_string.str)) {
+    return 1;
+  }
+  values->sizes[values->count++] = len;
+  values->used += len;
+  return 0;
+}
+
+/* string values come out decoded; malformed escapes fail the scan */
+int string_values(void) {
+  const char* text =
+    "'plain' \"a\\tb\\x41\\u00e9\\u{1F600}\\uD83D\\uDE00\" '\\101\\0\\q\\\n\\''";
+  const char expect[] =
+    "plain" "a\tbA\xc3\xa9\xf0\x9f\x98\x80\xf0\x9f\x98\x80" "A\0q'";
+  const char* bad[] = {"'\\x4'", "'\\u12'", "'\\u{110000}'"};
+  values_t values;
+  size_t i;
+  int ok;
+  memset(&values, 0, sizeof(values));
+  ok = yrc_tokenize_parallel(text, strlen(text), 1, collect_value, &values) == 0 &&
+       values.count == 3 && values.sizes[0] == 5 && values.sizes[1] == 14 &&
+       values.sizes[2] == 4 && values.used == sizeof(expect) - 1 &&
+       memcmp(values.buf, expect, values.used) == 0;
+  for (i = 0; ok && i < sizeof(bad) / sizeof(bad[0]); ++i) {
+    memset(&values, 0, sizeof(values));
+    ok = yrc_tokenize_parallel(bad[i], strlen(bad[i]), 1, collect_value, &values) != 0 &&
+         values.count == 0;
+  }
+  return ok;
+}
+
+typedef struct counter_s {
+  yrc_visitor_t visitor;  /* visitor *must* come first! */
+  size_t enters;
+  size_t exits;
+  size_t idents;
+  int misparented;
+  yrc_ast_node_type skip;
+  yrc_ast_node_type stop;
+} counter_t;
+
+yrc_visitor_mode count_enter(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  counter_t* counter = ctx;
+  ++counter->enters;
+  counter->idents += node->kind == YRC_AST_EXPR_IDENTIFIER;
+  if (parent && parent->kind == YRC_AST_EXPR_SEQUENCE &&
+      parent->data.as_sequence.left != node && parent->data.as_sequence.right != node) {
+    counter->misparented = 1;
+  }
+  if (node->kind == counter->stop) {
+    return kYrcTraverseStop;
+  }
+  return node->kind == counter->skip ? kYrcTraverseSkip : kYrcTraverseContinue;
+}
+
+yrc_visitor_mode count_exit(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  counter_t* counter = ctx;
+  ++counter->exits;
+  return kYrcTraverseContinue;
+}
+
+static void count(yrc_ast_node_t* root, uint64_t mask, yrc_ast_node_type skip,
+    yrc_ast_node_type stop, counter_t* counter) {
+  memset(counter, 0, sizeof(*counter));
+  counter->visitor.enter = count_enter;
+  counter->visitor.exit = count_exit;
+  counter->visitor.mask = mask;
+  counter->skip = skip;
+  counter->stop = stop;
+  if (yrc_traverse(root, &counter->visitor)) {
+    counter->misparented = 1;
+  }
+}
+
+/* masks pick kinds, skip keeps exit but not children, stop ends it all */
+int traverse(void) {
+  const char* text = "a = (b, c, d); function f(x) { return g(x); } h();";
+  yrc_parse_response_t* resp;
+  yrc_ast_node_t* root;
+  counter_t all;
+  counter_t counter;
+  int ok;
+  if (parsetext(text, &resp)) {
+    return 0;
+  }
+  root = resp->root;
+  count(root, YRC_TRAVERSE_ALL, YRC_AST_NULL, YRC_AST_NULL, &all);
+  ok = all.enters == all.exits && all.idents == 8 && !all.misparented;
+  /* nested sequences are nodes like any other */
+  count(root, YRC_TRAVERSE_KIND(EXPR_SEQUENCE), YRC_AST_NULL, YRC_AST_NULL, &counter);
+  ok = ok && counter.enters == 2 && counter.exits == 2;
+  count(root, YRC_TRAVERSE_KIND(EXPR_IDENTIFIER) | YRC_TRAVERSE_KIND(EXPR_CALL),
+        YRC_AST_NULL, YRC_AST_NULL, &counter);
+  ok = ok && counter.enters == 10 && counter.idents == 8;
+  count(root, YRC_TRAVERSE_ALL, YRC_AST_DECL_FUNCTION, YRC_AST_NULL, &counter);
+  ok = ok && counter.idents == 5 && counter.enters == counter.exits &&
+       counter.enters < all.enters;
+  /* stops entering g(x), after a, b, c, d and the parameter */
+  count(root, YRC_TRAVERSE_ALL, YRC_AST_NULL, YRC_AST_EXPR_CALL, &counter);
+  ok = ok && counter.idents == 5 && counter.exits < counter.enters;
+  yrc_parse_free(resp);
+
+  /* a finally after a catch hangs off the catch clause */
+  if (!ok || parsetext("try { a(); } catch (e) { b(e); } finally { c(); }", &resp)) {
+    return 0;
+  }
+  count(resp->root, YRC_TRAVERSE_ALL, YRC_AST_NULL, YRC_AST_NULL, &all);
+  ok = all.enters == all.exits && all.idents == 5 && !all.misparented;
+  count(resp->root, YRC_TRAVERSE_KIND(STMT_BLOCK), YRC_AST_NULL, YRC_AST_NULL, &counter);
+  ok = ok && counter.enters == 3;
+  yrc_parse_free(resp);
+  return ok;
+}
+
+typedef struct visit_s {
+  uintptr_t node;
+  uintptr_t parent;
+  int rel;
+  int exiting;
+} visit_t;
+
+typedef struct visits_s {
+  yrc_visitor_t visitor;  /* visitor *must* come first! */
+  visit_t* items;
+  size_t size;
+  size_t avail;
+  yrc_ast_node_type skip;
+  yrc_ast_node_type stop;
+  int failed;
+} visits_t;
+
+static void record(visits_t* visits, yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, int exiting) {
+  visit_t* grown;
+  if (visits->size == visits->avail) {
+    visits->avail = visits->avail ? visits->avail * 2 : 256;
+    grown = realloc(visits->items, visits->avail * sizeof(*grown));
+    if (grown == NULL) {
+      visits->failed = 1;
+      return;
+    }
+    visits->items = grown;
+  }
+  visits->items[visits->size].node = (uintptr_t)node;
+  visits->items[visits->size].parent = (uintptr_t)parent;
+  visits->items[visits->size].rel = rel;
+  visits->items[visits->size].exiting = exiting;
+  ++visits->size;
+}
+
+yrc_visitor_mode record_enter(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  visits_t* visits = ctx;
+  record(visits, node, rel, parent, 0);
+  if (node->kind == visits->stop) {
+    return kYrcTraverseStop;
+  }
+  return node->kind == visits->skip ? kYrcTraverseSkip : kYrcTraverseContinue;
+}
+
+yrc_visitor_mode record_exit(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  record(ctx, node, rel, parent, 1);
+  return kYrcTraverseContinue;
+}
+
+/* the parallel visitor's ctx is the visitor every worker copies */
+int create_visits(yrc_visitor_t** out, void* ctx) {
+  visits_t* visits = malloc(sizeof(*visits));
+  if (visits == NULL) {
+    return 1;
+  }
+  *visits = *(visits_t*)ctx;
+  *out = &visits->visitor;
+  return 0;
+}
+
+int destroy_visits(yrc_visitor_t* visitor, void* ctx) {
+  free(((visits_t*)visitor)->items);
+  free(visitor);
+  return 0;
+}
+
+int reduce_visits(void* last, void* item, void** out, size_t idx, void* ctx) {
+  visits_t* all = last;
+  visits_t* visits = item;
+  size_t i;
+  all->failed |= visits->failed;
+  for (i = 0; i < visits->size; ++i) {
+    record(all, (yrc_ast_node_t*)visits->items[i].node, visits->items[i].rel,
+           (yrc_ast_node_t*)visits->items[i].parent, visits->items[i].exiting);
+  }
+  *out = all;
+  return 0;
+}
+
+static int compare_visit(const void* lhs, const void* rhs) {
+  const visit_t* a = lhs;
+  const visit_t* b = rhs;
+  if (a->node != b->node) {
+    return a->node < b->node ? -1 : 1;
+  }
+  if (a->exiting != b->exiting) {
+    return a->exiting - b->exiting;
+  }
+  if (a->parent != b->parent) {
+    return a->parent < b->parent ? -1 : 1;
+  }
+  return a->rel - b->rel;
+}
+
+/* sorted visits, sequentially or on four threads splitting bodies of two or more statements */
+static int visit(yrc_ast_node_t* root, uint64_t mask, yrc_ast_node_type skip,
+    yrc_ast_node_type stop, int parallel, visits_t* out) {
+  yrc_parallel_visitor_t pvisitor;
+  visits_t proto;
+  void* result;
+  memset(&proto, 0, sizeof(proto));
+  proto.visitor.enter = record_enter;
+  proto.visitor.exit = record_exit;
+  proto.visitor.mask = mask;
+  proto.skip = skip;
+  proto.stop = stop;
+  *out = proto;
+  if (parallel) {
+    pvisitor.create = create_visits;
+    pvisitor.destroy = destroy_visits;
+    pvisitor.reduce = reduce_visits;
+    pvisitor.ctx = &proto;
+    pvisitor.nthreads = 4;
+    pvisitor.split_threshold = 2;
+    if (yrc_traverse_parallel(root, &pvisitor, out, &result)) {
+      return 1;
+    }
+  } else if (yrc_traverse(root, &out->visitor)) {
+    return 1;
+  }
+  if (out->size) {
+    qsort(out->items, out->size, sizeof(*out->items), compare_visit);
+  }
+  return out->failed;
+}
+
+static int same_visits(visits_t* lhs, visits_t* rhs) {
+  size_t i;
+  if (lhs->size != rhs->size) {
+    return 0;
+  }
+  for (i = 0; i < lhs->size; ++i) {
+    if (compare_visit(&lhs->items[i], &rhs->items[i])) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* parallel traversal sees what sequential traversal does, in some order */
+int traverse_parallel(yrc_ast_node_t* root) {
+  static const uint64_t masks[] = {
+    YRC_TRAVERSE_ALL,
+    YRC_TRAVERSE_KIND(EXPR_IDENTIFIER) | YRC_TRAVERSE_KIND(EXPR_CALL) |
+      YRC_TRAVERSE_KIND(EXPR_SEQUENCE),
+    YRC_TRAVERSE_KIND(STMT_BLOCK) | YRC_TRAVERSE_KIND(EXPR_FUNCTION)
+  };
+  visits_t all;
+  visits_t seq;
+  visits_t par;
+  size_t i;
+  size_t j;
+  int ok = visit(root, YRC_TRAVERSE_ALL, YRC_AST_NULL, YRC_AST_NULL, 0, &all) == 0;
+  for (i = 0; ok && i < sizeof(masks) / sizeof(masks[0]); ++i) {
+    /* with and without skipping function expressions */
+    for (j = 0; ok && j < 2; ++j) {
+      ok = visit(root, masks[i], j ? YRC_AST_EXPR_FUNCTION : YRC_AST_NULL, YRC_AST_NULL, 0, &seq) == 0 &&
+           visit(root, masks[i], j ? YRC_AST_EXPR_FUNCTION : YRC_AST_NULL, YRC_AST_NULL, 1, &par) == 0 &&
+           same_visits(&seq, &par);
+      free(seq.items);
+      free(par.items);
+    }
+  }
+  /* a stop ends it early: only nodes the whole traversal would visit, and not the root's exit */
+  if (ok) {
+    ok = visit(root, YRC_TRAVERSE_ALL, YRC_AST_NULL, YRC_AST_EXPR_IDENTIFIER, 1, &par) == 0 &&
+         par.size < all.size;
+    for (i = 0, j = 0; ok && i < par.size; ++i) {
+      while (j < all.size && compare_visit(&all.items[j], &par.items[i]) < 0) {
+        ++j;
+      }
+      ok = j < all.size && compare_visit(&all.items[j], &par.items[i]) == 0;
+      ok = ok && !(par.items[i].node == (uintptr_t)root && par.items[i].exiting);
+      ++j;
+    }
+    free(par.items);
+  }
+  free(all.items);
+  return ok;
+}
+
+/* every class hands out 8-byte aligned slots, past the first arena and
+   (with YRC_POOL_MMAP) into mapped chunks */
+int pool_alignment(void) {
+  static const size_t sizes[] = {8, 24, 32, 48, 56, 512};
+  size_t count = sizeof(sizes) / sizeof(sizes[0]);
+  yrc_pool_t* pool;
+  void* ptr;
+  size_t i;
+  size_t j;
+  int ok = 1;
+  if (yrc_pool_init_classes(&pool, sizes, count)) {
+    return 0;
+  }
+  for (i = 0; ok && i < count; ++i) {
+    for (j = 0; ok && j < 8192; ++j) {
+      ptr = yrc_pool_attain_class(pool, i);
+      ok = ptr != NULL && (uintptr_t)ptr % 8 == 0;
+      if (ok && j % 3 == 0) {
+        yrc_pool_release(pool, ptr);
+      }
+    }
+  }
+  ptr = yrc_pool_attain(pool);
+  ok = ok && ptr != NULL && (uintptr_t)ptr % 8 == 0;
+  yrc_pool_free(pool);
+  return ok;
+}
+
+enum {
+  kSeenSize=8192
+};
+
+typedef struct seen_s {
+  yrc_visitor_t visitor;  /* visitor *must* come first! */
+  const void* nodes[kSeenSize];
+  size_t count;
+  size_t statements;
+} seen_t;
+
+/* remembers every node address handed out, until the table half fills */
+yrc_visitor_mode see_node(yrc_ast_node_t* node, yrc_rel rel, yrc_ast_node_t* parent, void* ctx) {
+  seen_t* seen = ctx;
+  size_t i = ((uintptr_t)node >> 3) % kSeenSize;
+  while (seen->nodes[i] != NULL && seen->nodes[i] != node) {
+    i = (i + 1) % kSeenSize;
+  }
+  if (seen->nodes[i] == NULL) {
+    if (seen->count == kSeenSize / 2) {
+      return kYrcTraverseStop;
+    }
+    seen->nodes[i] = node;
+    ++seen->count;
+  }
+  return kYrcTraverseContinue;
+}
+
+int see_statement(yrc_ast_node_t* stmt, void* ctx) {
+  seen_t* seen = ctx;
+  ++seen->statements;
+  return yrc_traverse(stmt, &seen->visitor) || seen->count == kSeenSize / 2;
+}
+
+/* streamed statements go back to the pool, so new ones reuse their nodes */
+int stream_release(void) {
+  const char* snippet =
+    "x = (a, b, c, d);\n"
+    "try { f(); } catch (e) { g(e); } finally { h(); }\n"
+    "var o = {p, q: [1, 2]}, i;\n"
+    "function k(y) { for (i in y) { switch (i) { case 1: return y; } } }\n";
+  size_t len = strlen(snippet);
+  size_t reps = 4000;
+  text_t text;
+  char* data;
+  seen_t* seen;
+  yrc_parse_response_t* resp;
+  size_t i;
+  int ok;
+  data = malloc(len * reps);
+  seen = calloc(1, sizeof(*seen));
+  if (data == NULL || seen == NULL) {
+    free(data);
+    free(seen);
+    return 0;
+  }
+  for (i = 0; i < reps; ++i) {
+    memcpy(data + i * len, snippet, len);
+  }
+  text.data = data;
+  text.size = len * reps;
+  text.pos = 0;
+  seen->visitor.enter = see_node;
+  seen->visitor.exit = NULL;
+  seen->visitor.mask = YRC_TRAVERSE_ALL;
+  {
+    yrc_parse_request_t req = {
+      .read=readtext,
+      .readsize=16384,
+      .readctx=&text,
+      .statement=see_statement,
+      .statementctx=seen
+    };
+    ok = yrc_parse(&req, &resp) == 0;
+  }
+  yrc_parse_free(resp);
+  ok = ok && seen->statements == reps * 4 && seen->count < kSeenSize / 2;
+  free(seen);
+  free(data);
+  return ok;
+}
+
+#ifndef _WIN32
+typedef struct entries_s {
+  char path[256];   /* the last entry found */
+  size_t count;
+  size_t bytes;
+} entries_t;
+
+/* tallies a cache directory's entries, or with `clear` removes it */
+static void entries(const char* dir, entries_t* out, int clear) {
+  struct dirent* dent;
+  struct stat st;
+  char path[256];
+  size_t len;
+  DIR* handle = opendir(dir);
+  memset(out, 0, sizeof(*out));
+  if (handle == NULL) {
+    return;
+  }
+  while ((dent = readdir(handle)) != NULL) {
+    if (strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0) {
+      continue;
+    }
+    if (snprintf(path, sizeof(path), "%s/%s", dir, dent->d_name) >= (int)sizeof(path)) {
+      continue;
+    }
+    len = strlen(dent->d_name);
+    if (clear) {
+      unlink(path);
+    } else if (len > 5 && strcmp(dent->d_name + len - 5, ".yrca") == 0 && stat(path, &st) == 0) {
+      ++out->count;
+      out->bytes += st.st_size;
+      memcpy(out->path, path, sizeof(path));
+    }
+  }
+  closedir(handle);
+  if (clear) {
+    rmdir(dir);
+  }
+}
+
+static int cached(yrc_cache_t* cache, const char* data, yrc_parse_response_t** out) {
+  text_t text = {data, strlen(data), 0};
+  yrc_parse_request_t req = {
+    .read=readtext,
+    .readsize=16384,
+    .readctx=&text
+  };
+  return yrc_cache_parse(cache, &req, out);
+}
+
+/* a hit after a miss; an entry that isn't this input's, or is cut short, is a miss */
+static int cached_same(yrc_cache_t* cache, const char* data, yrc_parse_response_t* expected,
+    size_t hits, size_t misses) {
+  yrc_parse_response_t* resp;
+  size_t got_hits;
+  size_t got_misses;
+  int ok = cached(cache, data, &resp) == 0 && same_json(resp->root, expected->root);
+  yrc_parse_free(resp);
+  yrc_cache_counts(cache, &got_hits, &got_misses);
+  return ok && got_hits == hits && got_misses == misses;
+}
+
+int cache(void) {
+  const char* first = "var a = function (b) { return [b, 'c']; };";
+  const char* second = "if (x) { y(z); } else { w = 1; }";
+  char one[] = "/tmp/yrc-cache-XXXXXX";
+  char two[] = "/tmp/yrc-cache-XXXXXX";
+  char text[64];
+  yrc_cache_t* cache_one = NULL;
+  yrc_cache_t* cache_two = NULL;
+  yrc_parse_response_t* expected;
+  yrc_parse_response_t* other;
+  entries_t a;
+  entries_t b;
+  size_t i;
+  int ok;
+  if (mkdtemp(one) == NULL || mkdtemp(two) == NULL ||
+      parsetext(first, &expected)) {
+    return 0;
+  }
+  if (parsetext(second, &other)) {
+    yrc_parse_free(expected);
+    return 0;
+  }
+  ok = yrc_cache_init(&cache_one, one, 0) == 0;
+  ok = ok && yrc_cache_init(&cache_two, two, 0) == 0;
+  ok = ok && cached_same(cache_one, first, expected, 0, 1) &&
+       cached_same(cache_one, first, expected, 1, 1) &&
+       cached_same(cache_two, second, other, 0, 1);
+  /* as if the two inputs' hashes collided */
+  entries(one, &a, 0);
+  entries(two, &b, 0);
+  ok = ok && a.count == 1 && b.count == 1 && rename(b.path, a.path) == 0 &&
+       cached_same(cache_one, first, expected, 1, 2);
+  entries(one, &a, 0);
+  ok = ok && a.count == 1 && truncate(a.path, a.bytes / 2) == 0 &&
+       cached_same(cache_one, first, expected, 1, 3) &&
+       cached_same(cache_one, first, expected, 2, 3);
+  yrc_parse_free(other);
+  other = NULL;
+
+  /* room for two entries: storing a third evicts the oldest */
+  if (cache_two) {
+    yrc_cache_free(cache_two);
+    cache_two = NULL;
+  }
+  entries(two, &b, 1);
+  ok = ok && yrc_cache_init(&cache_two, two, a.bytes * 2) == 0;
+  for (i = 0; ok && i < 6; ++i) {
+    snprintf(text, sizeof(text), "var %c = function (b) { return [b, 'c']; };", (int)('a' + i));
+    ok = cached(cache_two, text, &other) == 0;
+    yrc_parse_free(other);
+    other = NULL;
+    entries(two, &b, 0);
+    ok = ok && b.count > 0 && b.bytes <= a.bytes * 2;
+  }
+  /* the newest entry outlives the evictions */
+  ok = ok && parsetext(text, &other) == 0 && cached_same(cache_two, text, other, 1, 6);
+  yrc_parse_free(other);
+  if (cache_two) {
+    yrc_cache_free(cache_two);
+  }
+  if (cache_one) {
+    yrc_cache_free(cache_one);
+  }
+  entries(one, &a, 1);
+  entries(two, &b, 1);
+  yrc_parse_free(expected);
+  return ok;
+}
+#endif
+
+/* a reader that fails at `fail_at`, and would carry on if asked again */
+typedef struct failing_s {
+  text_t text;
+  size_t fail_at;
+  int failed;
+  size_t calls_after;
+} failing_t;
+
+size_t readfailing(char* data, size_t desired, void* ctx) {
+  failing_t* failing = ctx;
+  size_t left = failing->fail_at - failing->text.pos;
+  if (failing->failed) {
+    ++failing->calls_after;
+    return readtext(data, desired, &failing->text);
+  }
+  if (left == 0) {
+    failing->failed = 1;
+    return 0;
+  }
+  return readtext(data, desired < left ? desired : left, &failing->text);
+}
+
+/* read until the first 0, which has to stick; SIZE_MAX if it doesn't */
+static size_t drain(yrc_readcb read, void* ctx, size_t desired, char* out, size_t cap) {
+  size_t size = 0;
+  size_t got;
+  size_t i;
+  while (size + desired <= cap && (got = read(out + size, desired, ctx)) > 0) {
+    size += got;
+  }
+  for (i = 0; i < 3; ++i) {
+    if (read(out + size, desired, ctx) != 0) {
+      return SIZE_MAX;
+    }
+  }
+  return size;
+}
+
+/* both parses fail with the same message, or both succeed with the same tree */
+static int same_parse(yrc_parse_request_t* lhs, yrc_parse_request_t* rhs) {
+  yrc_parse_response_t* left = NULL;
+  yrc_parse_response_t* right = NULL;
+  char lmsg[128];
+  char rmsg[128];
+  int ok = yrc_parse(lhs, &left) == yrc_parse(rhs, &right) && left && right;
+  if (ok && (left->error || right->error)) {
+    ok = left->error && right->error &&
+         yrc_error(left->error, lmsg, sizeof(lmsg)) == 0 &&
+         yrc_error(right->error, rmsg, sizeof(rmsg)) == 0 &&
+         strcmp(lmsg, rmsg) == 0;
+  } else if (ok) {
+    ok = same_json(left->root, right->root);
+  }
+  yrc_parse_free(left);
+  yrc_parse_free(right);
+  return ok;
+}
+
+/* prefetched reads hand back the wrapped reader's bytes, its eof and its errors */
+int prefetch(const char* filename) {
+  static const size_t chunks[] = {7, 4096};
+  static const size_t desires[] = {3, 16384};
+  FILE* inp = fopen(filename, "r");
+  yrc_prefetch_t* pf;
+  failing_t failing;
+  text_t text;
+  char* data;
+  char* out;
+  long size;
+  size_t i;
+  size_t j;
+  int ok = 1;
+  if (inp == NULL || fseek(inp, 0, SEEK_END) || (size = ftell(inp)) < 0) {
+    if (inp) {
+      fclose(inp);
+    }
+    return 0;
+  }
+  data = malloc(size + 1);
+  out = malloc(size + 16384);
+  rewind(inp);
+  ok = data && out && fread(data, 1, size, inp) == (size_t)size;
+
+  for (i = 0; ok && i < sizeof(chunks) / sizeof(chunks[0]); ++i) {
+    for (j = 0; ok && j < sizeof(desires) / sizeof(desires[0]); ++j) {
+      rewind(inp);
+      if (yrc_prefetch_init(&pf, readstdin, inp, chunks[i])) {
+        ok = 0;
+        break;
+      }
+      ok = drain(yrc_prefetch_read, pf, desires[j], out, size + 16384) == (size_t)size &&
+           memcmp(out, data, size) == 0;
+      yrc_prefetch_free(pf);
+    }
+  }
+
+  /* a failed read ends the stream there, and nothing more is read */
+  memset(&failing, 0, sizeof(failing));
+  failing.text.data = data;
+  failing.text.size = size;
+  failing.fail_at = size / 2;
+  ok = ok && yrc_prefetch_init(&pf, readfailing, &failing, 4096) == 0;
+  if (ok) {
+    ok = drain(yrc_prefetch_read, pf, 1000, out, size + 16384) == failing.fail_at &&
+         memcmp(out, data, failing.fail_at) == 0;
+    yrc_prefetch_free(pf);
+    ok = ok && failing.calls_after == 0;
+  }
+
+  /* and parses the same as input that stopped there */
+  memset(&failing, 0, sizeof(failing));
+  failing.text.data = data;
+  failing.text.size = size;
+  failing.fail_at = size / 2;
+  text.data = data;
+  text.size = size / 2;
+  text.pos = 0;
+  if (ok && yrc_prefetch_init(&pf, readfailing, &failing, 4096) == 0) {
+    yrc_parse_request_t wrapped = {
+      .read=yrc_prefetch_read,
+      .readsize=16384,
+      .readctx=pf
+    };
+    yrc_parse_request_t plain = {
+      .read=readtext,
+      .readsize=16384,
+      .readctx=&text
+    };
+    ok = same_parse(&wrapped, &plain);
+    yrc_prefetch_free(pf);
+  } else {
+    ok = 0;
+  }
+
+  /* freed before it's read from, with the thread waiting on a full buffer */
+  rewind(inp);
+  if (ok && yrc_prefetch_init(&pf, readstdin, inp, 7) == 0) {
+    yrc_prefetch_free(pf);
+  } else {
+    ok = 0;
+  }
+  fclose(inp);
+  free(data);
+  free(out);
+  return ok;
+}
+
 int main(int argc, const char** argv) {
   FILE* inp = NULL;
   const char* filename;
   if (argc < 2) {
-    filename = "/Users/chris/projects/personal/yrc/corpus/jquery.js";
-  } else {
-    filename = argv[1];
+    printf("usage: %s <file.js>\n", argv[0]);
+    return 1;
   }
+  filename = argv[1];
 
   inp = fopen(filename, "r");
   if (inp == NULL) {
-    printf("could not open %s\n", argv[1]);
+    printf("could not open %s\n", filename);
     return 1;
   }
   yrc_parse_request_t req = {
@@ -74,6 +1336,65 @@ int main(int argc, const char** argv) {
   if (yrc_parse(&req, &resp)) {
     printf("bad exit\n");
   } else {
+    if (!roundtrip(resp)) {
+      printf("bad roundtrip\n");
+    }
+    if (!reparse()) {
+      printf("bad reparse\n");
+    }
+    if (!json()) {
+      printf("bad json\n");
+    }
+    if (!codegen()) {
+      printf("bad codegen\n");
+    }
+    if (!sourcemap()) {
+      printf("bad sourcemap\n");
+    }
+    if (!dependencies()) {
+      printf("bad dependencies\n");
+    }
+    if (!validate(filename)) {
+      printf("bad validate\n");
+    }
+    if (!feed()) {
+      printf("bad feed\n");
+    }
+    if (!budget()) {
+      printf("bad budget\n");
+    }
+    if (!traverse_parallel(resp->root)) {
+      printf("bad traverse_parallel\n");
+    }
+    if (!tokenize_parallel()) {
+      printf("bad tokenize_parallel\n");
+    }
+    if (!positions()) {
+      printf("bad positions\n");
+    }
+    if (!unicode()) {
+      printf("bad unicode\n");
+    }
+    if (!string_values()) {
+      printf("bad string_values\n");
+    }
+    if (!traverse()) {
+      printf("bad traverse\n");
+    }
+    if (!pool_alignment()) {
+      printf("bad pool_alignment\n");
+    }
+    if (!stream_release()) {
+      printf("bad stream_release\n");
+    }
+    if (!prefetch(filename)) {
+      printf("bad prefetch\n");
+    }
+#ifndef _WIN32
+    if (!cache()) {
+      printf("bad cache\n");
+    }
+#endif
     yrc_parse_free(resp);
   }
   fclose(inp);
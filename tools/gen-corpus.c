@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/**
+  deterministic generator for large javascript inputs, used to find the
+  places where parse time or memory stops scaling linearly with input.
+  the same shape, size and seed always produce the same bytes.
+
+  usage: gen-corpus --shape SHAPE --size N[k|m] [--seed N] [--depth N] [-o FILE]
+
+  shapes:
+    nesting    nested blocks, parens and array literals, --depth levels deep
+    comma      a single statement made of one long comma sequence
+    array      a single huge array literal
+    strings    long string literals and block comments
+    functions  many small function declarations and calls
+    minified   mixed statements on one line with no optional whitespace
+
+  output goes to stdout unless -o is given. the output is at least
+  --size bytes; generation stops at the end of the statement or element
+  that crosses it.
+**/
+
+typedef struct gen_s {
+  FILE* out;
+  size_t size;
+  size_t written;
+  size_t depth;
+  uint64_t rng;
+} gen_t;
+
+typedef void (*gen_shape_cb)(gen_t*);
+
+/* spelled out in halves to stay clear of C90's lack of long long literals */
+#define U64(HI, LO) (((uint64_t)(HI) << 32) | (uint64_t)(LO))
+
+static uint64_t next(gen_t* gen) {
+  /* xorshift64* -- stable across platforms, unlike rand() */
+  gen->rng ^= gen->rng >> 12;
+  gen->rng ^= gen->rng << 25;
+  gen->rng ^= gen->rng >> 27;
+  return gen->rng * U64(0x2545F491, 0x4F6CDD1D);
+}
+
+static size_t pick(gen_t* gen, size_t n) {
+  return (size_t)((next(gen) >> 32) % n);
+}
+
+static void emit(gen_t* gen, const char* str) {
+  size_t len = strlen(str);
+  fwrite(str, 1, len, gen->out);
+  gen->written += len;
+}
+
+static void emitf(gen_t* gen, const char* fmt, size_t value) {
+  char buf[64];
+  int len = snprintf(buf, sizeof(buf), fmt, (unsigned long)value);
+  fwrite(buf, 1, len, gen->out);
+  gen->written += len;
+}
+
+static void emit_repeat(gen_t* gen, char ch, size_t count) {
+  char buf[4096];
+  size_t chunk;
+  memset(buf, ch, sizeof(buf));
+  while (count) {
+    chunk = count < sizeof(buf) ? count : sizeof(buf);
+    fwrite(buf, 1, chunk, gen->out);
+    gen->written += chunk;
+    count -= chunk;
+  }
+}
+
+static int done(gen_t* gen) {
+  return gen->written >= gen->size;
+}
+
+static void emit_value(gen_t* gen) {
+  switch (pick(gen, 4)) {
+    case 0: emitf(gen, "%lu", pick(gen, 100000)); break;
+    case 1: emitf(gen, "\"s%lu\"", pick(gen, 1000)); break;
+    case 2: emitf(gen, "v%lu", pick(gen, 64)); break;
+    default: emitf(gen, "%lu.5", pick(gen, 1000)); break;
+  }
+}
+
+static void shape_nesting(gen_t* gen) {
+  size_t i;
+  size_t kind;
+  while (!done(gen)) {
+    kind = pick(gen, 3);
+    switch (kind) {
+      case 0:
+        for (i = 0; i < gen->depth; ++i) {
+          emitf(gen, "if (v%lu) {\n", i & 63);
+        }
+        emit(gen, "v0 = 1;\n");
+        for (i = 0; i < gen->depth; ++i) {
+          emit(gen, "}\n");
+        }
+        break;
+      case 1:
+        emit(gen, "v0 = ");
+        emit_repeat(gen, '(', gen->depth);
+        emit_value(gen);
+        emit_repeat(gen, ')', gen->depth);
+        emit(gen, ";\n");
+        break;
+      default:
+        emit(gen, "v1 = ");
+        emit_repeat(gen, '[', gen->depth);
+        emit_value(gen);
+        emit_repeat(gen, ']', gen->depth);
+        emit(gen, ";\n");
+        break;
+    }
+  }
+}
+
+static void shape_comma(gen_t* gen) {
+  emit(gen, "v0 = 0");
+  while (!done(gen)) {
+    emit(gen, ", ");
+    emit_value(gen);
+  }
+  emit(gen, ";\n");
+}
+
+static void shape_array(gen_t* gen) {
+  emit(gen, "var data = [");
+  emit_value(gen);
+  while (!done(gen)) {
+    emit(gen, pick(gen, 8) ? ", " : ",\n  ");
+    emit_value(gen);
+  }
+  emit(gen, "];\n");
+}
+
+static void shape_strings(gen_t* gen) {
+  size_t len;
+  while (!done(gen)) {
+    /* lengths straddle the read chunk size and the intern limit */
+    len = (size_t)1 << (4 + pick(gen, 14));
+    len += pick(gen, len);
+    if (len > gen->size / 4 + 16) {
+      len = gen->size / 4 + 16;
+    }
+    if (pick(gen, 2)) {
+      emit(gen, "/* ");
+      emit_repeat(gen, 'c', len);
+      emit(gen, " */\n");
+    } else {
+      emit(gen, "var s = \"");
+      emit_repeat(gen, 's', len);
+      emit(gen, "\";\n");
+    }
+  }
+}
+
+static void shape_functions(gen_t* gen) {
+  size_t n = 0;
+  while (!done(gen)) {
+    emitf(gen, "function f%lu(a, b) {\n", n);
+    emitf(gen, "  var c = a + b * %lu;\n", pick(gen, 100));
+    emit(gen, "  return c;\n}\n");
+    if (n) {
+      emitf(gen, "f%lu(", pick(gen, n));
+      emit_value(gen);
+      emit(gen, ", ");
+      emit_value(gen);
+      emit(gen, ");\n");
+    }
+    ++n;
+  }
+}
+
+static void shape_minified(gen_t* gen) {
+  size_t n = 0;
+  while (!done(gen)) {
+    switch (pick(gen, 5)) {
+      case 0:
+        emitf(gen, "var v%lu=", n & 63);
+        emit_value(gen);
+        emit(gen, ";");
+        break;
+      case 1:
+        emitf(gen, "function g%lu(a,b){return a?b:", n);
+        emit_value(gen);
+        emit(gen, "}");
+        break;
+      case 2:
+        emitf(gen, "if(v%lu){v0=v1+", n & 63);
+        emit_value(gen);
+        emit(gen, "}else{v1=[v0,v2]}");
+        break;
+      case 3:
+        emit(gen, "for(var i=0;i<10;++i){v2={a:i,b:v1[i]}}");
+        break;
+      default:
+        emitf(gen, "v%lu=v1.x(", n & 63);
+        emit_value(gen);
+        emit(gen, ");");
+        break;
+    }
+    ++n;
+  }
+  emit(gen, "\n");
+}
+
+static const struct {
+  const char* name;
+  gen_shape_cb fn;
+} SHAPES[] = {
+  {"nesting", shape_nesting},
+  {"comma", shape_comma},
+  {"array", shape_array},
+  {"strings", shape_strings},
+  {"functions", shape_functions},
+  {"minified", shape_minified}
+};
+
+static size_t parse_size(const char* str) {
+  char* end;
+  size_t size = strtoul(str, &end, 10);
+  switch (*end) {
+    case 'k': case 'K': return size << 10;
+    case 'm': case 'M': return size << 20;
+    case 'g': case 'G': return size << 30;
+    default: return size;
+  }
+}
+
+static int usage(const char* name) {
+  size_t i;
+  fprintf(stderr,
+      "usage: %s --shape SHAPE --size N[k|m] [--seed N] [--depth N] [-o FILE]\n"
+      "shapes:", name);
+  for (i = 0; i < sizeof(SHAPES) / sizeof(SHAPES[0]); ++i) {
+    fprintf(stderr, " %s", SHAPES[i].name);
+  }
+  fprintf(stderr, "\n");
+  return 1;
+}
+
+int main(int argc, const char** argv) {
+  gen_shape_cb shape = NULL;
+  const char* output = NULL;
+  gen_t gen;
+  size_t i;
+  int arg;
+
+  gen.out = stdout;
+  gen.size = 1 << 20;
+  gen.written = 0;
+  gen.depth = 256;
+  gen.rng = U64(0x9E3779B9, 0x7F4A7C15);
+
+  for (arg = 1; arg < argc; ++arg) {
+    if (arg + 1 == argc) {
+      return usage(argv[0]);
+    }
+    if (strcmp(argv[arg], "--shape") == 0) {
+      ++arg;
+      for (i = 0; i < sizeof(SHAPES) / sizeof(SHAPES[0]); ++i) {
+        if (strcmp(argv[arg], SHAPES[i].name) == 0) {
+          shape = SHAPES[i].fn;
+        }
+      }
+      if (shape == NULL) {
+        return usage(argv[0]);
+      }
+    } else if (strcmp(argv[arg], "--size") == 0) {
+      gen.size = parse_size(argv[++arg]);
+    } else if (strcmp(argv[arg], "--seed") == 0) {
+      gen.rng = (uint64_t)strtoul(argv[++arg], NULL, 10) | 1;
+    } else if (strcmp(argv[arg], "--depth") == 0) {
+      gen.depth = strtoul(argv[++arg], NULL, 10);
+    } else if (strcmp(argv[arg], "-o") == 0) {
+      output = argv[++arg];
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (shape == NULL || gen.depth == 0) {
+    return usage(argv[0]);
+  }
+
+  if (output) {
+    gen.out = fopen(output, "wb");
+    if (gen.out == NULL) {
+      fprintf(stderr, "could not open %s\n", output);
+      return 1;
+    }
+  }
+  shape(&gen);
+  if (output && fclose(gen.out)) {
+    fprintf(stderr, "could not write %s\n", output);
+    return 1;
+  }
+  return 0;
+}
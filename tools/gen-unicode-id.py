@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""
+writes src/unicode-id.h: the non-ASCII code points in ID_Start and
+ID_Continue, from the Unicode database this python was built with.
+
+  usage: tools/gen-unicode-id.py > src/unicode-id.h
+
+ID_Start is the letters (L*) and letter numbers (Nl) plus Other_ID_Start;
+ID_Continue adds marks (Mn, Mc), digits (Nd), connectors (Pc) and
+Other_ID_Continue. both leave out Pattern_Syntax and Pattern_White_Space.
+the property lists below aren't in unicodedata, so they're copied from
+PropList.txt; check them when moving to a newer version.
+
+each table entry packs a run of code points as start << 11 | (length - 1),
+longer runs being split, sorted by start for a binary search.
+"""
+import sys
+import unicodedata
+
+OTHER_ID_START = [0x1885, 0x1886, 0x2118, 0x212E, 0x309B, 0x309C]
+OTHER_ID_CONTINUE = [0x00B7, 0x0387] + list(range(0x1369, 0x1372)) + [0x19DA]
+# the non-ASCII Pattern_Syntax code points that are letters or marks
+PATTERN_SYNTAX = [0x2E2F]
+
+START = ('Lu', 'Ll', 'Lt', 'Lm', 'Lo', 'Nl')
+CONTINUE = START + ('Mn', 'Mc', 'Nd', 'Pc')
+LENGTH_BITS = 11
+
+
+def collect(categories, others):
+    points = set(others)
+    for cp in range(0x80, 0x110000):
+        if unicodedata.category(chr(cp)) in categories:
+            points.add(cp)
+    return sorted(points - set(PATTERN_SYNTAX))
+
+
+def runs(points):
+    out = []
+    for cp in points:
+        if out and out[-1][1] == cp - 1 and out[-1][1] - out[-1][0] + 1 < (1 << LENGTH_BITS):
+            out[-1][1] = cp
+        else:
+            out.append([cp, cp])
+    return out
+
+
+def table(name, points):
+    entries = ['0x%08x' % (lo << LENGTH_BITS | (hi - lo)) for lo, hi in runs(points)]
+    lines = ['static const uint32_t %s[%d] = {' % (name, len(entries))]
+    for i in range(0, len(entries), 6):
+        lines.append('  ' + ', '.join(entries[i:i + 6]) + ',')
+    lines[-1] = lines[-1].rstrip(',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    start = collect(START, OTHER_ID_START)
+    cont = collect(CONTINUE, OTHER_ID_START + OTHER_ID_CONTINUE)
+    out = sys.stdout
+    out.write('/* generated by tools/gen-unicode-id.py from Unicode %s; do not edit */\n'
+              % unicodedata.unidata_version)
+    out.write('#ifndef _YRC_UNICODE_ID_H\n#define _YRC_UNICODE_ID_H\n\n')
+    out.write('#define YRC_ID_LENGTH_BITS %d\n\n' % LENGTH_BITS)
+    out.write(table('ID_START', start) + '\n\n')
+    out.write(table('ID_CONTINUE', cont) + '\n\n')
+    out.write('#endif\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -55,19 +55,43 @@
             'defines': [ '_DARWIN_USE_64_BIT_INODE=1' ],
           }],
           ['OS == "linux"', {
-            'defines': [ '_POSIX_C_SOURCE=200112' ],
+            'defines': [ '_POSIX_C_SOURCE=200809L' ],
+          }],
+          ['yrc_stats == 1', {
+            'defines': [ 'YRC_STATS' ],
           }],
         ],
       },
+      'conditions': [
+        ['yrc_stats == 1', {
+          'defines': [ 'YRC_STATS' ],
+        }],
+        ['yrc_pool_mmap == 1', {
+          'defines': [ 'YRC_POOL_MMAP' ],
+        }],
+      ],
       'sources': [
         'common.gypi',
         'include/yrc.h',
         'src/accumulator.c',
+        'src/cache.c',
+        'src/codegen.c',
+        'src/deps.c',
+        'src/feed.c',
+        'src/hash.c',
+        'src/json.c',
         'src/llist.c',
+        'src/output.c',
         'src/tokenizer.c',
+        'src/tokenize_parallel.c',
+        'src/unescape.c',
+        'src/utf8.c',
         'src/parser.c',
         'src/pool.c',
+        'src/prefetch.c',
+        'src/serialize.c',
         'src/traverse.c',
+        'src/traverse_parallel.c',
         'src/str.c',
       ]
     },
@@ -76,6 +100,7 @@
       'target_name': 'run-tests',
       'type': 'executable',
       'dependencies': [ 'yrc' ],
+      'include_dirs': [ 'src/' ],
       'sources': [
         'test/main.c',
       ],
@@ -84,6 +109,52 @@
           'SubSystem': 1, # /subsystem:console
         },
       },
+    },
+
+    {
+      'target_name': 'bench-long-comments',
+      'type': 'executable',
+      'dependencies': [ 'yrc' ],
+      'include_dirs': [ 'bench/' ],
+      'sources': [
+        'bench/alloc.c',
+        'bench/long-comments.c',
+      ],
+      'msvs-settings': {
+        'VCLinkerTool': {
+          'SubSystem': 1, # /subsystem:console
+        },
+      },
+    },
+
+    {
+      'target_name': 'yrc-bench',
+      'type': 'executable',
+      'dependencies': [ 'yrc' ],
+      'include_dirs': [ 'bench/', 'src/' ],
+      'sources': [
+        'bench/alloc.c',
+        'bench/counters.c',
+        'bench/main.c',
+      ],
+      'msvs-settings': {
+        'VCLinkerTool': {
+          'SubSystem': 1, # /subsystem:console
+        },
+      },
+    },
+
+    {
+      'target_name': 'gen-corpus',
+      'type': 'executable',
+      'sources': [
+        'tools/gen-corpus.c',
+      ],
+      'msvs-settings': {
+        'VCLinkerTool': {
+          'SubSystem': 1, # /subsystem:console
+        },
+      },
     }
   ]
 }